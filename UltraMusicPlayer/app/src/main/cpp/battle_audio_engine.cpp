@@ -15,7 +15,7 @@
  * - Speed range: 0.05x to 10.0x
  * - Pitch range: -36 to +36 semitones
  * - Battle-grade limiter (no clipping at extreme volumes)
- * - Punch compressor (cuts through in battles)
+ * - Multiband punch compressor (cuts through in battles)
  * - Sub-bass enhancement (shake the ground)
  *
  * Optimized for ARM NEON SIMD on Android devices.
@@ -32,6 +32,10 @@
 // =============================================================================
 
 #include "battle_audio_engine.h"
+#include "battle_chain.h"
+#include "battle_offline.h"
+#include "battle_realtime.h"
+#include "battle_vector_ops.h"
 #include "SoundTouch.h"  // SoundTouch engine (FREE, no license)
 
 // Superpowered SDK - always include for runtime selection
@@ -54,7 +58,14 @@ using RubberBand::RubberBandStretcher;
 #endif
 
 #include <cmath>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <android/log.h>
 
 #define LOG_TAG "BattleAudioEngine"
@@ -69,94 +80,274 @@ inline int semitonesToCents(float semitones) {
     return static_cast<int>(semitones * 100.0f);
 }
 
-// =============================================================================
-// BATTLE AUDIO ENGINE IMPLEMENTATION
-// Primary: SoundTouch (FREE) | Optional: Superpowered (requires license)
-// =============================================================================
-
-class BattleAudioEngineImpl {
-public:
-    BattleAudioEngineImpl() {
+// Block limits for the float core. Larger host buffers are processed in pieces;
+// output beyond kMaxOutputFrames stays queued inside the stretcher.
+// At slow speeds the pieces shrink so each one's output stays within
+// kMaxBlockOutputFrames (8192 frames at 0.05x would be 160k out), which the
+// next drain always empties - the queue never grows past the stretcher rings.
+constexpr int kMaxInputFrames = 8192;
+constexpr int kMaxOutputFrames = 32768;
+constexpr int kMaxBlockOutputFrames = kMaxOutputFrames / 2;  // Rest: one sequence of overshoot
+
+// While speed/pitch/rate are gliding, the stretchers get a new ratio every
+// kRampSubBlockFrames input frames. Settled blocks are processed whole.
+constexpr int kRampSubBlockFrames = 256;
+
+// Recent input kept for pre-rolling an engine we are switching to
+// (power of two; ~340ms at 48kHz - comfortably above every engine's start latency)
+constexpr int kHistoryFrames = 16384;
+
+// Extra input fed past an engine's reported start pad so its first real output is warm
+constexpr int kPrerollMarginFrames = 1024;
+
+// Channels the output true-peak meter reports (more are processed, not reported)
+constexpr int kMaxMeterChannels = 8;
+
+// Floor reported by the meter for silence
+constexpr float kMeterFloorDb = -120.0f;
+
+// Offline rendering (renderFile): stretcher block and pipeline chunk sizes.
+// Well above the real-time limits - there is no callback deadline to meet,
+// and bigger blocks mean fewer stretcher calls and queue handoffs.
+constexpr int kOfflineBlockFrames = 16384;
+constexpr int kOfflineChunkFrames = 16384;
+
+// Process-wide SDK setup. Runs once no matter how many engines (decks) exist;
+// Superpowered must not be re-initialized per instance.
+bool initializeSuperpoweredOnce() {
+    static std::once_flag once;
+    static bool available = false;
+    std::call_once(once, [] {
         // Initialize Superpowered SDK only if license is available
         if (HAS_SUPERPOWERED_LICENSE) {
             Superpowered::Initialize(SUPERPOWERED_LICENSE);
-            superpoweredAvailable = true;
-
-            // Create Superpowered time stretcher (highest quality mode)
-            timeStretcher = new Superpowered::TimeStretching(44100, 0.01f);
-            timeStretcher->sound = 2;  // Highest quality mode
-            timeStretcher->formantCorrection = 0.5f;
-            timeStretcher->rate = 1.0f;
-            timeStretcher->pitchShiftCents = 0;
-
-            // Create Superpowered effects for full utilization
-            spCompressor = new Superpowered::Compressor(44100);
-            spCompressor->enabled = true;
-            spCompressor->inputGainDb = 0;
-            spCompressor->outputGainDb = 0;
-            spCompressor->wet = 1.0f;
-            spCompressor->attackSec = 0.003f;
-            spCompressor->releaseSec = 0.3f;
-            spCompressor->ratio = 4.0f;
-            spCompressor->thresholdDb = -10.0f;
-            spCompressor->hpCutOffHz = 1;
-
-            spLimiter = new Superpowered::Limiter(44100);
-            spLimiter->enabled = true;
-            spLimiter->ceilingDb = -0.1f;
-            spLimiter->thresholdDb = -0.3f;
-            spLimiter->releaseSec = 0.1f;
-
-            spEQ = new Superpowered::ThreeBandEQ(44100);
-            spEQ->enabled = true;
-            spEQ->low = 1.0f;  // Will be adjusted by bass boost
-            spEQ->mid = 1.0f;
-            spEQ->high = 1.0f;
-
+            available = true;
             LOGI("Superpowered SDK initialized - DJ-grade effects ready!");
         } else {
             // No Superpowered license - use SoundTouch only
-            superpoweredAvailable = false;
-            timeStretcher = nullptr;
-            spCompressor = nullptr;
-            spLimiter = nullptr;
-            spEQ = nullptr;
             LOGI("No Superpowered license - using SoundTouch engine (still excellent quality!)");
         }
+    });
+    return available;
+}
 
-        // SoundTouch - OPTIMIZED SETTINGS for maximum quality (always available)
-        soundTouch = new soundtouch::SoundTouch();
-        soundTouch->setSetting(SETTING_USE_AA_FILTER, 1);        // Anti-alias filtering ON
-        soundTouch->setSetting(SETTING_AA_FILTER_LENGTH, 128);   // Longest filter for best quality
-        soundTouch->setSetting(SETTING_SEQUENCE_MS, 82);         // Optimal for music
-        soundTouch->setSetting(SETTING_SEEKWINDOW_MS, 28);       // Better seeking
-        soundTouch->setSetting(SETTING_OVERLAP_MS, 12);          // Smoother transitions
-
-        // Battle processing chain (used when engine is SoundTouch or as fallback)
-        limiter = new BattleLimiter();
-        compressor = new BattleCompressor();
-        bassBoost = new BattleBassBoost();
+#if USE_RUBBERBAND
+// Largest block handed to Rubberband in one process()/retrieve() call.
+// Bigger host buffers are split so the scratch arena never has to grow.
+constexpr int kMaxRubberbandBlockFrames = 4096;
+#endif
 
-        // Default engine is SoundTouch (user can switch at runtime)
-        currentEngine = AudioEngineType::SOUNDTOUCH;
+// =============================================================================
+// ENGINE PARAMS - User settings, published to the audio thread as one snapshot
+// Setters edit a copy on the control thread and publish it through a
+// TripleBuffer; the audio thread picks up the newest snapshot at block start.
+// =============================================================================
+
+struct EngineParams {
+    AudioEngineType engine = AudioEngineType::SOUNDTOUCH;
+
+    float speed = 1.0f;
+    float pitchSemitones = 0.0f;
+    float rate = 1.0f;
+    bool useRateMode = false;
+    bool formantPreservation = true;
+
+    bool battleMode = false;
+    bool limiterEnabled = true;  // FULL SEND toggle - when false, no limiting
+    float bassBoostAmount = 0.0f;
+    float subHarmonicAmount = 0.0f;
+    float exciterAmount = 0.0f;
+    float megaBassIntensity = 0.0f;       // MegaBass, ahead of the fused chain
+    float parallelCompressionMix = 0.0f;  // New York compression, ahead of the fused chain
+    float limiterThresholdDb = -0.3f;
+    float compressorRatio = 4.0f;
+
+    // 10-band EQ (battle mode), flat by default
+    bool equalizerEnabled = true;
+    float eqBandGainsDb[ParametricEqualizer::kBands] = {};
+
+    // Hardware Protection (strongest safety)
+    bool hardwareProtection = true;     // Default ON - protect speakers
+    float hardLimiterCeiling = 0.944f;  // -0.5dB hard ceiling
+    bool subBassFilterEnabled = true;   // Remove <20Hz rumble
+    bool dcBlockerEnabled = true;       // Remove DC offset
+
+    // Audiophile Mode (pure quality)
+    bool audiophileMode = false;  // Default OFF - battle ready
+    bool clarityEnhanceEnabled = false;
+    float clarityAmount = 0.0f;
+    bool ditheringEnabled = false;
+    DitherMode ditherMode = DitherMode::NOISE_SHAPED;  // Used while dithering is on
+
+    // Engine switching: equal-power crossfade length (0 = hard cut, clears buffers)
+    float engineCrossfadeMs = 50.0f;
+
+    // Latency compensation: trim the start delay so output frame n is input frame n
+    bool latencyCompensation = false;
+};
+
+// =============================================================================
+// ENGINE GRAPH - Everything that depends on sample rate and channel count
+// Built off the audio thread by configure(), swapped in with one atomic store,
+// and retired through the Scavenger once no audio block can still be using it.
+// =============================================================================
+
+struct EngineGraph {
+    EngineGraph() = default;
+    EngineGraph(const EngineGraph&) = delete;
+    EngineGraph& operator=(const EngineGraph&) = delete;
+
+    ~EngineGraph() {
+        // Clean up Superpowered
+        if (timeStretcher) delete timeStretcher;
+        if (spCompressor) delete spCompressor;
+        if (spLimiter) delete spLimiter;
+        if (spEQ) delete spEQ;
+
+#if USE_RUBBERBAND
+        // Clean up Rubberband
+        if (rubberbandStretcher) delete rubberbandStretcher;
+#endif
+
+        // Clean up SoundTouch
+        delete soundTouch;
+    }
+
+    int sampleRate = 44100;
+    int channels = 2;
+
+    // Settings this graph currently reflects (audio thread only after publish)
+    EngineParams applied;
+
+    // Stretch ratios as the stretchers currently see them (glide toward applied)
+    LinearRamp speedRamp{ 1.0f };
+    LinearRamp pitchRamp{ 0.0f };  // semitones
+    LinearRamp rateRamp{ 1.0f };
+
+    // Superpowered SDK components (DJ-grade processing)
+    Superpowered::TimeStretching* timeStretcher = nullptr;
+    Superpowered::Compressor* spCompressor = nullptr;
+    Superpowered::Limiter* spLimiter = nullptr;
+    Superpowered::ThreeBandEQ* spEQ = nullptr;
+
+#if USE_RUBBERBAND
+    // Rubberband engine (Studio-grade, 10/10 quality)
+    RubberBandStretcher* rubberbandStretcher = nullptr;
+    double rubberbandTimeRatio = 0.0;
+    double rubberbandPitchScale = 0.0;
+
+    // Rubberband scratch: planar in/out blocks carved from one arena at build time
+    ScratchArena rubberbandScratch;
+    std::vector<float*> rubberbandIn;
+    std::vector<float*> rubberbandOut;
+    int rubberbandBlockFrames = 0;
+#endif
+
+    // SoundTouch engine (FREE, no license)
+    soundtouch::SoundTouch* soundTouch = nullptr;
+
+    // Battle processing chain (used by SoundTouch and Rubberband engines)
+    BattleLimiter limiter;
+    MultibandCompressor compressor;
+    BattleBassBoost bassBoost;
+    ParametricEqualizer equalizer;
+
+    // Speaker protection (DC blocker + sub-sonic filter) on the final output;
+    // the ceiling is applied by the output conversion
+    HardwareProtection protection;
+
+    // True-peak meter on the final output
+    TruePeakDetector outputMeter;
+
+    // int16 output dither (noise streams + noise-shaping history)
+    DitherState dither;
+
+    // Psychoacoustic bass enhancement (no gain, perceived loudness)
+    SubHarmonicSynthesizer subHarmonicL;
+    SubHarmonicSynthesizer subHarmonicR;
+    BassExciter exciterL;
+    BassExciter exciterR;
+
+    // Extra battle processors (per engine, so instances never share state)
+    ParallelCompressor parallelCompressor;
+    MegaBass megaBass;
+
+    // Fused kernel view of the chain + the specializations currently selected
+    BattleChain chain;
+    BattleChainFn chainKernel = nullptr;
+    BattleChainFn psychoacousticKernel = nullptr;
+    unsigned chainStages = 0;
+
+    // Buffers for audio processing (float edges of the int16/planar APIs)
+    std::vector<float> floatInputBuffer;
+    std::vector<float> floatOutputBuffer;
+    std::vector<const float*> planarInPtrs;
+    std::vector<float*> planarOutPtrs;
+
+    // Hot engine switching: ring of recent input (pre-roll source) and the
+    // incoming engine's output while both engines run during the crossfade
+    std::vector<float> inputHistory;
+    int historyWrite = 0;   // next frame slot
+    int historyFilled = 0;  // valid frames (<= kHistoryFrames)
+    std::vector<float> crossfadeBuffer;
+
+    bool crossfading = false;
+    AudioEngineType crossfadeFrom = AudioEngineType::SOUNDTOUCH;  // outgoing engine
+    int crossfadeFrames = 0;
+    int crossfadePosition = 0;
+
+    // Latency compensation: leading output frames still to drop (pure delay)
+    int compensationTrim = 0;
+
+    // Superpowered reports no delay, so it is counted: output time fed in
+    // (input frames / rate) minus output frames taken out
+    double superpoweredBacklog = 0.0;
+};
+
+// =============================================================================
+// OFFLINE CONTEXT - What an offline render keeps from one job to the next
+// One per render thread. The graph (chain processors and their buffers) and the
+// block buffers are rebuilt only when the file format changes. The offline
+// Rubberband stretcher is not pooled: its reset() keeps the previous study
+// pass's stretch profile in offline mode, so every job gets a fresh one.
+// =============================================================================
+
+struct OfflineContext {
+    std::unique_ptr<EngineGraph> graph;
+    std::vector<float> block;           // Interleaved file block
+    std::vector<float> planeStorage;    // Planar in/out blocks (Rubberband)
+    std::vector<float*> inPlanes;
+    std::vector<float*> outPlanes;
+};
+
+// =============================================================================
+// BATTLE AUDIO ENGINE IMPLEMENTATION
+// Primary: SoundTouch (FREE) | Optional: Superpowered (requires license)
+//
+// Threading: setters and configure() run on control threads and never touch
+// the live graph. process*() runs on the audio thread and owns the graph it
+// loaded for the duration of the block.
+// =============================================================================
+
+class BattleAudioEngineImpl {
+public:
+    BattleAudioEngineImpl() : graphScavenger(audioEpoch) {
+        // Every engine instance is independent; only the SDK init is shared
+        superpoweredAvailable = initializeSuperpoweredOnce();
 
 #if USE_RUBBERBAND
-        // Initialize Rubberband (studio-grade time-stretching)
-        // Using highest quality options for maximum fidelity
-        rubberbandStretcher = new RubberBandStretcher(
-            44100, 2,
-            RubberBandStretcher::OptionProcessRealTime |
-            RubberBandStretcher::OptionPitchHighQuality |
-            RubberBandStretcher::OptionStretchPrecise |
-            RubberBandStretcher::OptionTransientsCrisp |
-            RubberBandStretcher::OptionChannelsTogether
-        );
         rubberbandAvailable = true;
         LOGI("Rubberband initialized - Studio-grade quality ready!");
 #else
         rubberbandAvailable = false;
 #endif
 
+        // Default engine is SoundTouch (user can switch at runtime)
+        publishParams();
+        EngineGraph* initial = buildGraph(44100, 2, pendingParams);
+        latencyFrames.store(outputLatencyFrames(*initial), std::memory_order_relaxed);
+        graph.store(initial, std::memory_order_release);
+
         LOGI("BattleAudioEngine v3.0 - MULTI-ENGINE READY!");
         if (superpoweredAvailable) {
 #if USE_RUBBERBAND
@@ -175,27 +366,14 @@ public:
     }
 
     ~BattleAudioEngineImpl() {
-        // Clean up Superpowered
-        if (timeStretcher) delete timeStretcher;
-        if (spCompressor) delete spCompressor;
-        if (spLimiter) delete spLimiter;
-        if (spEQ) delete spEQ;
-
-#if USE_RUBBERBAND
-        // Clean up Rubberband
-        if (rubberbandStretcher) delete rubberbandStretcher;
-#endif
-
-        // Clean up SoundTouch and battle processing
-        delete soundTouch;
-        delete limiter;
-        delete compressor;
-        delete bassBoost;
+        // The audio thread must be stopped before the engine is destroyed
+        delete graph.exchange(nullptr, std::memory_order_acq_rel);
     }
 
     // Set audio engine at runtime with smart fallback
     void setAudioEngine(AudioEngineType engine) {
-        if (engine == currentEngine) return;
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        if (engine == pendingParams.engine) return;
 
         // Smart fallback chain: Requested → Next Best → SoundTouch (always available)
         AudioEngineType requestedEngine = engine;
@@ -224,12 +402,6 @@ public:
             }
         }
 
-        AudioEngineType previousEngine = currentEngine;
-        currentEngine = engine;
-
-        // Clear buffers when switching engines
-        clear();
-
         switch (engine) {
             case AudioEngineType::SOUNDTOUCH:
                 LOGI("Engine: SOUNDTOUCH (8.5/10 quality) - Always available, no license needed");
@@ -239,15 +411,10 @@ public:
                 break;
             case AudioEngineType::RUBBERBAND:
 #if USE_RUBBERBAND
-                // Update Rubberband parameters
-                if (rubberbandStretcher) {
-                    rubberbandStretcher->setTimeRatio(1.0 / speed);
-                    rubberbandStretcher->setPitchScale(std::pow(2.0, pitchSemitones / 12.0));
-                }
                 LOGI("Engine: RUBBERBAND (10/10 quality) - Studio-grade, best for music");
 #else
                 LOGW("Rubberband not compiled! Using SoundTouch.");
-                currentEngine = AudioEngineType::SOUNDTOUCH;
+                engine = AudioEngineType::SOUNDTOUCH;
 #endif
                 break;
         }
@@ -260,144 +427,82 @@ public:
                  engine == AudioEngineType::SOUNDTOUCH ? "SoundTouch" :
                  engine == AudioEngineType::SUPERPOWERED ? "Superpowered" : "Rubberband");
         }
+
+        // The audio thread switches at its next block: crossfaded from the running
+        // engine, or (crossfade off) a hard cut that clears every buffer
+        pendingParams.engine = engine;
+        publishParams();
+        if (pendingParams.engineCrossfadeMs <= 0.0f) {
+            clearRequested.store(true, std::memory_order_release);
+        }
     }
 
     AudioEngineType getAudioEngine() const {
-        return currentEngine;
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        return pendingParams.engine;
     }
 
+    // Build a complete graph for the new format off the audio thread, then swap it in
     void configure(int sampleRate, int channels) {
-        this->sampleRate = sampleRate;
-        this->channels = channels;
-
-        // Configure Superpowered (only if license available)
-        if (superpoweredAvailable) {
-            // Configure Superpowered time stretcher
-            if (timeStretcher) delete timeStretcher;
-            timeStretcher = new Superpowered::TimeStretching(sampleRate, 0.01f);
-            timeStretcher->sound = 2;  // Highest quality
-            timeStretcher->formantCorrection = formantPreservation ? 0.7f : 0.0f;
-
-            // Configure Superpowered effects
-            if (spCompressor) {
-                delete spCompressor;
-                spCompressor = new Superpowered::Compressor(sampleRate);
-                spCompressor->enabled = battleMode;
-                spCompressor->attackSec = 0.003f;
-                spCompressor->releaseSec = 0.3f;
-                spCompressor->ratio = 4.0f;
-                spCompressor->thresholdDb = -10.0f;
-            }
-            if (spLimiter) {
-                delete spLimiter;
-                spLimiter = new Superpowered::Limiter(sampleRate);
-                spLimiter->enabled = limiterEnabled;
-                spLimiter->ceilingDb = -0.1f;
-                spLimiter->thresholdDb = -0.3f;
-            }
-            if (spEQ) {
-                delete spEQ;
-                spEQ = new Superpowered::ThreeBandEQ(sampleRate);
-                spEQ->enabled = (bassBoostAmount > 0);
-            }
-        }
-
-        // Configure SoundTouch
-        soundTouch->setSampleRate(sampleRate);
-        soundTouch->setChannels(channels);
-        updateSoundTouch();
-
-        // Configure battle processing (for SoundTouch engine)
-        limiter->configure(sampleRate, channels);
-        compressor->configure(sampleRate, channels);
-        bassBoost->configure(sampleRate, channels);
-
-#if USE_RUBBERBAND
-        // Configure Rubberband (studio-grade time-stretching)
-        if (rubberbandStretcher) delete rubberbandStretcher;
-        rubberbandStretcher = new RubberBandStretcher(
-            sampleRate, channels,
-            RubberBandStretcher::OptionProcessRealTime |
-            RubberBandStretcher::OptionPitchHighQuality |
-            RubberBandStretcher::OptionStretchPrecise |
-            RubberBandStretcher::OptionTransientsCrisp |
-            RubberBandStretcher::OptionChannelsTogether
-        );
-        // Set initial parameters
-        rubberbandStretcher->setTimeRatio(1.0 / speed);
-        rubberbandStretcher->setPitchScale(std::pow(2.0, pitchSemitones / 12.0));
-#endif
-
-        // Configure psychoacoustic bass enhancement
-        subHarmonicL.configure(sampleRate);
-        subHarmonicR.configure(sampleRate);
-        exciterL.configure(sampleRate);
-        exciterR.configure(sampleRate);
+        std::lock_guard<std::mutex> lock(paramsMutex);
 
-        // Allocate buffers
-        floatInputBuffer.resize(8192 * channels);
-        floatOutputBuffer.resize(32768 * channels);
+        EngineGraph* fresh = buildGraph(sampleRate, channels, pendingParams);
+        latencyFrames.store(outputLatencyFrames(*fresh), std::memory_order_relaxed);
+        // seq_cst pairs with the epoch: a block that still sees the old graph is visible to retire()
+        EngineGraph* old = graph.exchange(fresh, std::memory_order_seq_cst);
+        graphScavenger.retire(old);
 
         LOGI("Configured: %dHz, %d channels, Engine: %s", sampleRate, channels,
-             currentEngine == AudioEngineType::SOUNDTOUCH ? "SoundTouch" :
-             currentEngine == AudioEngineType::SUPERPOWERED ? "Superpowered" : "Rubberband");
+             pendingParams.engine == AudioEngineType::SOUNDTOUCH ? "SoundTouch" :
+             pendingParams.engine == AudioEngineType::SUPERPOWERED ? "Superpowered" : "Rubberband");
     }
 
     // Speed: 0.05x to 10.0x (tempo change without pitch change)
     void setSpeed(float newSpeed) {
-        this->speed = std::clamp(newSpeed, 0.05f, 10.0f);
-        updateSoundTouch();
-        LOGI("Speed set to: %.2fx", this->speed);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.speed = std::clamp(newSpeed, 0.05f, 10.0f);
+        publishParams();
+        LOGI("Speed set to: %.2fx", pendingParams.speed);
     }
 
     // Pitch: -36 to +36 semitones (pitch change without tempo change)
     void setPitch(float semitones) {
-        this->pitchSemitones = std::clamp(semitones, -36.0f, 36.0f);
-        updateSoundTouch();
-        LOGI("Pitch set to: %.1f semitones", this->pitchSemitones);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.pitchSemitones = std::clamp(semitones, -36.0f, 36.0f);
+        publishParams();
+        LOGI("Pitch set to: %.1f semitones", pendingParams.pitchSemitones);
     }
 
     // Rate: Changes both speed AND pitch together (like vinyl speed change)
     void setRate(float newRate) {
-        this->rate = std::clamp(newRate, 0.05f, 10.0f);
-        useRateMode = true;
-        updateSoundTouch();
-        LOGI("Rate set to: %.2fx (vinyl mode)", this->rate);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.rate = std::clamp(newRate, 0.05f, 10.0f);
+        pendingParams.useRateMode = true;
+        publishParams();
+        LOGI("Rate set to: %.2fx (vinyl mode)", pendingParams.rate);
     }
 
     // Formant preservation
     void setFormantPreservation(bool enabled) {
-        this->formantPreservation = enabled;
-        if (timeStretcher) {
-            timeStretcher->formantCorrection = enabled ? 0.7f : 0.0f;
-        }
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.formantPreservation = enabled;
+        publishParams();
         LOGI("Formant preservation: %s", enabled ? "ON" : "OFF");
     }
 
     // Battle mode settings
     void setBattleMode(bool enabled) {
-        this->battleMode = enabled;
-
-        // Update SoundTouch battle processing
-        limiter->setEnabled(enabled && limiterEnabled);
-        compressor->setEnabled(enabled);
-
-        // Update Superpowered effects
-        if (spCompressor) spCompressor->enabled = enabled;
-        if (spLimiter) spLimiter->enabled = enabled && limiterEnabled;
-
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.battleMode = enabled;
+        publishParams();
         LOGI("Battle mode: %s", enabled ? "ENGAGED - Maximum Power!" : "OFF");
     }
 
     // Limiter toggle (FULL SEND mode)
     void setLimiterEnabled(bool enabled) {
-        this->limiterEnabled = enabled;
-
-        // Update SoundTouch limiter
-        limiter->setEnabled(enabled);
-
-        // Update Superpowered limiter
-        if (spLimiter) spLimiter->enabled = enabled;
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.limiterEnabled = enabled;
+        publishParams();
 
         if (enabled) {
             LOGI("Limiter: ON (clipping protection active)");
@@ -408,559 +513,1661 @@ public:
 
     // Hardware Protection - STRONGEST safety, protects speakers
     void setHardwareProtection(bool enabled) {
-        this->hardwareProtection = enabled;
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.hardwareProtection = enabled;
 
         if (enabled) {
             // Hard ceiling at -0.5dB
-            hardLimiterCeiling = 0.944f;  // -0.5dB = 10^(-0.5/20)
+            pendingParams.hardLimiterCeiling = 0.944f;  // -0.5dB = 10^(-0.5/20)
             // Enable sub-bass filter to remove <20Hz rumble
-            subBassFilterEnabled = true;
+            pendingParams.subBassFilterEnabled = true;
             // Enable DC offset removal
-            dcBlockerEnabled = true;
+            pendingParams.dcBlockerEnabled = true;
             LOGI("Hardware Protection: ON - Speaker protection active");
         } else {
-            hardLimiterCeiling = 1.0f;
-            subBassFilterEnabled = false;
-            dcBlockerEnabled = false;
+            pendingParams.hardLimiterCeiling = 1.0f;
+            pendingParams.subBassFilterEnabled = false;
+            pendingParams.dcBlockerEnabled = false;
             LOGW("Hardware Protection: OFF - WARNING: Speaker damage possible!");
         }
+
+        publishParams();
     }
 
     // Audiophile Mode - Cleanest, most pleasant audio
     void setAudiophileMode(bool enabled) {
-        this->audiophileMode = enabled;
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.audiophileMode = enabled;
 
         if (enabled) {
-            // Disable battle processing for transparent audio
-            compressor->setEnabled(false);
-            if (spCompressor) spCompressor->enabled = false;
-
-            // Disable sub-harmonic and exciter (no artificial coloring)
-            subHarmonicAmount = 0.0f;
-            exciterAmount = 0.0f;
-            subHarmonicL.setAmount(0.0f);
-            subHarmonicR.setAmount(0.0f);
-            exciterL.setAmount(0.0f);
-            exciterR.setAmount(0.0f);
+            // Disable sub-harmonic and exciter (no artificial coloring);
+            // the compressor is bypassed while audiophile mode is on
+            pendingParams.subHarmonicAmount = 0.0f;
+            pendingParams.exciterAmount = 0.0f;
+            pendingParams.megaBassIntensity = 0.0f;
 
             // Enable subtle clarity enhancement
-            clarityEnhanceEnabled = true;
-            clarityAmount = 0.2f;  // Subtle, not aggressive
+            pendingParams.clarityEnhanceEnabled = true;
+            pendingParams.clarityAmount = 0.2f;  // Subtle, not aggressive
 
             // Enable dithering for cleaner output
-            ditheringEnabled = true;
+            pendingParams.ditheringEnabled = true;
 
             LOGI("Audiophile Mode: ON - Pure, clean audio quality");
         } else {
-            // Restore battle processing if battleMode is active
-            compressor->setEnabled(battleMode);
-            if (spCompressor) spCompressor->enabled = battleMode;
-
-            clarityEnhanceEnabled = false;
-            ditheringEnabled = false;
+            pendingParams.clarityEnhanceEnabled = false;
+            pendingParams.ditheringEnabled = false;
 
             LOGI("Audiophile Mode: OFF - Battle ready");
         }
+
+        publishParams();
     }
 
     void setBassBoost(float amount) {
-        this->bassBoostAmount = std::clamp(amount, 0.0f, 24.0f);
-
-        // Update SoundTouch bass boost
-        bassBoost->setGain(this->bassBoostAmount);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.bassBoostAmount = std::clamp(amount, 0.0f, 24.0f);
+        publishParams();
+        LOGI("Bass boost: %.1f dB", pendingParams.bassBoostAmount);
+    }
 
-        // Update Superpowered 3-band EQ for bass boost
-        if (spEQ) {
-            spEQ->enabled = (bassBoostAmount > 0);
-            // Convert dB to linear gain: 10^(dB/20)
-            // For EQ low band: 1.0 = unity, 2.0 = +6dB, 4.0 = +12dB
-            float linearGain = std::pow(10.0f, bassBoostAmount / 20.0f);
-            spEQ->low = linearGain;
-        }
+    // 10-band EQ (battle mode) - bands at ParametricEqualizer::getBandFrequency()
+    void setEqEnabled(bool enabled) {
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.equalizerEnabled = enabled;
+        publishParams();
+        LOGI("EQ: %s", enabled ? "ON" : "OFF");
+    }
 
-        LOGI("Bass boost: %.1f dB", this->bassBoostAmount);
+    void setEqBand(int band, float gainDb) {
+        if (band < 0 || band >= ParametricEqualizer::kBands) return;
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.eqBandGainsDb[band] = std::clamp(gainDb, -ParametricEqualizer::kMaxGainDb,
+                                                       ParametricEqualizer::kMaxGainDb);
+        publishParams();
+        LOGI("EQ band %d (%.0f Hz): %.1f dB", band, ParametricEqualizer::getBandFrequency(band),
+             pendingParams.eqBandGainsDb[band]);
     }
 
     // Psychoacoustic bass enhancement - no gain, perceived loudness
     void setSubHarmonicAmount(float amount) {
-        subHarmonicAmount = std::clamp(amount, 0.0f, 1.0f);
-        subHarmonicL.setAmount(subHarmonicAmount);
-        subHarmonicR.setAmount(subHarmonicAmount);
-        LOGI("Sub-harmonic amount: %.2f", subHarmonicAmount);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.subHarmonicAmount = std::clamp(amount, 0.0f, 1.0f);
+        publishParams();
+        LOGI("Sub-harmonic amount: %.2f", pendingParams.subHarmonicAmount);
     }
 
     void setExciterAmount(float amount) {
-        exciterAmount = std::clamp(amount, 0.0f, 1.0f);
-        exciterL.setAmount(exciterAmount);
-        exciterR.setAmount(exciterAmount);
-        LOGI("Exciter amount: %.2f", exciterAmount);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.exciterAmount = std::clamp(amount, 0.0f, 1.0f);
+        publishParams();
+        LOGI("Exciter amount: %.2f", pendingParams.exciterAmount);
+    }
+
+    // Sub-harmonics + exciter on every channel in one control (battle mode)
+    void setMegaBassIntensity(float intensity) {
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.megaBassIntensity = std::clamp(intensity, 0.0f, 1.0f);
+        publishParams();
+        LOGI("Mega bass: %.2f", pendingParams.megaBassIntensity);
+    }
+
+    // Heavily compressed copy blended under the dry signal (battle mode)
+    void setParallelCompressionMix(float mix) {
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.parallelCompressionMix = std::clamp(mix, 0.0f, 1.0f);
+        publishParams();
+        LOGI("Parallel compression mix: %.2f", pendingParams.parallelCompressionMix);
     }
 
     void setLimiterThreshold(float thresholdDb) {
-        limiter->setThreshold(thresholdDb);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.limiterThresholdDb = thresholdDb;
+        publishParams();
+    }
+
+    // Engine switch crossfade length; 0 restores the old hard cut
+    void setEngineCrossfade(float milliseconds) {
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.engineCrossfadeMs = std::clamp(milliseconds, 0.0f, 1000.0f);
+        publishParams();
+        LOGI("Engine crossfade: %.0f ms", pendingParams.engineCrossfadeMs);
+    }
+
+    // Dither flavour for the int16 output (applies while dithering is enabled)
+    void setDitherMode(int mode) {
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.ditherMode = static_cast<DitherMode>(
+            std::clamp(mode, static_cast<int>(DitherMode::NONE),
+                       static_cast<int>(DitherMode::NOISE_SHAPED)));
+        publishParams();
     }
 
     void setCompressorRatio(float ratio) {
-        compressor->setRatio(ratio);
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.compressorRatio = ratio;
+        publishParams();
+    }
+
+    // Latency compensation: drop the output frames that are only delay at every
+    // stream start (configure(), clear(), a hard engine cut, the limiter coming on),
+    // so output frame n is input frame n at the stretch ratio. The delay itself
+    // stays - fewer frames come out - but output can be counted as track position.
+    // Takes effect from the next stream start.
+    void setLatencyCompensation(bool enabled) {
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        pendingParams.latencyCompensation = enabled;
+        publishParams();
+        LOGI("Latency compensation: %s", enabled ? "ON" : "OFF");
     }
 
-    // Process audio samples using selected engine
+    // Process interleaved int16 samples using selected engine
+    // int16 is converted to float once on the way in and once on the way out
     void process(const short* input, int numSamples, short* output, int* outputSamples) {
-        if (numSamples <= 0) {
-            *outputSamples = 0;
-            return;
-        }
+        // Legacy entry point: caller guarantees room for everything produced
+        processInt16(input, numSamples, output, INT_MAX, outputSamples);
+    }
 
-        int numFrames = numSamples / channels;
+    void processInt16(const short* input, int numSamples, short* output, int maxOutputSamples,
+                      int* outputSamples) {
+        *outputSamples = 0;
+        AudioBlock block(*this);
+        EngineGraph& g = block.graph();
+        if (numSamples <= 0) return;
 
-        // Route to appropriate engine
-        switch (currentEngine) {
-            case AudioEngineType::SUPERPOWERED:
-                processSuperpowered(input, numSamples, output, outputSamples);
-                break;
-            case AudioEngineType::RUBBERBAND:
-#if USE_RUBBERBAND
-                processRubberband(input, numSamples, output, outputSamples);
-#else
-                // Rubberband not compiled, fallback to SoundTouch
-                processSoundTouch(input, numSamples, output, outputSamples);
-#endif
-                break;
-            case AudioEngineType::SOUNDTOUCH:
-            default:
-                processSoundTouch(input, numSamples, output, outputSamples);
-                break;
+        const int channels = g.channels;
+        int numFrames = numSamples / channels;
+        int maxOutputFrames = maxOutputSamples / channels;
+        const int maxBlockFrames = inputBlockFrames(g);
+        int framesWritten = 0;
+
+        for (int offset = 0; offset < numFrames; offset += maxBlockFrames) {
+            int blockFrames = std::min(maxBlockFrames, numFrames - offset);
+            int capacity = std::min(kMaxOutputFrames, maxOutputFrames - framesWritten);
+
+            convertInt16ToFloat(input + offset * channels, g.floatInputBuffer.data(),
+                                blockFrames * channels);
+            int producedFrames = processInterleaved(g, g.floatInputBuffer.data(), blockFrames,
+                                                    g.floatOutputBuffer.data(), capacity);
+            // Ceiling, dither and rounding in one pass on the way out
+            short* out = output + framesWritten * channels;
+            if (g.applied.ditheringEnabled) {
+                convertFloatToInt16(g.floatOutputBuffer.data(), out, producedFrames * channels,
+                                    channels, g.applied.hardLimiterCeiling,
+                                    g.applied.ditherMode, g.dither);
+            } else {
+                convertFloatToInt16(g.floatOutputBuffer.data(), out, producedFrames * channels,
+                                    g.applied.hardLimiterCeiling);
+            }
+            framesWritten += producedFrames;
         }
-    }
 
-private:
-    // Process using SoundTouch engine
-    void processSoundTouch(const short* input, int numSamples, short* output, int* outputSamples) {
-        int numFrames = numSamples / channels;
+        *outputSamples = framesWritten * channels;
+    }
 
-        // Feed samples to SoundTouch
-        soundTouch->putSamples(input, numFrames);
+    // Register caller-owned direct memory (e.g. Java direct ByteBuffers) once.
+    // The memory must stay valid until replaced or the engine is destroyed; a
+    // replaced pair is released once this returns (no processDirect() still uses it).
+    bool setDirectBuffers(void* input, size_t inputBytes, void* output, size_t outputBytes,
+                          bool floatSamples) {
+        std::lock_guard<std::mutex> lock(paramsMutex);
+        DirectBuffers& next = directBuffers.writeBuffer();
+        next = DirectBuffers();
+        const bool valid = input && output;
+        if (valid) {
+            size_t sampleBytes = floatSamples ? sizeof(float) : sizeof(short);
+            next.input = input;
+            next.output = output;
+            next.inputSamples = static_cast<int>(std::min<size_t>(inputBytes / sampleBytes, INT_MAX));
+            next.outputSamples = static_cast<int>(std::min<size_t>(outputBytes / sampleBytes, INT_MAX));
+            next.floatSamples = floatSamples;
+        }
+        const DirectBuffers registered = next;
+        directBuffers.publish();
+
+        // A processDirect() already past its snapshot may still be on the old pair
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const uint64_t epoch = directEpoch.now();
+        if (epoch % 2 != 0) {
+            while (directEpoch.now() == epoch) std::this_thread::yield();
+        }
 
-        // Receive processed samples
-        int maxOutputFrames = 32768;
-        shortOutputBuffer.resize(maxOutputFrames * channels);
+        if (!valid) return false;
+        LOGI("Direct buffers registered: in=%d, out=%d samples (%s)",
+             registered.inputSamples, registered.outputSamples, floatSamples ? "float" : "int16");
+        return true;
+    }
 
-        int receivedFrames = soundTouch->receiveSamples(shortOutputBuffer.data(), maxOutputFrames);
+    // Process numSamples from the registered input buffer into the registered output buffer
+    int processDirect(int numSamples) {
+        directEpoch.enter();
+        directBuffers.update();
+        const DirectBuffers& direct = directBuffers.read();
+
+        int outputSamples = 0;
+        if (direct.input && direct.output) {
+            numSamples = std::min(numSamples, direct.inputSamples);
+            if (direct.floatSamples) {
+                processFloat(static_cast<const float*>(direct.input), numSamples,
+                             static_cast<float*>(direct.output), direct.outputSamples, &outputSamples);
+            } else {
+                processInt16(static_cast<const short*>(direct.input), numSamples,
+                             static_cast<short*>(direct.output), direct.outputSamples, &outputSamples);
+            }
+        }
+        directEpoch.exit();
+        return outputSamples;
+    }
 
-        if (receivedFrames <= 0) {
-            *outputSamples = 0;
-            return;
+    // Process interleaved float samples (-1..1) - no int16 round trip
+    void processFloat(const float* input, int numSamples, float* output, int maxOutputSamples,
+                      int* outputSamples) {
+        *outputSamples = 0;
+        AudioBlock block(*this);
+        EngineGraph& g = block.graph();
+        if (numSamples <= 0) return;
+
+        // Same block split as the int16 path: the stretchers are sized for
+        // kMaxInputFrames in / kMaxOutputFrames out per call
+        const int channels = g.channels;
+        int numFrames = numSamples / channels;
+        int maxOutputFrames = maxOutputSamples / channels;
+        const int maxBlockFrames = inputBlockFrames(g);
+        int framesWritten = 0;
+
+        for (int offset = 0; offset < numFrames; offset += maxBlockFrames) {
+            int blockFrames = std::min(maxBlockFrames, numFrames - offset);
+            int capacity = std::min(kMaxOutputFrames, maxOutputFrames - framesWritten);
+
+            float* out = output + framesWritten * channels;
+            int producedFrames = processInterleaved(g, input + offset * channels, blockFrames,
+                                                    out, capacity);
+            applyCeiling(g, out, producedFrames);
+            framesWritten += producedFrames;
         }
 
-        int totalSamples = receivedFrames * channels;
+        *outputSamples = framesWritten * channels;
+    }
 
-        // Apply battle processing chain if enabled
-        if (battleMode) {
-            // Convert to float for processing
-            if (floatOutputBuffer.size() < static_cast<size_t>(totalSamples)) {
-                floatOutputBuffer.resize(totalSamples);
-            }
-            for (int i = 0; i < totalSamples; i++) {
-                floatOutputBuffer[i] = shortOutputBuffer[i] / 32768.0f;
+    // Process planar float channels (one buffer per channel)
+    void processPlanar(const float* const* input, int numFrames, float* const* output,
+                       int maxOutputFrames, int* outputFrames) {
+        *outputFrames = 0;
+        AudioBlock block(*this);
+        EngineGraph& g = block.graph();
+        if (numFrames <= 0) return;
+
+        const int channels = g.channels;
+        const int maxBlockFrames = inputBlockFrames(g);
+        int framesWritten = 0;
+        for (int offset = 0; offset < numFrames; offset += maxBlockFrames) {
+            int blockFrames = std::min(maxBlockFrames, numFrames - offset);
+
+            for (int ch = 0; ch < channels; ch++) {
+                g.planarInPtrs[ch] = input[ch] + offset;
             }
+            interleave(g.planarInPtrs.data(), g.floatInputBuffer.data(), blockFrames, channels);
 
-            // Bass boost (low shelf EQ)
-            if (bassBoostAmount > 0) {
-                bassBoost->process(floatOutputBuffer.data(), totalSamples);
-            }
+            int capacity = std::min(kMaxOutputFrames, maxOutputFrames - framesWritten);
+            int producedFrames = processInterleaved(g, g.floatInputBuffer.data(), blockFrames,
+                                                    g.floatOutputBuffer.data(), capacity);
+            applyCeiling(g, g.floatOutputBuffer.data(), producedFrames);
 
-            // Psychoacoustic bass enhancement (adds perceived loudness without gain)
-            if (subHarmonicAmount > 0 || exciterAmount > 0) {
-                for (int i = 0; i < totalSamples; i += channels) {
-                    // Left channel
-                    if (subHarmonicAmount > 0) {
-                        floatOutputBuffer[i] = subHarmonicL.process(floatOutputBuffer[i]);
-                    }
-                    if (exciterAmount > 0) {
-                        floatOutputBuffer[i] = exciterL.process(floatOutputBuffer[i]);
-                    }
-                    // Right channel (if stereo)
-                    if (channels > 1) {
-                        if (subHarmonicAmount > 0) {
-                            floatOutputBuffer[i + 1] = subHarmonicR.process(floatOutputBuffer[i + 1]);
-                        }
-                        if (exciterAmount > 0) {
-                            floatOutputBuffer[i + 1] = exciterR.process(floatOutputBuffer[i + 1]);
-                        }
-                    }
-                }
+            for (int ch = 0; ch < channels; ch++) {
+                g.planarOutPtrs[ch] = output[ch] + framesWritten;
             }
+            deinterleave(g.floatOutputBuffer.data(), g.planarOutPtrs.data(), producedFrames, channels);
+            framesWritten += producedFrames;
+        }
 
-            // Compressor (adds punch)
-            compressor->process(floatOutputBuffer.data(), totalSamples);
+        *outputFrames = framesWritten;
+    }
 
-            // Limiter (prevents clipping)
-            limiter->process(floatOutputBuffer.data(), totalSamples);
+    // Render several engines (decks) into one interleaved float output in one call.
+    // Each deck renders into the same scratch block - the first deck's output
+    // buffer - which is then scaled by the deck's gain and summed into output.
+    // Decks must share the first deck's channel count; others are skipped.
+    // Each engine may appear only once per call.
+    // The sum gets the strictest hardware ceiling of the decks that have one.
+    // Returns samples written (the longest deck; shorter decks leave a gap at the end).
+    static int mix(void* const* handles, const float* const* inputs,
+                   const int* inputSamples, const float* gains, int count,
+                   float* output, int maxOutputSamples) {
+        auto deckAt = [handles](int d) { return static_cast<BattleAudioEngineImpl*>(handles[d]); };
+        if (count <= 0 || !deckAt(0)) return 0;
+
+        AudioBlock leadBlock(*deckAt(0));
+        EngineGraph& lead = leadBlock.graph();
+        const int channels = lead.channels;
+        const int maxOutputFrames = maxOutputSamples / channels;
+        float* scratch = lead.floatOutputBuffer.data();
+
+        int mixedFrames = 0;  // output frames already holding a sum
+        bool protect = false;
+        float ceiling = 1.0f;
+
+        auto renderDeck = [&](BattleAudioEngineImpl& deck, EngineGraph& g, int d) {
+            const int numFrames = inputs[d] ? inputSamples[d] / channels : 0;
+            const int maxBlockFrames = deck.inputBlockFrames(g);
+            int framesWritten = 0;
+            for (int offset = 0; offset < numFrames; offset += maxBlockFrames) {
+                int blockFrames = std::min(maxBlockFrames, numFrames - offset);
+                int capacity = std::min(kMaxOutputFrames, maxOutputFrames - framesWritten);
+
+                int producedFrames = deck.processInterleaved(g, inputs[d] + offset * channels,
+                                                             blockFrames, scratch, capacity);
+
+                // Sum where earlier decks already wrote, copy past their end
+                float* out = output + framesWritten * channels;
+                int overlap = std::clamp(mixedFrames - framesWritten, 0, producedFrames);
+                mixBlock<true>(scratch, out, overlap * channels, gains[d]);
+                mixBlock<false>(scratch + overlap * channels, out + overlap * channels,
+                                (producedFrames - overlap) * channels, gains[d]);
+
+                framesWritten += producedFrames;
+                mixedFrames = std::max(mixedFrames, framesWritten);
+            }
 
-            // Convert back to short
-            for (int i = 0; i < totalSamples; i++) {
-                float sample = floatOutputBuffer[i] * 32767.0f;
-                sample = std::clamp(sample, -32768.0f, 32767.0f);
-                output[i] = static_cast<short>(sample);
+            if (g.applied.hardwareProtection) {
+                protect = true;
+                ceiling = std::min(ceiling, g.applied.hardLimiterCeiling);
             }
-        } else {
-            // No battle processing, copy directly
-            std::copy(shortOutputBuffer.begin(),
-                      shortOutputBuffer.begin() + totalSamples,
-                      output);
+        };
+
+        renderDeck(*deckAt(0), lead, 0);
+        for (int d = 1; d < count; d++) {
+            if (!deckAt(d)) continue;
+            AudioBlock block(*deckAt(d));
+            EngineGraph& g = block.graph();
+            if (g.channels != channels) continue;
+            renderDeck(*deckAt(d), g, d);
         }
 
-        *outputSamples = totalSamples;
+        if (protect) clampBlock(output, mixedFrames * channels, ceiling);
+        return mixedFrames * channels;
     }
 
-    // Process using Superpowered engine (DJ-grade quality)
-    void processSuperpowered(const short* input, int numSamples, short* output, int* outputSamples) {
-        if (!timeStretcher) {
-            // Fallback to SoundTouch if Superpowered not available
-            processSoundTouch(input, numSamples, output, outputSamples);
-            return;
+    // Offline export: render a whole WAV file with the current settings, as fast
+    // as the device allows. Runs on a private graph, so live playback carries on.
+    // Blocking (seconds for a full track) - call it from a worker thread.
+    // See renderOffline() for how the work is split. Returns frames written, or -1.
+    int64_t renderFile(const char* inputPath, const char* outputPath, bool floatOutput) {
+        if (!inputPath || !outputPath) return -1;
+
+        EngineParams p;
+        {
+            std::lock_guard<std::mutex> lock(paramsMutex);
+            p = pendingParams;
         }
+        p.latencyCompensation = false;  // Offline output is trimmed to line up anyway
 
-        int numFrames = numSamples / channels;
+        OfflineContext context;
+        return renderOffline(context, p, inputPath, outputPath, floatOutput, true);
+    }
 
-        // Convert short to float for Superpowered (expects interleaved float)
-        if (floatInputBuffer.size() < static_cast<size_t>(numSamples)) {
-            floatInputBuffer.resize(numSamples);
-        }
-        for (int i = 0; i < numSamples; i++) {
-            floatInputBuffer[i] = input[i] / 32768.0f;
+    // Batch export (playlist pre-render): job i renders inputPaths[i] to
+    // outputPaths[i] with the chain settings of engine settings[i] (battle mode,
+    // EQ, bass, dynamics, protection, dither) at speeds[i] / pitches[i].
+    // Settings are snapshotted when the call starts.
+    //
+    // Jobs run on a work-stealing pool, one worker per big core unless threads > 0.
+    // Every job owns its own graph while it runs; each worker keeps its graph and
+    // buffers for the next job (see OfflineContext), and runs the chain inline -
+    // the parallelism is across jobs here, not across a job's stages.
+    // framesWritten[i] gets job i's frame count or -1. Returns jobs that succeeded.
+    static int renderBatch(void* const* settings, const char* const* inputPaths,
+                           const char* const* outputPaths, const float* speeds,
+                           const float* pitches, int count, bool floatOutput, int threads,
+                           long long* framesWritten) {
+        if (count <= 0) return 0;
+
+        std::vector<EngineParams> params(count);
+        for (int i = 0; i < count; i++) {
+            framesWritten[i] = -1;
+            auto* engine = static_cast<BattleAudioEngineImpl*>(settings[i]);
+            if (!engine) continue;
+
+            std::lock_guard<std::mutex> lock(engine->paramsMutex);
+            params[i] = engine->pendingParams;
+            params[i].speed = std::clamp(speeds[i], 0.05f, 10.0f);
+            params[i].pitchSemitones = std::clamp(pitches[i], -36.0f, 36.0f);
+            params[i].useRateMode = false;
+            params[i].latencyCompensation = false;
         }
 
-        // Configure time stretcher
-        timeStretcher->rate = speed;
-        int pitchCents = static_cast<int>(pitchSemitones * 100.0f);
-        timeStretcher->pitchShiftCents = std::clamp(pitchCents, -2400, 2400);
-
-        // Process with Superpowered TimeStretching
-        timeStretcher->addInput(floatInputBuffer.data(), numFrames);
-
-        // Get output
-        int maxOutputFrames = 32768;
-        if (floatOutputBuffer.size() < static_cast<size_t>(maxOutputFrames * channels)) {
-            floatOutputBuffer.resize(maxOutputFrames * channels);
+        WorkStealingPool pool(threads > 0 ? std::min(threads, count) : 0);
+        std::vector<OfflineContext> contexts(pool.getWorkerCount());
+        std::atomic<int> succeeded{ 0 };
+
+        // Longest tracks first, so a long one never starts last on an idle pool
+        std::vector<int> order(count);
+        std::vector<int64_t> lengths(count, 0);
+        for (int i = 0; i < count; i++) {
+            order[i] = i;
+            WavReader probe;
+            if (inputPaths[i] && probe.open(inputPaths[i])) lengths[i] = probe.getFrames();
         }
-
-        int receivedFrames = timeStretcher->getOutput(floatOutputBuffer.data(), maxOutputFrames);
-
-        if (receivedFrames <= 0) {
-            *outputSamples = 0;
-            return;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](int a, int b) { return lengths[a] > lengths[b]; });
+
+        for (int i : order) {
+            auto* engine = static_cast<BattleAudioEngineImpl*>(settings[i]);
+            if (!engine || !inputPaths[i] || !outputPaths[i]) continue;
+
+            pool.submit([&, engine, i](int worker) {
+                framesWritten[i] = engine->renderOffline(contexts[worker], params[i],
+                                                         inputPaths[i], outputPaths[i],
+                                                         floatOutput, false);
+                if (framesWritten[i] >= 0) succeeded.fetch_add(1, std::memory_order_relaxed);
+            });
         }
+        pool.wait();
 
-        int totalSamples = receivedFrames * channels;
-
-        // Apply Superpowered effects chain if battle mode enabled
-        if (battleMode) {
-            // Use Superpowered's own high-quality effects
-            if (spEQ && bassBoostAmount > 0) {
-                spEQ->process(floatOutputBuffer.data(), floatOutputBuffer.data(), receivedFrames);
-            }
-
-            // Psychoacoustic enhancement (still use our custom processors)
-            if (subHarmonicAmount > 0 || exciterAmount > 0) {
-                for (int i = 0; i < totalSamples; i += channels) {
-                    if (subHarmonicAmount > 0) {
-                        floatOutputBuffer[i] = subHarmonicL.process(floatOutputBuffer[i]);
-                    }
-                    if (exciterAmount > 0) {
-                        floatOutputBuffer[i] = exciterL.process(floatOutputBuffer[i]);
-                    }
-                    if (channels > 1) {
-                        if (subHarmonicAmount > 0) {
-                            floatOutputBuffer[i + 1] = subHarmonicR.process(floatOutputBuffer[i + 1]);
-                        }
-                        if (exciterAmount > 0) {
-                            floatOutputBuffer[i + 1] = exciterR.process(floatOutputBuffer[i + 1]);
-                        }
-                    }
-                }
-            }
+        LOGI("Batch render: %d/%d jobs on %d workers", succeeded.load(), count,
+             pool.getWorkerCount());
+        return succeeded.load();
+    }
 
-            // Superpowered Compressor
-            if (spCompressor) {
-                spCompressor->process(floatOutputBuffer.data(), floatOutputBuffer.data(), receivedFrames);
-            }
+    // Flush remaining samples (performed by the audio thread at its next block)
+    void flush() {
+        flushRequested.store(true, std::memory_order_release);
+    }
 
-            // Superpowered Limiter
-            if (spLimiter && limiterEnabled) {
-                spLimiter->process(floatOutputBuffer.data(), floatOutputBuffer.data(), receivedFrames);
-            }
-        }
+    // Clear all buffers (performed by the audio thread at its next block)
+    void clear() {
+        clearRequested.store(true, std::memory_order_release);
+    }
 
-        // Convert back to short
-        for (int i = 0; i < totalSamples; i++) {
-            float sample = floatOutputBuffer[i] * 32767.0f;
-            sample = std::clamp(sample, -32768.0f, 32767.0f);
-            output[i] = static_cast<short>(sample);
+    // Get current settings
+    float getSpeed() const { std::lock_guard<std::mutex> lock(paramsMutex); return pendingParams.speed; }
+    float getPitch() const { std::lock_guard<std::mutex> lock(paramsMutex); return pendingParams.pitchSemitones; }
+    float getRate() const { std::lock_guard<std::mutex> lock(paramsMutex); return pendingParams.rate; }
+    bool isBattleMode() const { std::lock_guard<std::mutex> lock(paramsMutex); return pendingParams.battleMode; }
+
+    // How far the output trails the input, in output frames: the running engine's
+    // delay plus the battle chain's (the limiter lookahead). Updated every block,
+    // so it follows speed and engine changes; the same with compensation on or off.
+    int getLatencyFrames() const { return latencyFrames.load(std::memory_order_relaxed); }
+
+    // Output true peak per channel (dBTP) since the previous call; resets the hold.
+    // Returns the number of channels written.
+    int readTruePeaks(float* peaksDb, int maxChannels) {
+        int channels = std::min(maxChannels, meterChannels.load(std::memory_order_relaxed));
+        for (int ch = 0; ch < channels; ch++) {
+            float peak = meterPeaks[ch].exchange(0.0f, std::memory_order_relaxed);
+            peaksDb[ch] = peak > 0.0f ? std::max(kMeterFloorDb, 20.0f * std::log10(peak))
+                                      : kMeterFloorDb;
         }
-
-        *outputSamples = totalSamples;
+        return channels;
     }
 
-#if USE_RUBBERBAND
-    // Process using Rubberband engine (Studio-grade, 10/10 quality)
-    void processRubberband(const short* input, int numSamples, short* output, int* outputSamples) {
-        if (!rubberbandStretcher) {
-            // Fallback to SoundTouch if Rubberband not available
-            processSoundTouch(input, numSamples, output, outputSamples);
-            return;
+private:
+    // -------------------------------------------------------------------------
+    // AUDIO BLOCK - Brackets one process() call on the audio thread.
+    // Marks the epoch (so the Scavenger knows what may be in use), loads the
+    // current graph and brings it up to date with the newest settings.
+    // The whole block is a RealtimeScope: every engine, the battle chain,
+    // crossfades and clear() requests run under the Debug allocation trap.
+    // -------------------------------------------------------------------------
+    class AudioBlock {
+    public:
+        explicit AudioBlock(BattleAudioEngineImpl& engine) : engine(engine) {
+            engine.audioEpoch.enter();
+            current = engine.graph.load(std::memory_order_seq_cst);
+            engine.params.update();
+            engine.applyParams(*current, engine.params.read(), false);
+            engine.serviceRequests(*current);
         }
 
-        int numFrames = numSamples / channels;
-
-        // Ensure Rubberband parameters are up to date
-        rubberbandStretcher->setTimeRatio(1.0 / speed);  // Inverse: slower speed = higher ratio
-        rubberbandStretcher->setPitchScale(std::pow(2.0, pitchSemitones / 12.0));
-
-        // Prepare deinterleaved input buffers (Rubberband expects separate channels)
-        std::vector<float> leftIn(numFrames);
-        std::vector<float> rightIn(numFrames);
-
-        // Deinterleave and convert to float
-        for (int i = 0; i < numFrames; i++) {
-            leftIn[i] = input[i * channels] / 32768.0f;
-            if (channels > 1) {
-                rightIn[i] = input[i * channels + 1] / 32768.0f;
-            } else {
-                rightIn[i] = leftIn[i];  // Mono: duplicate
-            }
-        }
+        ~AudioBlock() { engine.audioEpoch.exit(); }
 
-        // Rubberband expects pointer array
-        const float* inPtrs[2] = { leftIn.data(), rightIn.data() };
-        rubberbandStretcher->process(inPtrs, numFrames, false);
+        EngineGraph& graph() { return *current; }
 
-        // Get available output samples
-        int availableFrames = rubberbandStretcher->available();
-        if (availableFrames <= 0) {
-            *outputSamples = 0;
-            return;
-        }
+    private:
+        RealtimeScope realtimeScope;  // First member: covers the constructor body too
+        BattleAudioEngineImpl& engine;
+        EngineGraph* current = nullptr;
+    };
 
-        // Prepare deinterleaved output buffers
-        std::vector<float> leftOut(availableFrames);
-        std::vector<float> rightOut(availableFrames);
-        float* outPtrs[2] = { leftOut.data(), rightOut.data() };
+    // Copy the control-side settings into the triple buffer (paramsMutex held)
+    void publishParams() {
+        params.writeBuffer() = pendingParams;
+        params.publish();
+        graphScavenger.scavenge();
+    }
 
-        int retrievedFrames = rubberbandStretcher->retrieve(outPtrs, availableFrames);
+    // Allocate and fully configure a graph. NOT real-time safe.
+    EngineGraph* buildGraph(int sampleRate, int channels, const EngineParams& p) {
+        EngineGraph* g = new EngineGraph();
+        g->sampleRate = sampleRate;
+        g->channels = channels;
 
-        if (retrievedFrames <= 0) {
-            *outputSamples = 0;
-            return;
+        // Configure Superpowered (only if license available)
+        if (superpoweredAvailable) {
+            // Superpowered time stretcher (highest quality mode)
+            g->timeStretcher = new Superpowered::TimeStretching(sampleRate, 0.01f);
+            g->timeStretcher->sound = 2;  // Highest quality
+            g->timeStretcher->rate = 1.0f;
+            g->timeStretcher->pitchShiftCents = 0;
+
+            // Superpowered effects for full utilization
+            g->spCompressor = new Superpowered::Compressor(sampleRate);
+            g->spCompressor->inputGainDb = 0;
+            g->spCompressor->outputGainDb = 0;
+            g->spCompressor->wet = 1.0f;
+            g->spCompressor->attackSec = 0.003f;
+            g->spCompressor->releaseSec = 0.3f;
+            g->spCompressor->ratio = 4.0f;
+            g->spCompressor->thresholdDb = -10.0f;
+            g->spCompressor->hpCutOffHz = 1;
+
+            g->spLimiter = new Superpowered::Limiter(sampleRate);
+            g->spLimiter->ceilingDb = -0.1f;
+            g->spLimiter->thresholdDb = -0.3f;
+            g->spLimiter->releaseSec = 0.1f;
+
+            g->spEQ = new Superpowered::ThreeBandEQ(sampleRate);
+            g->spEQ->low = 1.0f;  // Will be adjusted by bass boost
+            g->spEQ->mid = 1.0f;
+            g->spEQ->high = 1.0f;
         }
 
-        int totalSamples = retrievedFrames * channels;
+        // SoundTouch - OPTIMIZED SETTINGS for maximum quality (always available)
+        g->soundTouch = new soundtouch::SoundTouch();
+        g->soundTouch->setSetting(SETTING_USE_AA_FILTER, 1);        // Anti-alias filtering ON
+        g->soundTouch->setSetting(SETTING_AA_FILTER_LENGTH, 128);   // Longest filter for best quality
+        g->soundTouch->setSetting(SETTING_SEQUENCE_MS, 82);         // Optimal for music
+        g->soundTouch->setSetting(SETTING_SEEKWINDOW_MS, 28);       // Better seeking
+        g->soundTouch->setSetting(SETTING_OVERLAP_MS, 12);          // Smoother transitions
+        g->soundTouch->setSampleRate(sampleRate);
+        g->soundTouch->setChannels(channels);
+
+        // Battle processing (for SoundTouch / Rubberband engines)
+        g->limiter.configure(sampleRate, channels);
+        g->protection.configure(sampleRate, channels);
+        g->outputMeter.configure(channels);
+        g->compressor.configure(sampleRate, channels);
+        g->bassBoost.configure(sampleRate, channels);
+        g->equalizer.configure(sampleRate, channels);
+
+        // Psychoacoustic bass enhancement
+        g->subHarmonicL.configure(sampleRate);
+        g->subHarmonicR.configure(sampleRate);
+        g->exciterL.configure(sampleRate);
+        g->exciterR.configure(sampleRate);
+        g->parallelCompressor.configure(sampleRate, channels);
+        g->megaBass.configure(sampleRate, channels);
+
+        // Fused kernel view of the chain
+        g->chain.equalizer = &g->equalizer;
+        g->chain.bassBoost = &g->bassBoost;
+        g->chain.subHarmonic[0] = &g->subHarmonicL;
+        g->chain.subHarmonic[1] = &g->subHarmonicR;
+        g->chain.exciter[0] = &g->exciterL;
+        g->chain.exciter[1] = &g->exciterR;
+        g->chain.compressor = &g->compressor;
+        g->chain.limiter = &g->limiter;
+        g->chain.channels = channels;
 
-        // Apply battle processing chain if enabled
-        if (battleMode) {
-            // Interleave to float buffer for processing
-            if (floatOutputBuffer.size() < static_cast<size_t>(totalSamples)) {
-                floatOutputBuffer.resize(totalSamples);
+#if USE_RUBBERBAND
+        // Rubberband (studio-grade time-stretching). Pitch uses HighConsistency, not
+        // HighQuality: HighQuality moves the resampler to the other side of the
+        // stretcher when the pitch scale crosses 1.0, which clicks mid-glide
+        g->rubberbandStretcher = new RubberBandStretcher(
+            sampleRate, channels,
+            RubberBandStretcher::OptionProcessRealTime |
+            RubberBandStretcher::OptionPitchHighConsistency |
+            RubberBandStretcher::OptionStretchPrecise |
+            RubberBandStretcher::OptionTransientsCrisp |
+            RubberBandStretcher::OptionChannelsTogether
+        );
+
+        // Size the scratch arena once: one input and one output plane per channel.
+        // Rubberband is told the block limit so its own buffers never reallocate either.
+        g->rubberbandBlockFrames = static_cast<int>(std::min<size_t>(
+            g->rubberbandStretcher->getProcessSizeLimit(), kMaxRubberbandBlockFrames));
+        g->rubberbandStretcher->setMaxProcessSize(g->rubberbandBlockFrames);
+
+        // Walk the stretcher through the corners of the speed x pitch range. Realtime
+        // reconfigure() only ever grows its output rings and adds windows and
+        // resamplers, so doing it here means no drag ever allocates on the audio
+        // thread. Twice: ring sizes follow the largest window, which a later corner
+        // may be the first to create.
+        for (int pass = 0; pass < 2; pass++) {
+            for (double timeRatio : {1.0 / 0.05, 1.0 / 10.0}) {
+                g->rubberbandStretcher->setTimeRatio(timeRatio);
+                g->rubberbandStretcher->setPitchScale(std::pow(2.0, -36.0 / 12.0));
+                g->rubberbandStretcher->setPitchScale(std::pow(2.0, 36.0 / 12.0));
             }
+        }
+        g->rubberbandStretcher->setPitchScale(1.0);
+        g->rubberbandStretcher->setTimeRatio(1.0);
+
+        g->rubberbandScratch.reserve(ScratchArena::footprint(g->rubberbandBlockFrames) * channels * 2);
+        g->rubberbandIn.assign(channels, nullptr);
+        g->rubberbandOut.assign(channels, nullptr);
+        for (int ch = 0; ch < channels; ch++) {
+            g->rubberbandIn[ch] = g->rubberbandScratch.take(g->rubberbandBlockFrames);
+            g->rubberbandOut[ch] = g->rubberbandScratch.take(g->rubberbandBlockFrames);
+        }
+#endif
 
-            for (int i = 0; i < retrievedFrames; i++) {
-                floatOutputBuffer[i * channels] = leftOut[i];
-                if (channels > 1) {
-                    floatOutputBuffer[i * channels + 1] = rightOut[i];
-                }
+        // Allocate buffers (the process path never resizes them)
+        g->floatInputBuffer.assign(kMaxInputFrames * channels, 0.0f);
+        g->floatOutputBuffer.assign(kMaxOutputFrames * channels, 0.0f);
+        g->planarInPtrs.assign(channels, nullptr);
+        g->planarOutPtrs.assign(channels, nullptr);
+        g->inputHistory.assign(static_cast<size_t>(kHistoryFrames) * channels, 0.0f);
+        g->crossfadeBuffer.assign(static_cast<size_t>(kMaxOutputFrames) * channels, 0.0f);
+
+        // Bring every processor in line with the current settings, then settle
+        // every glide so a fresh graph starts exactly at those values
+        applyParams(*g, p, true);
+        clearGraph(*g);
+        return g;
+    }
+
+    // Offline render core (renderFile / renderBatch). NOT real-time safe.
+    //
+    //   calling thread: read + stretch in large blocks - Rubberband in offline
+    //                   mode with a study() pass when built in, SoundTouch otherwise
+    //                   (Superpowered's stretcher has no offline mode)
+    //   pipelined:      chain front (mega bass, parallel compression, EQ, bass boost,
+    //                   sub-harmonic, exciter), chain dynamics (compressor, limiter)
+    //                   + speaker protection, and the lookahead trim + WAV writer
+    //                   each on their own worker thread
+    //   not pipelined:  the same three stages inline on the calling thread
+    //
+    // The chain runs exactly as in playback - same processors, same order - just
+    // split at the compressor so consecutive chunks can overlap across cores.
+    // Returns frames written, or -1 on error.
+    int64_t renderOffline(OfflineContext& context, const EngineParams& p, const char* inputPath,
+                          const char* outputPath, bool floatOutput, bool pipelined) {
+        WavReader reader;
+        if (!reader.open(inputPath)) {
+            LOGE("Render: cannot read %s (PCM 16/24-bit or float WAV expected)", inputPath);
+            return -1;
+        }
+        const int sampleRate = reader.getSampleRate();
+        const int channels = reader.getChannels();
+
+        // Same processors and settings as playback, every glide already settled.
+        // A pooled graph is only rebuilt for a new format, otherwise re-settled at p.
+        if (!context.graph || context.graph->sampleRate != sampleRate ||
+            context.graph->channels != channels) {
+            context.graph.reset(buildGraph(sampleRate, channels, p));
+            context.block.assign(static_cast<size_t>(kOfflineBlockFrames) * channels, 0.0f);
+#if USE_RUBBERBAND
+            context.planeStorage.assign(static_cast<size_t>(kOfflineBlockFrames) * channels * 2, 0.0f);
+            context.inPlanes.resize(channels);
+            context.outPlanes.resize(channels);
+            for (int ch = 0; ch < channels; ch++) {
+                context.inPlanes[ch] = context.planeStorage.data() +
+                                       static_cast<size_t>(ch) * kOfflineBlockFrames;
+                context.outPlanes[ch] = context.inPlanes[ch] +
+                                        static_cast<size_t>(channels) * kOfflineBlockFrames;
             }
+#endif
+        } else {
+            applyParams(*context.graph, p, true);
+            clearGraph(*context.graph);
+            selectChainKernels(*context.graph);  // From the settled state, as a fresh graph would
+        }
+        EngineGraph* g = context.graph.get();
+
+        WavWriter writer;
+        const float ceiling = p.hardwareProtection ? p.hardLimiterCeiling : 1.0f;
+        const DitherMode dither = p.ditheringEnabled ? p.ditherMode : DitherMode::NONE;
+        if (!writer.open(outputPath, sampleRate, channels, floatOutput, ceiling, dither)) {
+            LOGE("Render: cannot write %s", outputPath);
+            return -1;
+        }
 
-            // Bass boost
-            if (bassBoostAmount > 0) {
-                bassBoost->process(floatOutputBuffer.data(), totalSamples);
+        const unsigned stages = g->chainStages;
+        const BattleChainFn front = selectBattleChain(channels, stages & ~kChainDynamicsStages);
+        const BattleChainFn dynamics = selectBattleChain(channels, stages & kChainDynamicsStages);
+        const int chainLatency = (stages & kChainLimiter) ? g->limiter.getLatencyFrames() : 0;
+
+        int64_t trimFrames = chainLatency;  // writer thread only
+        ChunkPipeline pipeline({
+            [&](AudioChunk& chunk) {
+                applyChainExtras(*g, chunk.samples.data(), chunk.frames);
+                front(g->chain, chunk.samples.data(), chunk.frames);
+            },
+            [&](AudioChunk& chunk) {
+                dynamics(g->chain, chunk.samples.data(), chunk.frames);
+                g->protection.process(chunk.samples.data(), chunk.frames);
+            },
+            [&](AudioChunk& chunk) {
+                // Drop the lookahead delay's leading silence so output lines up with input
+                const int skip = static_cast<int>(std::min<int64_t>(trimFrames, chunk.frames));
+                trimFrames -= skip;
+                writer.write(chunk.samples.data() + skip * channels, chunk.frames - skip);
+            },
+        }, kOfflineChunkFrames, channels, pipelined);
+
+        // The chunk the stretcher is currently filling
+        AudioChunk* filling = pipeline.acquire();
+        auto space = [&] { return kOfflineChunkFrames - filling->frames; };
+        auto cursor = [&] { return filling->samples.data() + filling->frames * channels; };
+        auto commit = [&](int frames) {
+            filling->frames += frames;
+            if (filling->frames == kOfflineChunkFrames) {
+                pipeline.submit(filling);
+                filling = pipeline.acquire();
             }
+        };
 
-            // Psychoacoustic enhancement
-            if (subHarmonicAmount > 0 || exciterAmount > 0) {
-                for (int i = 0; i < totalSamples; i += channels) {
-                    if (subHarmonicAmount > 0) {
-                        floatOutputBuffer[i] = subHarmonicL.process(floatOutputBuffer[i]);
-                    }
-                    if (exciterAmount > 0) {
-                        floatOutputBuffer[i] = exciterL.process(floatOutputBuffer[i]);
-                    }
-                    if (channels > 1) {
-                        if (subHarmonicAmount > 0) {
-                            floatOutputBuffer[i + 1] = subHarmonicR.process(floatOutputBuffer[i + 1]);
-                        }
-                        if (exciterAmount > 0) {
-                            floatOutputBuffer[i + 1] = exciterR.process(floatOutputBuffer[i + 1]);
-                        }
-                    }
-                }
+        std::vector<float>& block = context.block;
+        int readFrames = 0;
+
+#if USE_RUBBERBAND
+        std::vector<float*>& inPlanes = context.inPlanes;
+        std::vector<float*>& outPlanes = context.outPlanes;
+        double timeRatio = 1.0 / (p.useRateMode ? p.rate : p.speed);
+        double pitchScale = p.useRateMode ? p.rate : std::pow(2.0, p.pitchSemitones / 12.0);
+
+        // Offline mode: sees the whole file before stretching it (study pass),
+        // so stretch is distributed by the file's own transients - no real-time compromises
+        RubberBandStretcher stretcher(
+            sampleRate, channels,
+            RubberBandStretcher::OptionProcessOffline |
+            RubberBandStretcher::OptionPitchHighQuality |
+            RubberBandStretcher::OptionStretchPrecise |
+            RubberBandStretcher::OptionTransientsCrisp |
+            RubberBandStretcher::OptionChannelsTogether,
+            timeRatio, pitchScale);
+        stretcher.setExpectedInputDuration(static_cast<size_t>(reader.getFrames()));
+        stretcher.setMaxProcessSize(kOfflineBlockFrames);
+
+        // Pass 1: study
+        while ((readFrames = reader.read(block.data(), kOfflineBlockFrames)) > 0) {
+            deinterleave(block.data(), inPlanes.data(), readFrames, channels);
+            stretcher.study(inPlanes.data(), readFrames, false);
+        }
+        stretcher.study(inPlanes.data(), 0, true);
+
+        // Pass 2: process, retrieving straight into pipeline chunks
+        auto drain = [&] {
+            int available;
+            while ((available = stretcher.available()) > 0) {
+                int frames = std::min({ available, kOfflineBlockFrames, space() });
+                frames = static_cast<int>(stretcher.retrieve(outPlanes.data(), frames));
+                interleave(outPlanes.data(), cursor(), frames, channels);
+                commit(frames);
+            }
+            return available;
+        };
+
+        if (!reader.rewind()) {
+            // Nothing has been written past the header yet - don't leave an empty WAV behind
+            LOGE("Render: cannot rewind %s", inputPath);
+            pipeline.finish();
+            writer.close();
+            std::remove(outputPath);
+            return -1;
+        }
+        while ((readFrames = reader.read(block.data(), kOfflineBlockFrames)) > 0) {
+            deinterleave(block.data(), inPlanes.data(), readFrames, channels);
+            stretcher.process(inPlanes.data(), readFrames, false);
+            drain();
+        }
+        stretcher.process(inPlanes.data(), 0, true);
+
+        // -1 once the last frame is out (offline mode may still be busy on its own threads)
+        while (drain() >= 0) {
+            std::this_thread::yield();
+        }
+#else
+        // SoundTouch, fed a large block at a time, its tail pushed out by flush()
+        soundtouch::SoundTouch& soundTouch = *g->soundTouch;
+        auto drain = [&] {
+            int frames;
+            while ((frames = static_cast<int>(soundTouch.receiveSamples(cursor(), space()))) > 0) {
+                commit(frames);
             }
+        };
+
+        while ((readFrames = reader.read(block.data(), kOfflineBlockFrames)) > 0) {
+            soundTouch.putSamples(block.data(), readFrames);
+            drain();
+        }
+        soundTouch.flush();
+        drain();
+#endif
+
+        // Push the limiter's lookahead tail out with silence
+        for (int pad = chainLatency; pad > 0;) {
+            const int frames = std::min(pad, space());
+            std::fill(cursor(), cursor() + frames * channels, 0.0f);
+            commit(frames);
+            pad -= frames;
+        }
+        pipeline.submit(filling);
+        pipeline.finish();
+
+        const int64_t framesWritten = writer.getFramesWritten();
+        if (!writer.close()) {
+            LOGE("Render: write to %s failed", outputPath);
+            return -1;
+        }
+
+        LOGI("Rendered %s -> %s: %lld frames", inputPath, outputPath,
+             static_cast<long long>(framesWritten));
+        return framesWritten;
+    }
+
+
+    // Push settings that changed since the graph last saw them into its processors.
+    // Runs on the audio thread at block start (or once at build time with force=true).
+    // Only parameter updates here - nothing allocates.
+    void applyParams(EngineGraph& g, const EngineParams& p, bool force) {
+        EngineParams& a = g.applied;
+
+        bool stretchChanged = force || p.speed != a.speed || p.pitchSemitones != a.pitchSemitones ||
+                              p.rate != a.rate || p.useRateMode != a.useRateMode;
+        if (stretchChanged) {
+            // Glide to the new ratios (processInterleaved steps them per sub-block).
+            // A mode switch or a fresh graph jumps straight there.
+            bool jump = force || p.useRateMode != a.useRateMode;
+            int rampFrames = jump ? 0 : parameterRampFrames(g.sampleRate);
+            g.speedRamp.setTarget(p.speed, rampFrames);
+            g.pitchRamp.setTarget(p.pitchSemitones, rampFrames);
+            g.rateRamp.setTarget(p.rate, rampFrames);
+            updateStretchers(g, p.useRateMode);
+        }
+
+        // Engine switch: pre-roll the incoming engine and crossfade into it
+        if (!force && p.engine != a.engine && p.engineCrossfadeMs > 0.0f) {
+            beginEngineSwitch(g, a.engine, p.engine, p.engineCrossfadeMs);
+        }
+
+        if ((force || p.formantPreservation != a.formantPreservation) && g.timeStretcher) {
+            g.timeStretcher->formantCorrection = p.formantPreservation ? 0.7f : 0.0f;
+        }
 
-            // Compressor
-            compressor->process(floatOutputBuffer.data(), totalSamples);
+        if (force || p.bassBoostAmount != a.bassBoostAmount) {
+            g.bassBoost.setGain(p.bassBoostAmount);
 
-            // Limiter
-            if (limiterEnabled) {
-                limiter->process(floatOutputBuffer.data(), totalSamples);
+            // Superpowered 3-band EQ for bass boost
+            if (g.spEQ) {
+                // Convert dB to linear gain: 10^(dB/20)
+                // For EQ low band: 1.0 = unity, 2.0 = +6dB, 4.0 = +12dB
+                g.spEQ->low = std::pow(10.0f, p.bassBoostAmount / 20.0f);
+            }
+        }
+        for (int band = 0; band < ParametricEqualizer::kBands; band++) {
+            if (force || p.eqBandGainsDb[band] != a.eqBandGainsDb[band]) {
+                g.equalizer.setBandGain(band, p.eqBandGainsDb[band]);
             }
+        }
+        if (force || p.dcBlockerEnabled != a.dcBlockerEnabled) {
+            g.protection.setDcBlocker(p.dcBlockerEnabled);
+        }
+        if (force || p.subBassFilterEnabled != a.subBassFilterEnabled) {
+            g.protection.setSubsonicFilter(p.subBassFilterEnabled);
+        }
+        if (force || p.subHarmonicAmount != a.subHarmonicAmount) {
+            g.subHarmonicL.setAmount(p.subHarmonicAmount);
+            g.subHarmonicR.setAmount(p.subHarmonicAmount);
+        }
+        if (force || p.exciterAmount != a.exciterAmount) {
+            g.exciterL.setAmount(p.exciterAmount);
+            g.exciterR.setAmount(p.exciterAmount);
+        }
+        if (force || p.megaBassIntensity != a.megaBassIntensity) {
+            g.megaBass.setIntensity(p.megaBassIntensity);
+        }
+        if (force || p.limiterThresholdDb != a.limiterThresholdDb) {
+            g.limiter.setThreshold(p.limiterThresholdDb);
+        }
+        if (force || p.compressorRatio != a.compressorRatio) {
+            g.compressor.setRatio(p.compressorRatio);
+        }
+
+        // Stage enables (compressor is bypassed in audiophile mode)
+        bool compressorOn = p.battleMode && !p.audiophileMode;
+        g.compressor.setEnabled(compressorOn);
+        g.parallelCompressor.setMix(compressorOn ? p.parallelCompressionMix : 0.0f);
+        g.limiter.setEnabled(p.limiterEnabled);
+        g.equalizer.setEnabled(p.equalizerEnabled);
+        if (g.spEQ) g.spEQ->enabled = p.bassBoostAmount > 0;
+        if (g.spCompressor) g.spCompressor->enabled = compressorOn;
+        if (g.spLimiter) g.spLimiter->enabled = p.battleMode && p.limiterEnabled;
+
+        a = p;
+        selectChainKernels(g);
+    }
 
-            // Convert back to short
-            for (int i = 0; i < totalSamples; i++) {
-                float sample = floatOutputBuffer[i] * 32767.0f;
-                sample = std::clamp(sample, -32768.0f, 32767.0f);
-                output[i] = static_cast<short>(sample);
+    // Re-select the specialized kernels for the stages that now run
+    void selectChainKernels(EngineGraph& g) {
+        unsigned stages = g.applied.battleMode ? activeChainStages(g) : 0;
+        const bool limiterStarts = (stages & kChainLimiter) && !(g.chainStages & kChainLimiter);
+        if (limiterStarts) {
+            // Lookahead delay line still holds audio from when it last ran
+            g.limiter.reset();
+        }
+        g.chainStages = stages;
+        g.chainKernel = selectBattleChain(g.channels, stages);
+        g.psychoacousticKernel = selectBattleChain(g.channels, stages & kChainSuperpoweredStages);
+
+        // The restarted lookahead opens with its delay's worth of silence
+        if (limiterStarts && g.applied.latencyCompensation) {
+            g.compensationTrim += chainLatencyFrames(g);
+        }
+    }
+
+    // clear() / flush() requested by a control thread
+    void serviceRequests(EngineGraph& g) {
+        if (clearRequested.exchange(false, std::memory_order_acq_rel)) {
+            clearGraph(g);
+        }
+        if (flushRequested.exchange(false, std::memory_order_acq_rel)) {
+            g.soundTouch->flush();
+        }
+    }
+
+    // Reset every stretcher and processor in the graph (audio thread)
+    void clearGraph(EngineGraph& g) {
+        g.crossfading = false;
+        g.historyFilled = 0;
+        g.protection.reset();
+        g.outputMeter.reset();
+        g.dither.reset();
+
+        g.soundTouch->clear();
+
+        // Clear Superpowered
+        if (g.timeStretcher) {
+            g.timeStretcher->reset();
+        }
+
+#if USE_RUBBERBAND
+        // Clear Rubberband
+        if (g.rubberbandStretcher) {
+            g.rubberbandStretcher->reset();
+        }
+#endif
+
+        g.limiter.reset();
+        g.compressor.reset();
+        g.bassBoost.reset();
+        g.equalizer.reset();
+        g.subHarmonicL.reset();
+        g.subHarmonicR.reset();
+        g.exciterL.reset();
+        g.exciterR.reset();
+        g.parallelCompressor.reset();
+        g.megaBass.reset();
+
+        g.superpoweredBacklog = 0.0;
+        g.compensationTrim = 0;
+        if (g.applied.latencyCompensation) {
+            alignStreamStart(g);
+        }
+    }
+
+    // Latency compensation at a stream start: everything that is only delay gets
+    // trimmed from the front of the output. Rubberband is started the way its
+    // real-time mode asks for: its preferred pad of silence in, its start delay
+    // trimmed out (otherwise the first frames come out attenuated). SoundTouch
+    // output is aligned already - it holds frames back rather than delaying them -
+    // and Superpowered reports nothing to trim.
+    void alignStreamStart(EngineGraph& g) {
+        g.compensationTrim = chainLatencyFrames(g);
+
+#if USE_RUBBERBAND
+        if (resolveEngine(g, g.applied.engine) == AudioEngineType::RUBBERBAND) {
+            for (int ch = 0; ch < g.channels; ch++) {
+                std::fill(g.rubberbandIn[ch], g.rubberbandIn[ch] + g.rubberbandBlockFrames, 0.0f);
             }
+            int pad = static_cast<int>(g.rubberbandStretcher->getPreferredStartPad());
+            while (pad > 0) {
+                int blockFrames = std::min(pad, g.rubberbandBlockFrames);
+                g.rubberbandStretcher->process(g.rubberbandIn.data(), blockFrames, false);
+                pad -= blockFrames;
+            }
+            g.compensationTrim += static_cast<int>(g.rubberbandStretcher->getStartDelay());
+        }
+#endif
+    }
+
+    // Drop the leading frames still owed to compensation from this block's output
+    int trimCompensation(EngineGraph& g, float* output, int numFrames) {
+        int trim = std::min(g.compensationTrim, numFrames);
+        if (trim <= 0) return numFrames;
+
+        std::memmove(output, output + static_cast<size_t>(trim) * g.channels,
+                     static_cast<size_t>(numFrames - trim) * g.channels * sizeof(float));
+        g.compensationTrim -= trim;
+        return numFrames - trim;
+    }
+
+    // Float core: returns frames written to output.
+    // Settled ratios go straight through; gliding ratios are stepped every sub-block.
+    int processInterleaved(EngineGraph& g, const float* input, int numFrames, float* output,
+                           int maxOutputFrames) {
+        recordHistory(g, input, numFrames);
+
+        int framesWritten = 0;
+        if (!stretchRamping(g) && !g.crossfading) {
+            framesWritten = processEngine(g, input, numFrames, output, maxOutputFrames);
         } else {
-            // No battle processing - just interleave and convert
-            for (int i = 0; i < retrievedFrames; i++) {
-                float left = leftOut[i] * 32767.0f;
-                output[i * channels] = static_cast<short>(std::clamp(left, -32768.0f, 32767.0f));
-                if (channels > 1) {
-                    float right = rightOut[i] * 32767.0f;
-                    output[i * channels + 1] = static_cast<short>(std::clamp(right, -32768.0f, 32767.0f));
-                }
+            // A crossfade also runs in sub-blocks so both engines stay in step
+            for (int offset = 0; offset < numFrames; offset += kRampSubBlockFrames) {
+                int blockFrames = std::min(kRampSubBlockFrames, numFrames - offset);
+
+                g.speedRamp.skip(blockFrames);
+                g.pitchRamp.skip(blockFrames);
+                g.rateRamp.skip(blockFrames);
+                updateStretchers(g, g.applied.useRateMode);
+
+                framesWritten += processEngine(g, input + offset * g.channels, blockFrames,
+                                               output + framesWritten * g.channels,
+                                               maxOutputFrames - framesWritten);
             }
         }
 
-        *outputSamples = totalSamples;
+        // Every engine path ends here: compensation trim, protection filters, then the meter
+        framesWritten = trimCompensation(g, output, framesWritten);
+        g.protection.process(output, framesWritten);
+        meterOutput(g, output, framesWritten);
+        latencyFrames.store(outputLatencyFrames(g), std::memory_order_relaxed);
+        return framesWritten;
+    }
+
+    // Hardware protection ceiling for float outputs (int16 gets it in the conversion).
+    // With protection off float output is left unclamped - FULL SEND.
+    void applyCeiling(const EngineGraph& g, float* output, int numFrames) {
+        if (!g.applied.hardwareProtection || numFrames <= 0) return;
+        clampBlock(output, numFrames * g.channels, g.applied.hardLimiterCeiling);
     }
+
+    // Fold this block's per-channel true peaks into the meter the control side reads
+    void meterOutput(EngineGraph& g, const float* output, int numFrames) {
+        if (numFrames <= 0) return;
+        g.outputMeter.process(output, numFrames);
+
+        const int channels = std::min(g.channels, kMaxMeterChannels);
+        for (int ch = 0; ch < channels; ch++) {
+            float peak = g.outputMeter.getChannelPeak(ch);
+            float held = meterPeaks[ch].load(std::memory_order_relaxed);
+            while (peak > held &&
+                   !meterPeaks[ch].compare_exchange_weak(held, peak, std::memory_order_relaxed)) {
+            }
+        }
+        g.outputMeter.resetPeaks();
+        meterChannels.store(channels, std::memory_order_relaxed);
+    }
+
+    // Input frames per piece: kMaxInputFrames, or fewer at slow speeds so the
+    // piece's output fits kMaxBlockOutputFrames. Uses the slower of the current
+    // and target ratio, so a glide toward slow speed is covered too.
+    int inputBlockFrames(const EngineGraph& g) const {
+        float inputPerOutput = g.applied.useRateMode
+                                   ? std::min(g.rateRamp.getCurrent(), g.applied.rate)
+                                   : std::min(g.speedRamp.getCurrent(), g.applied.speed);
+        int frames = static_cast<int>(kMaxBlockOutputFrames * inputPerOutput);
+        return std::clamp(frames, 1, kMaxInputFrames);
+    }
+
+    bool stretchRamping(const EngineGraph& g) const {
+        return g.speedRamp.isRamping() || g.pitchRamp.isRamping() || g.rateRamp.isRamping();
+    }
+
+    // -------------------------------------------------------------------------
+    // HOT ENGINE SWITCHING
+    // The incoming engine is reset, pre-rolled on recent input (output
+    // discarded) so it starts warm, lined up with the outgoing engine using
+    // each engine's reported latency, then both run side by side while an
+    // equal-power crossfade hands over. No clear, no gap.
+    // -------------------------------------------------------------------------
+
+    // The engine that actually runs for a requested type (same fallbacks as processEngine)
+    AudioEngineType resolveEngine(const EngineGraph& g, AudioEngineType engine) const {
+        if (engine == AudioEngineType::SUPERPOWERED && !g.timeStretcher) {
+            return AudioEngineType::SOUNDTOUCH;
+        }
+#if USE_RUBBERBAND
+        if (engine == AudioEngineType::RUBBERBAND && !g.rubberbandStretcher) {
+            return AudioEngineType::SOUNDTOUCH;
+        }
+#else
+        if (engine == AudioEngineType::RUBBERBAND) return AudioEngineType::SOUNDTOUCH;
 #endif
+        return engine;
+    }
 
-public:
+    void beginEngineSwitch(EngineGraph& g, AudioEngineType from, AudioEngineType to, float crossfadeMs) {
+        from = resolveEngine(g, g.crossfading ? g.crossfadeFrom : from);
+        AudioEngineType running = resolveEngine(g, g.applied.engine);
+        to = resolveEngine(g, to);
+
+        if (g.crossfading) {
+            if (to == from) {
+                // Switched back mid-fade: run the same fade in reverse, both engines are warm
+                g.crossfadeFrom = running;
+                g.crossfadePosition = g.crossfadeFrames - g.crossfadePosition;
+                return;
+            }
+            // A third engine mid-fade: drop the oldest one and fade from the current target
+            resetEngine(g, from);
+            from = running;
+        }
 
-    // Flush remaining samples
-    void flush() {
-        soundTouch->flush();
+        g.crossfading = false;
+        if (to == from) return;
+
+        resetEngine(g, to);
+        prerollEngine(g, from, to);
+
+        g.crossfading = true;
+        g.crossfadeFrom = from;
+        g.crossfadeFrames = std::max(1, static_cast<int>(g.sampleRate * crossfadeMs / 1000.0f));
+        g.crossfadePosition = 0;
     }
 
-    // Clear all buffers
-    void clear() {
-        soundTouch->clear();
+    // Output latency of an engine in output frames (how far its output trails its input)
+    int engineLatencyFrames(EngineGraph& g, AudioEngineType engine) {
+        switch (engine) {
+            case AudioEngineType::SOUNDTOUCH: {
+                float inputPerOutput = g.applied.useRateMode ? g.rateRamp.getCurrent()
+                                                             : g.speedRamp.getCurrent();
+                return static_cast<int>(g.soundTouch->getSetting(SETTING_INITIAL_LATENCY) / inputPerOutput);
+            }
+#if USE_RUBBERBAND
+            case AudioEngineType::RUBBERBAND:
+                return static_cast<int>(g.rubberbandStretcher->getStartDelay());
+#endif
+            default:
+                // Superpowered does not report its delay - use what it is holding
+                return std::max(0, static_cast<int>(std::lround(g.superpoweredBacklog)));
+        }
+    }
 
-        // Clear Superpowered
-        if (timeStretcher) {
-            timeStretcher->reset();
+    // Output latency of the battle chain: the limiter's lookahead while it runs.
+    // Superpowered has its own chain, whose limiter reports no delay.
+    int chainLatencyFrames(const EngineGraph& g) const {
+        if (resolveEngine(g, g.applied.engine) == AudioEngineType::SUPERPOWERED) return 0;
+        return (g.chainStages & kChainLimiter) ? g.limiter.getLatencyFrames() : 0;
+    }
+
+    // Total output latency: the engine now running plus the battle chain
+    // (during a crossfade the incoming engine, which is lined up with the outgoing one)
+    int outputLatencyFrames(EngineGraph& g) {
+        return engineLatencyFrames(g, resolveEngine(g, g.applied.engine)) + chainLatencyFrames(g);
+    }
+
+    // Input frames an engine needs after a reset before its output is real audio
+    int enginePrerollFrames(EngineGraph& g, AudioEngineType engine) {
+        switch (engine) {
+            case AudioEngineType::SOUNDTOUCH:
+                return g.soundTouch->getSetting(SETTING_INITIAL_LATENCY) + kPrerollMarginFrames;
+#if USE_RUBBERBAND
+            case AudioEngineType::RUBBERBAND:
+                return static_cast<int>(g.rubberbandStretcher->getPreferredStartPad()) + kPrerollMarginFrames;
+#endif
+            case AudioEngineType::SUPERPOWERED:
+                return static_cast<int>(g.timeStretcher->getNumberOfInputFramesNeeded()) + kPrerollMarginFrames;
+            default:
+                return kPrerollMarginFrames;
+        }
+    }
+
+    // Feed the incoming engine the tail of the input history and throw its output away,
+    // keeping just enough queued that it lines up with the outgoing engine
+    void prerollEngine(EngineGraph& g, AudioEngineType from, AudioEngineType to) {
+        int frames = std::min(g.historyFilled, enginePrerollFrames(g, to));
+        int keep = std::max(0, engineLatencyFrames(g, from) - engineLatencyFrames(g, to));
+
+        int position = (g.historyWrite - frames + kHistoryFrames) & (kHistoryFrames - 1);
+        while (frames > 0) {
+            int blockFrames = std::min({ frames, kRampSubBlockFrames, kHistoryFrames - position });
+            feedEngine(g, to, g.inputHistory.data() + static_cast<size_t>(position) * g.channels,
+                       blockFrames);
+            position = (position + blockFrames) & (kHistoryFrames - 1);
+            frames -= blockFrames;
+
+            // Discard from the front so the newest 'keep' frames stay queued
+            int discard = std::min(availableFrames(g, to) - keep, kMaxOutputFrames);
+            if (discard > 0) retrieveEngine(g, to, g.crossfadeBuffer.data(), discard);
+        }
+    }
+
+    void recordHistory(EngineGraph& g, const float* input, int numFrames) {
+        // Only the newest kHistoryFrames matter
+        if (numFrames > kHistoryFrames) {
+            input += static_cast<size_t>(numFrames - kHistoryFrames) * g.channels;
+            numFrames = kHistoryFrames;
+        }
+        while (numFrames > 0) {
+            int blockFrames = std::min(numFrames, kHistoryFrames - g.historyWrite);
+            std::memcpy(g.inputHistory.data() + static_cast<size_t>(g.historyWrite) * g.channels, input,
+                        static_cast<size_t>(blockFrames) * g.channels * sizeof(float));
+            g.historyWrite = (g.historyWrite + blockFrames) & (kHistoryFrames - 1);
+            g.historyFilled = std::min(g.historyFilled + blockFrames, kHistoryFrames);
+            input += static_cast<size_t>(blockFrames) * g.channels;
+            numFrames -= blockFrames;
         }
+    }
 
+    // Both engines take the same input; mix as much as both have ready
+    int processCrossfade(EngineGraph& g, const float* input, int numFrames, float* output,
+                         int maxOutputFrames) {
+        const AudioEngineType from = g.crossfadeFrom;
+        const AudioEngineType to = resolveEngine(g, g.applied.engine);
+
+        feedEngine(g, from, input, numFrames);
+        feedEngine(g, to, input, numFrames);
+
+        int frames = std::min({ availableFrames(g, from), availableFrames(g, to),
+                                maxOutputFrames, kMaxOutputFrames });
+        if (frames <= 0) return 0;
+
+        float* incoming = g.crossfadeBuffer.data();
+        retrieveEngine(g, from, output, frames);
+        retrieveEngine(g, to, incoming, frames);
+
+        // SoundTouch and Rubberband share one battle chain (stateful), so it runs once
+        // on the mix; Superpowered has its own chain, so each side gets its own
+        const bool sharedChain = (from == AudioEngineType::SUPERPOWERED) ==
+                                 (to == AudioEngineType::SUPERPOWERED);
+        if (!sharedChain) {
+            applyEngineChain(g, from, output, frames);
+            applyEngineChain(g, to, incoming, frames);
+        }
+
+        // Equal-power: out = cos(theta) * outgoing + sin(theta) * incoming
+        const float halfPi = static_cast<float>(M_PI) * 0.5f;
+        const float step = 1.0f / g.crossfadeFrames;
+        const int channels = g.channels;
+        for (int i = 0; i < frames; i++) {
+            float t = std::min(1.0f, (g.crossfadePosition + i) * step);
+            float fadeOut = std::cos(t * halfPi);
+            float fadeIn = std::sin(t * halfPi);
+            for (int ch = 0; ch < channels; ch++) {
+                int k = i * channels + ch;
+                output[k] = output[k] * fadeOut + incoming[k] * fadeIn;
+            }
+        }
+
+        if (sharedChain) {
+            applyEngineChain(g, to, output, frames);
+        }
+
+        g.crossfadePosition += frames;
+        if (g.crossfadePosition >= g.crossfadeFrames) {
+            // Handover complete: the outgoing engine goes idle with nothing queued
+            g.crossfading = false;
+            resetEngine(g, from);
+        }
+
+        return frames;
+    }
+
+    // Per-engine primitives used by pre-roll and crossfade (no battle chain)
+    void feedEngine(EngineGraph& g, AudioEngineType engine, const float* input, int numFrames) {
+        switch (engine) {
+            case AudioEngineType::SUPERPOWERED:
+                g.timeStretcher->addInput(const_cast<float*>(input), numFrames);
+                g.superpoweredBacklog += numFrames / g.timeStretcher->rate;
+                break;
 #if USE_RUBBERBAND
-        // Clear Rubberband
-        if (rubberbandStretcher) {
-            rubberbandStretcher->reset();
+            case AudioEngineType::RUBBERBAND:
+                for (int offset = 0; offset < numFrames; offset += g.rubberbandBlockFrames) {
+                    int blockFrames = std::min(g.rubberbandBlockFrames, numFrames - offset);
+                    deinterleave(input + offset * g.channels, g.rubberbandIn.data(), blockFrames,
+                                 g.channels);
+                    g.rubberbandStretcher->process(g.rubberbandIn.data(), blockFrames, false);
+                }
+                break;
+#endif
+            default:
+                g.soundTouch->putSamples(input, numFrames);
+                break;
         }
+    }
+
+    int availableFrames(EngineGraph& g, AudioEngineType engine) {
+        switch (engine) {
+            case AudioEngineType::SUPERPOWERED:
+                return static_cast<int>(g.timeStretcher->getOutputLengthFrames());
+#if USE_RUBBERBAND
+            case AudioEngineType::RUBBERBAND:
+                return std::max(0, g.rubberbandStretcher->available());
 #endif
+            default:
+                return static_cast<int>(g.soundTouch->numSamples());
+        }
+    }
 
-        limiter->reset();
-        compressor->reset();
-        bassBoost->reset();
-        subHarmonicL.reset();
-        subHarmonicR.reset();
-        exciterL.reset();
-        exciterR.reset();
+    // Pull exactly numFrames (caller checked availableFrames)
+    void retrieveEngine(EngineGraph& g, AudioEngineType engine, float* output, int numFrames) {
+        switch (engine) {
+            case AudioEngineType::SUPERPOWERED:
+                g.timeStretcher->getOutput(output, numFrames);
+                g.superpoweredBacklog -= numFrames;
+                break;
+#if USE_RUBBERBAND
+            case AudioEngineType::RUBBERBAND:
+                for (int offset = 0; offset < numFrames; offset += g.rubberbandBlockFrames) {
+                    int blockFrames = std::min(g.rubberbandBlockFrames, numFrames - offset);
+                    g.rubberbandStretcher->retrieve(g.rubberbandOut.data(), blockFrames);
+                    interleave(g.rubberbandOut.data(), output + offset * g.channels, blockFrames,
+                               g.channels);
+                }
+                break;
+#endif
+            default:
+                g.soundTouch->receiveSamples(output, numFrames);
+                break;
+        }
     }
 
-    // Get current settings
-    float getSpeed() const { return speed; }
-    float getPitch() const { return pitchSemitones; }
-    float getRate() const { return rate; }
-    bool isBattleMode() const { return battleMode; }
+    void applyEngineChain(EngineGraph& g, AudioEngineType engine, float* samples, int numFrames) {
+        if (engine == AudioEngineType::SUPERPOWERED) {
+            applySuperpoweredChain(g, samples, numFrames);
+        } else {
+            applyBattleChain(g, samples, numFrames);
+        }
+    }
 
-private:
-    void updateSoundTouch() {
-        if (!soundTouch) return;
+    void resetEngine(EngineGraph& g, AudioEngineType engine) {
+        switch (engine) {
+            case AudioEngineType::SUPERPOWERED:
+                g.timeStretcher->reset();
+                g.superpoweredBacklog = 0.0;
+                break;
+#if USE_RUBBERBAND
+            case AudioEngineType::RUBBERBAND:
+                g.rubberbandStretcher->reset();
+                break;
+#endif
+            default:
+                g.soundTouch->clear();
+                break;
+        }
+    }
+
+    // Route to the selected engine, returns frames written to output. The input is
+    // always consumed: with no output room left it is queued in the engine, and
+    // its output waits there for the next call.
+    int processEngine(EngineGraph& g, const float* input, int numFrames, float* output,
+                      int maxOutputFrames) {
+        if (numFrames <= 0) return 0;
+        maxOutputFrames = std::max(0, maxOutputFrames);
+
+        if (g.crossfading) {
+            return processCrossfade(g, input, numFrames, output, maxOutputFrames);
+        }
+
+        switch (g.applied.engine) {
+            case AudioEngineType::SUPERPOWERED:
+                return processSuperpowered(g, input, numFrames, output, maxOutputFrames);
+            case AudioEngineType::RUBBERBAND:
+#if USE_RUBBERBAND
+                return processRubberband(g, input, numFrames, output, maxOutputFrames);
+#else
+                // Rubberband not compiled, fallback to SoundTouch
+                return processSoundTouch(g, input, numFrames, output, maxOutputFrames);
+#endif
+            case AudioEngineType::SOUNDTOUCH:
+            default:
+                return processSoundTouch(g, input, numFrames, output, maxOutputFrames);
+        }
+    }
+
+    // Battle chain for the SoundTouch and Rubberband engines (in place, interleaved float)
+    // EQ -> bass boost -> sub-harmonic -> exciter -> compressor -> limiter, fused into one pass.
+    // The kernel is selected when settings change; battle mode off selects a no-op.
+    void applyBattleChain(EngineGraph& g, float* samples, int numFrames) {
+        applyChainExtras(g, samples, numFrames);
+        g.chainKernel(g.chain, samples, numFrames);
+    }
+
+    // MegaBass and parallel compression: their own passes ahead of the fused chain,
+    // so its compressor and limiter still catch what they add. Both idle at 0.
+    void applyChainExtras(EngineGraph& g, float* samples, int numFrames) {
+        if (!g.applied.battleMode) return;
+        g.megaBass.process(samples, numFrames);
+        g.parallelCompressor.process(samples, numFrames);
+    }
+
+    // 10-band EQ + psychoacoustic bass enhancement (adds perceived loudness without gain)
+    void applyPsychoacousticBass(EngineGraph& g, float* samples, int numFrames) {
+        g.psychoacousticKernel(g.chain, samples, numFrames);
+    }
+
+    // Which chain stages currently do anything
+    unsigned activeChainStages(const EngineGraph& g) const {
+        const EngineParams& p = g.applied;
+        unsigned stages = 0;
+        if (g.equalizer.isEnabled()) stages |= kChainEqualizer;  // includes a glide back to flat
+        if (g.bassBoost.isEnabled()) stages |= kChainBassBoost;  // includes a fade-out glide
+        if (p.subHarmonicAmount > 0) stages |= kChainSubHarmonic;
+        if (p.exciterAmount > 0) stages |= kChainExciter;
+        if (g.compressor.isEnabled()) stages |= kChainCompressor;
+        if (p.limiterEnabled && g.limiter.isEnabled()) stages |= kChainLimiter;
+        return stages;
+    }
+
+    // Process using SoundTouch engine (float in, float out)
+    int processSoundTouch(EngineGraph& g, const float* input, int numFrames, float* output,
+                          int maxOutputFrames) {
+        // Feed samples to SoundTouch
+        g.soundTouch->putSamples(input, numFrames);
+
+        // Receive processed samples straight into the caller's buffer
+        int receivedFrames = g.soundTouch->receiveSamples(output, maxOutputFrames);
+        if (receivedFrames <= 0) return 0;
+
+        // Apply battle processing chain (no-op kernel when battle mode is off)
+        applyBattleChain(g, output, receivedFrames);
+
+        return receivedFrames;
+    }
+
+    // Process using Superpowered engine (DJ-grade quality)
+    int processSuperpowered(EngineGraph& g, const float* input, int numFrames, float* output,
+                            int maxOutputFrames) {
+        if (!g.timeStretcher) {
+            // Fallback to SoundTouch if Superpowered not available
+            return processSoundTouch(g, input, numFrames, output, maxOutputFrames);
+        }
+
+        // Configure time stretcher
+        g.timeStretcher->rate = superpoweredRate(g.speedRamp.getCurrent());
+        int pitchCents = static_cast<int>(g.pitchRamp.getCurrent() * 100.0f);
+        g.timeStretcher->pitchShiftCents = std::clamp(pitchCents, -2400, 2400);
+
+        // Process with Superpowered TimeStretching (reads interleaved float, never writes it)
+        g.timeStretcher->addInput(const_cast<float*>(input), numFrames);
+        g.superpoweredBacklog += numFrames / g.timeStretcher->rate;
+
+        // getOutput() returns a success flag, not a count - ask for what is ready
+        int receivedFrames = std::min(static_cast<int>(g.timeStretcher->getOutputLengthFrames()),
+                                      maxOutputFrames);
+        if (receivedFrames <= 0 || !g.timeStretcher->getOutput(output, receivedFrames)) {
+            return 0;
+        }
+        g.superpoweredBacklog -= receivedFrames;
+
+        applySuperpoweredChain(g, output, receivedFrames);
+
+        return receivedFrames;
+    }
+
+    // TimeStretching's supported range; the backlog estimate divides by the same value
+    static float superpoweredRate(float speed) {
+        return std::clamp(speed, 0.25f, 4.0f);
+    }
+
+    // Superpowered effects chain (only while battle mode is enabled)
+    void applySuperpoweredChain(EngineGraph& g, float* output, int numFrames) {
+        const EngineParams& p = g.applied;
+        if (!p.battleMode) return;
+
+        applyChainExtras(g, output, numFrames);
+
+        // Use Superpowered's own high-quality effects
+        if (g.spEQ && p.bassBoostAmount > 0) {
+            g.spEQ->process(output, output, numFrames);
+        }
+
+        // 10-band EQ + psychoacoustic enhancement (still use our custom processors)
+        applyPsychoacousticBass(g, output, numFrames);
+
+        // Superpowered Compressor
+        if (g.spCompressor) {
+            g.spCompressor->process(output, output, numFrames);
+        }
+
+        // Superpowered Limiter
+        if (g.spLimiter && p.limiterEnabled) {
+            g.spLimiter->process(output, output, numFrames);
+        }
+    }
+
+#if USE_RUBBERBAND
+    // Process using Rubberband engine (Studio-grade, 10/10 quality)
+    // Zero-allocation: all planar buffers come from rubberbandScratch (sized at build time)
+    int processRubberband(EngineGraph& g, const float* input, int numFrames, float* output,
+                          int maxOutputFrames) {
+        if (!g.rubberbandStretcher || g.rubberbandBlockFrames <= 0) {
+            // Fallback to SoundTouch if Rubberband not available
+            return processSoundTouch(g, input, numFrames, output, maxOutputFrames);
+        }
+
+        int framesWritten = 0;
+
+        // Feed Rubberband in arena-sized blocks, draining output after each one
+        for (int offset = 0; offset < numFrames; offset += g.rubberbandBlockFrames) {
+            int blockFrames = std::min(g.rubberbandBlockFrames, numFrames - offset);
+
+            // Deinterleave (Rubberband expects separate channels)
+            deinterleave(input + offset * g.channels, g.rubberbandIn.data(), blockFrames, g.channels);
+
+            g.rubberbandStretcher->process(g.rubberbandIn.data(), blockFrames, false);
+            framesWritten += retrieveRubberband(g, output + framesWritten * g.channels,
+                                                maxOutputFrames - framesWritten);
+        }
+
+        return framesWritten;
+    }
+
+    // Pull what Rubberband has ready (up to maxOutputFrames), interleave, run the battle chain.
+    // Anything that does not fit stays inside Rubberband for the next call.
+    int retrieveRubberband(EngineGraph& g, float* output, int maxOutputFrames) {
+        int framesWritten = 0;
+
+        int availableFrames = std::min(g.rubberbandStretcher->available(), maxOutputFrames);
+        while (availableFrames > 0) {
+            int blockFrames = std::min(availableFrames, g.rubberbandBlockFrames);
+            int retrievedFrames = static_cast<int>(
+                g.rubberbandStretcher->retrieve(g.rubberbandOut.data(), blockFrames));
+            if (retrievedFrames <= 0) break;
+
+            float* blockOutput = output + framesWritten * g.channels;
+            interleave(g.rubberbandOut.data(), blockOutput, retrievedFrames, g.channels);
+
+            // Apply battle processing chain (no-op kernel when battle mode is off)
+            applyBattleChain(g, blockOutput, retrievedFrames);
+
+            framesWritten += retrievedFrames;
+            availableFrames = std::min(g.rubberbandStretcher->available(),
+                                       maxOutputFrames - framesWritten);
+        }
+
+        return framesWritten;
+    }
+#endif
+
+    // Push the current (possibly mid-glide) speed/pitch/rate to every stretcher in the graph
+    void updateStretchers(EngineGraph& g, bool useRateMode) {
+        const float speed = g.speedRamp.getCurrent();
+        const float pitchSemitones = g.pitchRamp.getCurrent();
 
         if (useRateMode) {
             // Rate mode: changes both speed and pitch together (vinyl-style)
-            soundTouch->setRate(rate);
-            soundTouch->setTempo(1.0f);
-            soundTouch->setPitch(1.0f);
+            g.soundTouch->setRate(g.rateRamp.getCurrent());
+            g.soundTouch->setTempo(1.0f);
+            g.soundTouch->setPitch(1.0f);
         } else {
             // Normal mode: independent speed and pitch control
-            soundTouch->setRate(1.0f);
-            soundTouch->setTempo(speed);
+            g.soundTouch->setRate(1.0f);
+            g.soundTouch->setTempo(speed);
             // Convert semitones to pitch multiplier: 2^(semitones/12)
             float pitchMultiplier = std::pow(2.0f, pitchSemitones / 12.0f);
-            soundTouch->setPitch(pitchMultiplier);
+            g.soundTouch->setPitch(pitchMultiplier);
         }
 
-        LOGI("SoundTouch updated: speed=%.2f, pitch=%.1f semitones", speed, pitchSemitones);
-
         // Also update Superpowered if available
-        if (timeStretcher) {
-            timeStretcher->rate = std::clamp(speed, 0.25f, 4.0f);
+        if (g.timeStretcher) {
+            g.timeStretcher->rate = superpoweredRate(speed);
             int pitchCents = static_cast<int>(pitchSemitones * 100.0f);
-            timeStretcher->pitchShiftCents = std::clamp(pitchCents, -2400, 2400);
+            g.timeStretcher->pitchShiftCents = std::clamp(pitchCents, -2400, 2400);
         }
 
 #if USE_RUBBERBAND
         // Also update Rubberband if available
-        if (rubberbandStretcher) {
-            rubberbandStretcher->setTimeRatio(1.0 / speed);  // Inverse: slower speed = higher ratio
-            rubberbandStretcher->setPitchScale(std::pow(2.0, pitchSemitones / 12.0));
-        }
+        applyRubberbandRatios(g, speed, pitchSemitones);
 #endif
     }
 
-    // Current audio engine (user selectable at runtime)
-    AudioEngineType currentEngine = AudioEngineType::SOUNDTOUCH;
-
-    // Superpowered SDK components (DJ-grade processing)
-    Superpowered::TimeStretching* timeStretcher = nullptr;
-    Superpowered::Compressor* spCompressor = nullptr;
-    Superpowered::Limiter* spLimiter = nullptr;
-    Superpowered::ThreeBandEQ* spEQ = nullptr;
-
 #if USE_RUBBERBAND
-    // Rubberband engine (Studio-grade, 10/10 quality)
-    RubberBandStretcher* rubberbandStretcher = nullptr;
-#endif
-
-    // SoundTouch engine (FREE, no license)
-    soundtouch::SoundTouch* soundTouch = nullptr;
+    // Push speed/pitch to Rubberband only when they actually changed
+    void applyRubberbandRatios(EngineGraph& g, float speed, float pitchSemitones) {
+        if (!g.rubberbandStretcher) return;
 
-    // Battle processing chain (used by SoundTouch engine)
-    BattleLimiter* limiter = nullptr;
-    BattleCompressor* compressor = nullptr;
-    BattleBassBoost* bassBoost = nullptr;
+        double timeRatio = 1.0 / speed;  // Inverse: slower speed = higher ratio
+        double pitchScale = std::pow(2.0, pitchSemitones / 12.0);
 
-    // Psychoacoustic bass enhancement (no gain, perceived loudness)
-    SubHarmonicSynthesizer subHarmonicL;
-    SubHarmonicSynthesizer subHarmonicR;
-    BassExciter exciterL;
-    BassExciter exciterR;
-    float subHarmonicAmount = 0.0f;
-    float exciterAmount = 0.0f;
-
-    int sampleRate = 44100;
-    int channels = 2;
-
-    float speed = 1.0f;
-    float pitchSemitones = 0.0f;
-    float rate = 1.0f;
-    float bassBoostAmount = 0.0f;
+        if (timeRatio != g.rubberbandTimeRatio) {
+            g.rubberbandStretcher->setTimeRatio(timeRatio);
+            g.rubberbandTimeRatio = timeRatio;
+        }
+        if (pitchScale != g.rubberbandPitchScale) {
+            g.rubberbandStretcher->setPitchScale(pitchScale);
+            g.rubberbandPitchScale = pitchScale;
+        }
+    }
+#endif
 
-    bool formantPreservation = true;
-    bool battleMode = false;
-    bool useRateMode = false;
     bool superpoweredAvailable = false;
     bool rubberbandAvailable = false;
-    bool limiterEnabled = true;  // FULL SEND toggle - when false, no limiting
-
-    // Hardware Protection (strongest safety)
-    bool hardwareProtection = true;  // Default ON - protect speakers
-    float hardLimiterCeiling = 0.944f;  // -0.5dB hard ceiling
-    bool subBassFilterEnabled = true;  // Remove <20Hz rumble
-    bool dcBlockerEnabled = true;  // Remove DC offset
-    float dcBlockerState = 0.0f;
 
-    // Audiophile Mode (pure quality)
-    bool audiophileMode = false;  // Default OFF - battle ready
-    bool clarityEnhanceEnabled = false;
-    float clarityAmount = 0.0f;
-    bool ditheringEnabled = false;
-
-    // Buffers for audio processing
-    std::vector<float> floatInputBuffer;
-    std::vector<float> floatOutputBuffer;
-    std::vector<short> shortOutputBuffer;
+    // Control side: settings as last written by a setter (guarded by paramsMutex)
+    mutable std::mutex paramsMutex;
+    EngineParams pendingParams;
+
+    // Control -> audio handoff
+    TripleBuffer<EngineParams> params;
+    std::atomic<bool> clearRequested{ false };
+    std::atomic<bool> flushRequested{ false };
+
+    // Audio -> control: output true-peak hold (linear), see readTruePeaks()
+    std::atomic<float> meterPeaks[kMaxMeterChannels] = {};
+    std::atomic<int> meterChannels{ 2 };
+
+    // Audio -> control: output latency in frames, see getLatencyFrames()
+    std::atomic<int> latencyFrames{ 0 };
+
+    // Live graph (audio thread reads it once per block) and its retirement
+    std::atomic<EngineGraph*> graph{ nullptr };
+    AudioEpoch audioEpoch;
+    Scavenger<EngineGraph> graphScavenger;
+
+    // Zero-copy I/O registered via setDirectBuffers (not owned), handed to the
+    // audio thread as one snapshot; directEpoch is odd while processDirect() runs
+    struct DirectBuffers {
+        const void* input = nullptr;
+        void* output = nullptr;
+        int inputSamples = 0;
+        int outputSamples = 0;
+        bool floatSamples = false;
+    };
+    TripleBuffer<DirectBuffers> directBuffers;
+    AudioEpoch directEpoch;
 };
 
 // =============================================================================
@@ -969,17 +2176,14 @@ private:
 
 extern "C" {
 
-static BattleAudioEngineImpl* engine = nullptr;
-
+// Every handle is an independent engine (decks, samplers); no global instance
 void* battle_engine_create() {
-    engine = new BattleAudioEngineImpl();
-    return engine;
+    return new BattleAudioEngineImpl();
 }
 
 void battle_engine_destroy(void* handle) {
     if (handle) {
         delete static_cast<BattleAudioEngineImpl*>(handle);
-        if (engine == handle) engine = nullptr;
     }
 }
 
@@ -1019,6 +2223,18 @@ void battle_engine_set_bass_boost(void* handle, float amount) {
     }
 }
 
+void battle_engine_set_eq_enabled(void* handle, bool enabled) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->setEqEnabled(enabled);
+    }
+}
+
+void battle_engine_set_eq_band(void* handle, int band, float gainDb) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->setEqBand(band, gainDb);
+    }
+}
+
 void battle_engine_set_sub_harmonic(void* handle, float amount) {
     if (handle) {
         static_cast<BattleAudioEngineImpl*>(handle)->setSubHarmonicAmount(amount);
@@ -1031,6 +2247,18 @@ void battle_engine_set_exciter(void* handle, float amount) {
     }
 }
 
+void battle_engine_set_mega_bass(void* handle, float intensity) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->setMegaBassIntensity(intensity);
+    }
+}
+
+void battle_engine_set_parallel_compression(void* handle, float mix) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->setParallelCompressionMix(mix);
+    }
+}
+
 void battle_engine_set_limiter_enabled(void* handle, bool enabled) {
     if (handle) {
         static_cast<BattleAudioEngineImpl*>(handle)->setLimiterEnabled(enabled);
@@ -1049,6 +2277,12 @@ void battle_engine_set_audiophile_mode(void* handle, bool enabled) {
     }
 }
 
+void battle_engine_set_dither_mode(void* handle, int mode) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->setDitherMode(mode);
+    }
+}
+
 void battle_engine_process(void* handle, const short* input, int numSamples,
                            short* output, int* outputSamples) {
     if (handle) {
@@ -1057,6 +2291,77 @@ void battle_engine_process(void* handle, const short* input, int numSamples,
     }
 }
 
+// int16 with the output capacity (samples) - never writes past maxOutputSamples
+void battle_engine_process_int16(void* handle, const short* input, int numSamples,
+                                 short* output, int maxOutputSamples, int* outputSamples) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->processInt16(
+            input, numSamples, output, maxOutputSamples, outputSamples);
+    }
+}
+
+void battle_engine_process_float(void* handle, const float* input, int numSamples,
+                                 float* output, int maxOutputSamples, int* outputSamples) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->processFloat(
+            input, numSamples, output, maxOutputSamples, outputSamples);
+    }
+}
+
+void battle_engine_process_planar(void* handle, const float* const* input, int numFrames,
+                                  float* const* output, int maxOutputFrames, int* outputFrames) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->processPlanar(
+            input, numFrames, output, maxOutputFrames, outputFrames);
+    }
+}
+
+// Mix `count` engines into one interleaved float output: engine i consumes
+// inputSamples[i] samples of inputs[i] and is summed with gains[i].
+// Returns the number of output samples written.
+int battle_engine_mix(void* const* handles, const float* const* inputs, const int* inputSamples,
+                      const float* gains, int count, float* output, int maxOutputSamples) {
+    if (!handles || !inputs || !inputSamples || !gains || !output) return 0;
+    return BattleAudioEngineImpl::mix(handles, inputs, inputSamples, gains, count,
+                                      output, maxOutputSamples);
+}
+
+long long battle_engine_render_file(void* handle, const char* inputPath, const char* outputPath,
+                                    bool floatOutput) {
+    if (handle) {
+        return static_cast<BattleAudioEngineImpl*>(handle)->renderFile(inputPath, outputPath,
+                                                                       floatOutput);
+    }
+    return -1;
+}
+
+int battle_engine_render_batch(void* const* settings, const char* const* inputPaths,
+                               const char* const* outputPaths, const float* speeds,
+                               const float* pitches, int count, bool floatOutput, int threads,
+                               long long* framesWritten) {
+    if (!settings || !inputPaths || !outputPaths || !speeds || !pitches || !framesWritten) {
+        return 0;
+    }
+    return BattleAudioEngineImpl::renderBatch(settings, inputPaths, outputPaths, speeds, pitches,
+                                              count, floatOutput, threads, framesWritten);
+}
+
+bool battle_engine_set_direct_buffers(void* handle, void* input, size_t inputBytes,
+                                      void* output, size_t outputBytes, bool floatSamples) {
+    if (handle) {
+        return static_cast<BattleAudioEngineImpl*>(handle)->setDirectBuffers(
+            input, inputBytes, output, outputBytes, floatSamples);
+    }
+    return false;
+}
+
+int battle_engine_process_direct(void* handle, int numSamples) {
+    if (handle) {
+        return static_cast<BattleAudioEngineImpl*>(handle)->processDirect(numSamples);
+    }
+    return 0;
+}
+
 void battle_engine_flush(void* handle) {
     if (handle) {
         static_cast<BattleAudioEngineImpl*>(handle)->flush();
@@ -1083,6 +2388,32 @@ int battle_engine_get_audio_engine(void* handle) {
     return 0;  // Default to SoundTouch
 }
 
+void battle_engine_set_engine_crossfade(void* handle, float milliseconds) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->setEngineCrossfade(milliseconds);
+    }
+}
+
+int battle_engine_read_true_peaks(void* handle, float* peaksDb, int maxChannels) {
+    if (handle && peaksDb && maxChannels > 0) {
+        return static_cast<BattleAudioEngineImpl*>(handle)->readTruePeaks(peaksDb, maxChannels);
+    }
+    return 0;
+}
+
+int battle_engine_get_latency_frames(void* handle) {
+    if (handle) {
+        return static_cast<BattleAudioEngineImpl*>(handle)->getLatencyFrames();
+    }
+    return 0;
+}
+
+void battle_engine_set_latency_compensation(void* handle, bool enabled) {
+    if (handle) {
+        static_cast<BattleAudioEngineImpl*>(handle)->setLatencyCompensation(enabled);
+    }
+}
+
 } // extern "C"
 
 } // namespace ultramusic
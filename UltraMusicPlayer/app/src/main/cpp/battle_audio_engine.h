@@ -12,12 +12,18 @@
 #ifndef BATTLE_AUDIO_ENGINE_H
 #define BATTLE_AUDIO_ENGINE_H
 
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <cmath>
 
+#include "battle_vector_ops.h"
+
 namespace ultramusic {
 
+// Fused chain kernel (battle_chain.cpp) reads processor state directly
+template <int Channels, unsigned Stages> struct BattleChainKernel;
+
 // =============================================================================
 // AUDIO ENGINE TYPE - User can select at runtime
 // =============================================================================
@@ -28,13 +34,136 @@ enum class AudioEngineType {
     RUBBERBAND = 2     // Studio-grade, best quality (used by DAWs)
 };
 
+// =============================================================================
+// LINEAR RAMP - Glides a parameter to its new value instead of jumping
+// Setters call setTarget(); the audio path steps it once per frame (next())
+// or fills a whole block of values at once (fill()).
+// =============================================================================
+
+// How long a parameter change takes to settle (short enough to feel instant)
+constexpr float kParameterRampMs = 20.0f;
+
+inline int parameterRampFrames(int sampleRate) {
+    return std::max(1, static_cast<int>(sampleRate * kParameterRampMs / 1000.0f));
+}
+
+class LinearRamp {
+public:
+    LinearRamp() = default;
+    explicit LinearRamp(float value) : current(value), target(value) {}
+
+    // Glide to value over rampFrames frames (0 = jump)
+    void setTarget(float value, int rampFrames) {
+        target = value;
+        if (rampFrames <= 0 || value == current) {
+            finish();
+            return;
+        }
+        step = (target - current) / rampFrames;
+        remaining = rampFrames;
+    }
+
+    // Jump straight to the target
+    void finish() {
+        current = target;
+        step = 0.0f;
+        remaining = 0;
+    }
+
+    bool isRamping() const { return remaining > 0; }
+    float getCurrent() const { return current; }
+    float getTarget() const { return target; }
+
+    // Advance one frame and return the new value
+    float next() {
+        if (remaining > 0) {
+            current += step;
+            if (--remaining == 0) current = target;
+        }
+        return current;
+    }
+
+    // Advance numFrames frames without producing values
+    void skip(int numFrames) {
+        if (remaining <= 0) return;
+        if (numFrames >= remaining) {
+            finish();
+        } else {
+            current += step * numFrames;
+            remaining -= numFrames;
+        }
+    }
+
+    // Write the next numFrames values to output (vectorized while ramping)
+    void fill(float* output, int numFrames) {
+        int ramped = std::min(numFrames, remaining);
+        if (ramped > 0) {
+            fillRamp(output, current, step, ramped);
+            skip(ramped);
+        }
+        std::fill(output + ramped, output + numFrames, current);
+    }
+
+private:
+    float current = 0.0f;
+    float target = 0.0f;
+    float step = 0.0f;
+    int remaining = 0;
+};
+
+// =============================================================================
+// TRUE PEAK DETECTOR - ITU-R BS.1770 style inter-sample peak detection
+// Each channel is upsampled 4x through a 48-tap polyphase FIR (4 phases of
+// 12 taps) and the largest interpolated magnitude is the true peak. Filter
+// history persists across blocks, so peaks straddling block edges are found.
+// Implementation: battle_limiter.cpp (SIMD over the 4 phases).
+// =============================================================================
+
+class TruePeakDetector {
+public:
+    static constexpr int kOversampling = 4;
+    static constexpr int kTaps = 12;                 // Per phase
+    static constexpr int kDelayFrames = kTaps / 2;   // Group delay of the interpolator
+    static constexpr int kChunkFrames = 256;         // Work buffer size
+
+    TruePeakDetector() = default;
+
+    void configure(int channels);
+    void reset();
+
+    // Stream numFrames interleaved frames. framePeaks (optional) receives the
+    // true peak of each frame, max over channels, kDelayFrames late.
+    // Returns the block's true peak over all channels.
+    float process(const float* samples, int numFrames, float* framePeaks = nullptr);
+
+    // Highest true peak per channel since the last resetPeaks() (linear)
+    float getChannelPeak(int channel) const { return channelPeaks[channel]; }
+    int getChannels() const { return channels; }
+    void resetPeaks() { std::fill(channelPeaks.begin(), channelPeaks.end(), 0.0f); }
+
+private:
+    int channels = 0;
+
+    // Per channel: (kTaps - 1) history samples followed by the current chunk
+    std::vector<float> lines;
+    std::vector<float> channelPeaks;
+};
+
+// One-shot true peak of an interleaved buffer (fresh filter state)
+float detectTruePeak(const float* samples, int numSamples, int channels);
+
 // =============================================================================
 // BATTLE LIMITER - Prevents clipping at extreme volumes
+// True lookahead: audio runs through a short delay line while the gain for
+// each sample is planned from the (4x oversampled, true) peaks still ahead
+// of it.
 // =============================================================================
 
 class BattleLimiter {
 public:
     BattleLimiter() = default;
+
+    template <int Channels, unsigned Stages> friend struct BattleChainKernel;
     
     void configure(int sampleRate, int channels) {
         this->sampleRate = sampleRate;
@@ -44,15 +173,29 @@ public:
         attackSamples = static_cast<int>(attackMs * sampleRate / 1000.0f);
         releaseSamples = static_cast<int>(releaseMs * sampleRate / 1000.0f);
         
-        // Lookahead buffer
-        lookaheadSamples = static_cast<int>(lookaheadMs * sampleRate / 1000.0f);
-        lookaheadBuffer.resize(lookaheadSamples * channels, 0.0f);
-        lookaheadIndex = 0;
+        // Lookahead buffer (the delay line) and the gain planner around it
+        // The delay also covers the true-peak interpolator's group delay
+        lookaheadSamples = std::max(1, static_cast<int>(lookaheadMs * sampleRate / 1000.0f));
+        delaySamples = lookaheadSamples + TruePeakDetector::kDelayFrames;
+        lookaheadBuffer.assign(delaySamples * channels, 0.0f);
+        truePeak.configure(channels);
+
+        // Attack ramp must finish inside the lookahead to land on time
+        attackSamples = std::clamp(attackSamples, 1, lookaheadSamples);
+        attackHistory.assign(attackSamples, 1.0f);
+
+        // Sliding-minimum deque over lookahead + 1 frames (power of two ring)
+        int capacity = 1;
+        while (capacity < lookaheadSamples + 2) capacity <<= 1;
+        windowGain.assign(capacity, 1.0f);
+        windowFrame.assign(capacity, 0u);
+        windowMask = capacity - 1;
         
         reset();
     }
     
     void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
     void setThreshold(float thresholdDb) { 
         this->thresholdDb = thresholdDb;
         threshold = std::pow(10.0f, thresholdDb / 20.0f);
@@ -61,50 +204,104 @@ public:
         this->ceilingDb = ceilingDb;
         ceiling = std::pow(10.0f, ceilingDb / 20.0f);
     }
+
+    // Frames of delay the lookahead adds to the signal
+    int getLatencyFrames() const { return delaySamples; }
     
     void process(float* samples, int numSamples) {
         if (!enabled) return;
         
-        for (int i = 0; i < numSamples; i += channels) {
-            // Find peak in this frame
-            float peak = 0.0f;
-            for (int ch = 0; ch < channels; ch++) {
-                peak = std::max(peak, std::abs(samples[i + ch]));
+        const int numFrames = numSamples / channels;
+        float gains[kBlockFrames];
+        for (int start = 0; start < numFrames; start += kBlockFrames) {
+            const int blockFrames = std::min(kBlockFrames, numFrames - start);
+            float* block = samples + start * channels;
+
+            // True peak of each incoming frame -> gain for each frame leaving the delay line
+            truePeak.process(block, blockFrames, gains);
+            for (int i = 0; i < blockFrames; i++) {
+                gains[i] = planGain(gains[i]);
             }
-            
-            // Calculate gain reduction
-            float targetGain = 1.0f;
-            if (peak > threshold) {
-                targetGain = threshold / peak;
-            }
-            
-            // Smooth gain changes
-            if (targetGain < currentGain) {
-                // Attack - fast
-                currentGain = currentGain + (targetGain - currentGain) * attackCoeff;
-            } else {
-                // Release - slow
-                currentGain = currentGain + (targetGain - currentGain) * releaseCoeff;
-            }
-            
-            // Apply gain with soft knee
-            float gain = std::min(currentGain, 1.0f);
-            for (int ch = 0; ch < channels; ch++) {
-                samples[i + ch] *= gain;
-                
-                // Hard clip at ceiling (safety)
-                samples[i + ch] = std::clamp(samples[i + ch], -ceiling, ceiling);
+            delayFrames(block, blockFrames);
+
+            for (int i = 0; i < blockFrames; i++) {
+                for (int ch = 0; ch < channels; ch++) {
+                    float sample = block[i * channels + ch] * gains[i];
+                    
+                    // Hard clip at ceiling (safety - the lookahead keeps it idle)
+                    block[i * channels + ch] = std::clamp(sample, -ceiling, ceiling);
+                }
             }
         }
     }
     
     void reset() {
         currentGain = 1.0f;
-        attackCoeff = 1.0f - std::exp(-2.2f / attackSamples);
-        releaseCoeff = 1.0f - std::exp(-2.2f / releaseSamples);
+        releaseGain = 1.0f;
+        releaseCoeff = 1.0f - std::exp(-2.2f / std::max(1, releaseSamples));
+
+        std::fill(lookaheadBuffer.begin(), lookaheadBuffer.end(), 0.0f);
+        lookaheadIndex = 0;
+        truePeak.reset();
+
+        windowHead = 0;
+        windowTail = 0;
+        frameCounter = 0;
+
+        std::fill(attackHistory.begin(), attackHistory.end(), 1.0f);
+        attackIndex = 0;
+        attackSum = static_cast<double>(attackHistory.size());
     }
     
 private:
+    // Feed the peak of the newest frame; returns the gain for the frame now
+    // leaving the delay line. O(1) amortized:
+    //   1. required gain for this frame (threshold / peak)
+    //   2. minimum over the lookahead window (monotonic deque)
+    //   3. instant drop, exponential release
+    //   4. moving average over the attack span - a linear ramp that is
+    //      guaranteed to reach each peak's gain before the peak comes out
+    float planGain(float peak) {
+        float required = peak > threshold ? threshold / peak : 1.0f;
+
+        // Deque holds increasing gains; anything not smaller than the newcomer can never be the minimum
+        while (windowTail != windowHead && windowGain[(windowTail - 1) & windowMask] >= required) {
+            windowTail--;
+        }
+        windowGain[windowTail & windowMask] = required;
+        windowFrame[windowTail & windowMask] = frameCounter;
+        windowTail++;
+        while (frameCounter - windowFrame[windowHead & windowMask] > static_cast<uint32_t>(lookaheadSamples)) {
+            windowHead++;
+        }
+        float held = windowGain[windowHead & windowMask];
+        frameCounter++;
+
+        if (held < releaseGain) {
+            releaseGain = held;
+        } else {
+            releaseGain += (held - releaseGain) * releaseCoeff;
+        }
+
+        attackSum += releaseGain - attackHistory[attackIndex];
+        attackHistory[attackIndex] = releaseGain;
+        if (++attackIndex == static_cast<int>(attackHistory.size())) attackIndex = 0;
+
+        currentGain = std::min(static_cast<float>(attackSum / attackHistory.size()), 1.0f);
+        return currentGain;
+    }
+
+    // Swap numFrames interleaved frames through the delay line in place
+    void delayFrames(float* samples, int numFrames) {
+        const int total = delaySamples * channels;
+        for (int k = 0; k < numFrames * channels; k++) {
+            float delayed = lookaheadBuffer[lookaheadIndex];
+            lookaheadBuffer[lookaheadIndex] = samples[k];
+            samples[k] = delayed;
+            if (++lookaheadIndex == total) lookaheadIndex = 0;
+        }
+    }
+
     bool enabled = true;
     int sampleRate = 44100;
     int channels = 2;
@@ -114,304 +311,479 @@ private:
     float threshold = 0.966f;
     float ceiling = 0.989f;
     
-    float attackMs = 0.5f;      // Very fast attack
+    float attackMs = 0.5f;      // Very fast attack (ramp length, inside the lookahead)
     float releaseMs = 100.0f;   // Smooth release
     float lookaheadMs = 1.5f;   // Lookahead for true peak limiting
     
     int attackSamples = 22;
     int releaseSamples = 4410;
     int lookaheadSamples = 66;
+    int delaySamples = 72;
+
+    static constexpr int kBlockFrames = 64;
     
-    float attackCoeff = 0.1f;
     float releaseCoeff = 0.001f;
+    float releaseGain = 1.0f;
     float currentGain = 1.0f;
     
+    // Peak detection (inter-sample overs included)
+    TruePeakDetector truePeak;
+
+    // Delay line
     std::vector<float> lookaheadBuffer;
     int lookaheadIndex = 0;
+
+    // Sliding minimum of required gain (monotonic deque in a ring)
+    std::vector<float> windowGain;
+    std::vector<uint32_t> windowFrame;
+    uint32_t windowMask = 0;
+    uint32_t windowHead = 0;
+    uint32_t windowTail = 0;
+    uint32_t frameCounter = 0;
+
+    // Attack ramp (moving average)
+    std::vector<float> attackHistory;
+    int attackIndex = 0;
+    double attackSum = 0.0;
 };
 
 // =============================================================================
-// BATTLE COMPRESSOR - Adds punch and presence
+// COMPRESSOR GAIN COMPUTER - Log-domain, soft knee, whole blocks at a time
+// gains[i] = linear gain for calculateGainReduction(envelope[i]) with the ratio
+// given per frame as slopes[i] = 1/ratio - 1. Works in log2 units (6.02 dB)
+// on the fast SIMD log2/exp2, about 1e-5 dB from the libm version (checked per
+// path by ultramusic_bench --gain-check).
+// envelope and gains may be the same buffer.
+// Implementation: battle_compressor.cpp
+// =============================================================================
+
+void computeCompressorGains(const float* envelope, const float* slopes, float* gains,
+                            int numFrames, float thresholdDb, float kneeDb);
+
+// Scalar libm reference: gain change in dB (<= 0) for a level in dB
+float calculateGainReduction(float inputDb, float threshold, float ratio, float knee);
+
+// =============================================================================
+// MULTIBAND COMPRESSOR - Punch in the mids, weight in the lows
+// Four bands split by Linkwitz-Riley (LR4) crossovers, 120 Hz / 1 kHz / 6 kHz.
+// The split is a tree (1 kHz first, then 120 Hz and 6 kHz) and each branch
+// gets the other branch's crossover as an allpass, so with no gain change
+// the bands sum back to a flat (allpass) response.
+//
+// Structure-of-arrays, one lane per band: a frame runs the whole crossover
+// tree, the envelopes and the log-domain gain curve as 4-wide vector ops,
+// so four bands cost little more than one.
+// Implementation: battle_compressor.cpp
 // =============================================================================
 
-class BattleCompressor {
+class MultibandCompressor {
 public:
-    BattleCompressor() = default;
-    
-    void configure(int sampleRate, int channels) {
-        this->sampleRate = sampleRate;
-        this->channels = channels;
-        reset();
-    }
-    
+    static constexpr int kBands = 4;
+    static constexpr int kSections = 5;  // Biquads per lane: LR4 + LR4 + allpass
+
+    MultibandCompressor() = default;
+
+    void configure(int sampleRate, int channels);
+
     void setEnabled(bool enabled) { this->enabled = enabled; }
-    void setThreshold(float thresholdDb) { 
-        this->thresholdDb = thresholdDb;
-        threshold = std::pow(10.0f, thresholdDb / 20.0f);
-    }
-    void setRatio(float ratio) { this->ratio = std::max(1.0f, ratio); }
-    void setAttack(float attackMs) { this->attackMs = attackMs; }
-    void setRelease(float releaseMs) { this->releaseMs = releaseMs; }
-    void setMakeupGain(float gainDb) { 
-        this->makeupGainDb = gainDb;
-        makeupGain = std::pow(10.0f, gainDb / 20.0f);
-    }
-    
-    void process(float* samples, int numSamples) {
-        if (!enabled) return;
-        
-        float attackCoeff = std::exp(-1.0f / (attackMs * sampleRate / 1000.0f));
-        float releaseCoeff = std::exp(-1.0f / (releaseMs * sampleRate / 1000.0f));
-        
-        for (int i = 0; i < numSamples; i += channels) {
-            // Detect peak
-            float peak = 0.0f;
-            for (int ch = 0; ch < channels; ch++) {
-                peak = std::max(peak, std::abs(samples[i + ch]));
-            }
-            
-            // Envelope follower
-            if (peak > envelope) {
-                envelope = attackCoeff * envelope + (1.0f - attackCoeff) * peak;
-            } else {
-                envelope = releaseCoeff * envelope + (1.0f - releaseCoeff) * peak;
-            }
-            
-            // Calculate gain reduction
-            float gain = 1.0f;
-            if (envelope > threshold) {
-                float overDb = 20.0f * std::log10(envelope / threshold);
-                float reducedDb = overDb / ratio;
-                gain = std::pow(10.0f, (reducedDb - overDb) / 20.0f);
-            }
-            
-            // Smooth gain
-            currentGain = 0.9f * currentGain + 0.1f * gain;
-            
-            // Apply gain + makeup
-            for (int ch = 0; ch < channels; ch++) {
-                samples[i + ch] *= currentGain * makeupGain;
-            }
-        }
-    }
-    
-    void reset() {
-        envelope = 0.0f;
-        currentGain = 1.0f;
-    }
-    
+    bool isEnabled() const { return enabled; }
+
+    // Overall ratio: the low band gets all of it, higher bands progressively
+    // less. Glides over kParameterRampMs.
+    void setRatio(float ratio);
+    void setCrossovers(float lowHz, float midHz, float highHz);
+
+    // Interleaved, in place
+    void process(float* samples, int numFrames);
+    void reset();
+
 private:
+    void updateFilters();
+    void updateBands();
+    template <int Channels> void processChannels(float* samples, int numFrames);
+
     bool enabled = true;
     int sampleRate = 44100;
     int channels = 2;
-    
-    float thresholdDb = -12.0f;  // Compress above -12dB
-    float threshold = 0.25f;
-    float ratio = 4.0f;          // 4:1 compression
-    float attackMs = 5.0f;       // Fast attack for punch
-    float releaseMs = 100.0f;    // Medium release
-    float makeupGainDb = 6.0f;   // +6dB makeup
-    float makeupGain = 2.0f;
-    
-    float envelope = 0.0f;
-    float currentGain = 1.0f;
+
+    float ratio = 4.0f;
+    float kneeDb = 6.0f;
+    float crossoverHz[3] = { 120.0f, 1000.0f, 6000.0f };
+
+    // --- Per band settings (lows, low mids, presence, air) ---
+    float thresholdDb[kBands] = { -14.0f, -12.0f, -12.0f, -10.0f };
+    float ratioScale[kBands] = { 1.0f, 1.0f, 0.75f, 0.5f };
+    float makeupDb[kBands] = { 6.0f, 6.0f, 5.0f, 4.0f };
+    float attackMs[kBands] = { 30.0f, 10.0f, 5.0f, 3.0f };   // Slow lows keep the bass waveform intact
+    float releaseMs[kBands] = { 200.0f, 120.0f, 100.0f, 80.0f };
+
+    // --- Lanes (derived, one per band) ---
+    alignas(16) float thresholdLog2[kBands] = {};
+    alignas(16) float halfKnee[kBands] = {};
+    alignas(16) float invTwoKnee[kBands] = {};
+    alignas(16) float makeup[kBands] = {};
+    alignas(16) float attackCoeff[kBands] = {};
+    alignas(16) float releaseCoeff[kBands] = {};
+
+    // Ratio as 1/ratio - 1, gliding
+    alignas(16) float slope[kBands] = {};
+    alignas(16) float slopeTarget[kBands] = {};
+    alignas(16) float slopeStep[kBands] = {};
+    int slopeRampFrames = 0;
+
+    alignas(16) float envelope[kBands] = {};
+    alignas(16) float gain[kBands] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    // Crossover tree, TDF-II, coefficients per section per lane: b0 b1 b2 a1 a2
+    alignas(16) float coeffs[kSections][5][kBands] = {};
+    std::vector<float> filterState;  // channels x kSections x (z1, z2) x kBands
+    std::vector<float> bandScratch;  // channels x kBands, one frame's band split
+};
+
+// =============================================================================
+// PARALLEL COMPRESSOR - New York style: heavy compression mixed under the dry
+// signal for more punch. One envelope per channel.
+// Implementation: battle_compressor.cpp
+// =============================================================================
+
+class ParallelCompressor {
+public:
+    ParallelCompressor() = default;
+
+    void configure(int sampleRate, int channels);
+
+    // 0 = dry only, 1 = fully compressed
+    void setMix(float wetDry) { mix = std::clamp(wetDry, 0.0f, 1.0f); }
+    float getMix() const { return mix; }
+
+    // Interleaved, in place
+    void process(float* samples, int numFrames);
+    void reset();
+
+private:
+    int sampleRate = 44100;
+    int channels = 2;
+    float mix = 0.0f;
+
+    // Heavy compression settings
+    float thresholdDb = -20.0f;
+    float ratio = 8.0f;
+    float kneeDb = 6.0f;
+    float attackMs = 1.0f;
+    float releaseMs = 100.0f;
+    float makeupDb = 12.0f;  // Heavy makeup for NY compression
+
+    float attackCoeff = 0.0f;
+    float releaseCoeff = 0.0f;
+    float makeup = 1.0f;
+    std::vector<float> envelopes;  // Per channel
+};
+
+// =============================================================================
+// BIQUAD DESIGN - RBJ cookbook filters, normalized by a0
+// q is the resonance for pass / peaking filters and the shelf slope S for
+// shelves (0.707 = the classic gentle shelf). Shelves and peaking filters at
+// 0 dB come back as exact identity sections.
+// =============================================================================
+
+enum class BiquadType {
+    LowPass,
+    HighPass,
+    BandPass,
+    Notch,
+    AllPass,
+    Peaking,
+    LowShelf,
+    HighShelf,
+};
+
+struct BiquadCoefficients {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+    float a1 = 0.0f, a2 = 0.0f;
+
+    bool isIdentity() const { return b0 == 1.0f && b1 == 0.0f && b2 == 0.0f && a1 == 0.0f && a2 == 0.0f; }
+};
+
+BiquadCoefficients designBiquad(BiquadType type, float frequency, float q, float gainDb,
+                                int sampleRate);
+
+// =============================================================================
+// BIQUAD CASCADE - Up to 16 transposed direct form II sections in series
+// Sections are packed four to a SIMD register and run as a skewed pipeline:
+// lane k filters frame t - k while lane 0 takes in frame t, so a group of four
+// sections costs about what one section used to. Two channels are interleaved
+// per pass to hide the recursion latency. Coefficient changes glide over
+// parameterRampFrames(). Groups that are flat (all identity, not gliding) are
+// skipped, so unused EQ bands cost nothing.
+// Implementation: battle_biquad.cpp
+// =============================================================================
+
+class BiquadCascade {
+public:
+    static constexpr int kLanes = 4;          // Sections per SIMD group
+    static constexpr int kMaxSections = 16;
+    static constexpr int kChunkFrames = 256;  // Deinterleave buffer size
+
+    BiquadCascade() = default;
+
+    void configure(int sampleRate, int channels, int numSections);
+
+    // Glides from the live coefficients to the new design
+    void setSection(int index, BiquadType type, float frequency, float q, float gainDb);
+    void setSection(int index, const BiquadCoefficients& coefficients);
+
+    int getSections() const { return sections; }
+    bool isRamping() const;
+    // True when every section is (and is gliding to) identity: process() would do nothing
+    bool isIdentity() const;
+
+    // Interleaved, in place
+    void process(float* samples, int numFrames);
+
+    // Clears the filter history and lands any glide on its target
+    void reset();
+
+    // One group of kLanes sections: b0 b1 b2 a1 a2, one lane per section
+    struct Group {
+        alignas(16) float coeffs[5][kLanes];  // Live values, gliding toward target
+        alignas(16) float target[5][kLanes];
+        alignas(16) float step[5][kLanes];
+        int rampFrames = 0;
+    };
+
+private:
+    bool isGroupIdentity(const Group& group) const;
+
+    int sampleRate = 44100;
+    int channels = 2;
+    int sections = 0;
+
+    std::vector<Group> groups;
+    std::vector<float> state;    // (channel, group): z1[kLanes] then z2[kLanes]
+    std::vector<float> scratch;  // channels x kChunkFrames, planar
 };
 
 // =============================================================================
 // BATTLE BASS BOOST - Sub-bass enhancement for maximum impact
+// A single low shelf on the biquad cascade.
 // =============================================================================
 
 class BattleBassBoost {
 public:
     BattleBassBoost() = default;
-    
+
     void configure(int sampleRate, int channels) {
-        this->sampleRate = sampleRate;
-        this->channels = channels;
-        
-        // Calculate filter coefficients for low shelf at 80Hz
-        calculateCoefficients();
-        
-        // Initialize filter states
-        filterStates.resize(channels * 2, 0.0f);  // 2 states per channel (biquad)
-        
+        filter.configure(sampleRate, channels, 1);
+        updateFilter();
         reset();
     }
     
     void setEnabled(bool enabled) { this->enabled = enabled; }
+    // Stays enabled while gliding down to 0dB so the boost fades out instead of cutting
+    bool isEnabled() const { return enabled && (gainDb > 0 || filter.isRamping()); }
     void setGain(float gainDb) { 
         this->gainDb = std::clamp(gainDb, 0.0f, 24.0f);
-        calculateCoefficients();
+        updateFilter();
     }
     void setFrequency(float freq) { 
         this->frequency = std::clamp(freq, 20.0f, 200.0f);
-        calculateCoefficients();
+        updateFilter();
     }
     
-    void process(float* samples, int numSamples) {
-        if (!enabled || gainDb <= 0) return;
-        
-        for (int i = 0; i < numSamples; i += channels) {
-            for (int ch = 0; ch < channels; ch++) {
-                float input = samples[i + ch];
-                
-                // Biquad filter (low shelf)
-                int stateIdx = ch * 2;
-                float output = b0 * input + b1 * filterStates[stateIdx] + 
-                              b2 * filterStates[stateIdx + 1];
-                output -= a1 * filterStates[stateIdx] + a2 * filterStates[stateIdx + 1];
-                
-                // Update states
-                filterStates[stateIdx + 1] = filterStates[stateIdx];
-                filterStates[stateIdx] = input;
-                
-                samples[i + ch] = output;
-            }
-        }
+    void process(float* samples, int numFrames) {
+        if (!isEnabled()) return;
+        filter.process(samples, numFrames);
     }
     
     void reset() {
-        std::fill(filterStates.begin(), filterStates.end(), 0.0f);
+        filter.reset();
     }
     
 private:
-    void calculateCoefficients() {
-        // Low shelf filter design
-        float A = std::pow(10.0f, gainDb / 40.0f);
-        float w0 = 2.0f * M_PI * frequency / sampleRate;
-        float cosW0 = std::cos(w0);
-        float sinW0 = std::sin(w0);
-        float alpha = sinW0 / 2.0f * std::sqrt((A + 1.0f / A) * (1.0f / 0.707f - 1.0f) + 2.0f);
-        
-        float a0 = (A + 1) + (A - 1) * cosW0 + 2 * std::sqrt(A) * alpha;
-        
-        b0 = (A * ((A + 1) - (A - 1) * cosW0 + 2 * std::sqrt(A) * alpha)) / a0;
-        b1 = (2 * A * ((A - 1) - (A + 1) * cosW0)) / a0;
-        b2 = (A * ((A + 1) - (A - 1) * cosW0 - 2 * std::sqrt(A) * alpha)) / a0;
-        a1 = (-2 * ((A - 1) + (A + 1) * cosW0)) / a0;
-        a2 = ((A + 1) + (A - 1) * cosW0 - 2 * std::sqrt(A) * alpha) / a0;
+    // Low shelf at the boost frequency (no-op before configure())
+    void updateFilter() {
+        filter.setSection(0, BiquadType::LowShelf, frequency, 0.707f, gainDb);
     }
     
     bool enabled = true;
-    int sampleRate = 44100;
-    int channels = 2;
     
     float gainDb = 6.0f;       // Default +6dB bass boost
     float frequency = 80.0f;   // Center frequency for boost
     
-    // Biquad coefficients
-    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
-    float a1 = 0.0f, a2 = 0.0f;
-    
-    std::vector<float> filterStates;
+    BiquadCascade filter;
 };
 
 // =============================================================================
-// SUB-HARMONIC SYNTHESIZER - Generates octave-below frequencies for perceived bass
+// PARAMETRIC EQUALIZER - Ten octave bands for battle mode
+// 31 Hz low shelf, peaking bands from 62 Hz to 8 kHz, 16 kHz high shelf,
+// all on one biquad cascade (three SIMD groups). Flat bands are exact
+// identity sections, so a flat EQ is skipped entirely.
+// Implementation: battle_biquad.cpp
 // =============================================================================
 
-class SubHarmonicSynthesizer {
+class ParametricEqualizer {
 public:
-    void configure(int sampleRate) {
-        this->sampleRate = sampleRate;
+    static constexpr int kBands = 10;
+    static constexpr float kMaxGainDb = 12.0f;
+
+    ParametricEqualizer() = default;
+
+    void configure(int sampleRate, int channels);
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    // Stays enabled while gliding back to flat
+    bool isEnabled() const { return enabled && !filter.isIdentity(); }
+
+    void setBandGain(int band, float gainDb);
+    float getBandGain(int band) const { return gainsDb[band]; }
+    static float getBandFrequency(int band);
+
+    // Interleaved, in place
+    void process(float* samples, int numFrames) { filter.process(samples, numFrames); }
+    void reset() { filter.reset(); }
+
+private:
+    void updateBand(int band);
+
+    bool enabled = true;
+    float gainsDb[kBands] = {};
+
+    BiquadCascade filter;
+};
+
+// =============================================================================
+// HARDWARE PROTECTION - Last stage before the speakers, in every engine path
+// DC blocker (5 Hz, first order) and 20 Hz Butterworth high-pass run as two
+// sections of one biquad cascade group: both filters in a single SIMD pass.
+// The hard ceiling is not applied here; the output conversion does it
+// (convertFloatToInt16 / clampBlock) so it costs no extra pass.
+// =============================================================================
+
+class HardwareProtection {
+public:
+    static constexpr float kDcCornerHz = 5.0f;
+    static constexpr float kSubsonicHz = 20.0f;
 
-        // Low pass filter at 80Hz for sub detection
-        float fc = 80.0f / sampleRate;
-        float x = std::exp(-2.0f * M_PI * fc);
-        lpCoeff = 1.0f - x;
+    HardwareProtection() = default;
 
+    void configure(int sampleRate, int channels) {
+        this->sampleRate = sampleRate;
+        filter.configure(sampleRate, channels, 2);
+        updateFilters();
         reset();
     }
 
-    void setAmount(float amount) {
-        this->amount = std::clamp(amount, 0.0f, 1.0f);
+    void setDcBlocker(bool enabled) {
+        dcBlocker = enabled;
+        updateFilters();
     }
+    void setSubsonicFilter(bool enabled) {
+        subsonic = enabled;
+        updateFilters();
+    }
+
+    // Stays active while a filter glides out after being switched off
+    bool isActive() const { return !filter.isIdentity(); }
 
-    float process(float input) {
-        if (amount <= 0) return input;
+    // Interleaved, in place
+    void process(float* samples, int numFrames) {
+        if (!isActive()) return;
+        filter.process(samples, numFrames);
+    }
 
-        // Low pass to isolate bass
-        lpState = lpState + lpCoeff * (input - lpState);
-        float bass = lpState;
+    void reset() { filter.reset(); }
 
-        // Detect zero crossings for sub-harmonic generation
-        bool currentPositive = bass > 0;
-        if (currentPositive != lastPositive) {
-            // Zero crossing - toggle sub oscillator
-            subPhase = !subPhase;
-            lastPositive = currentPositive;
+private:
+    void updateFilters() {
+        // Off = identity section (no-op before configure())
+        BiquadCoefficients dc;
+        if (dcBlocker) {
+            // y[n] = x[n] - x[n-1] + R * y[n-1]
+            dc.b1 = -1.0f;
+            dc.a1 = -std::exp(-2.0f * static_cast<float>(M_PI) * kDcCornerHz / sampleRate);
         }
+        filter.setSection(0, dc);
+        filter.setSection(1, subsonic
+            ? designBiquad(BiquadType::HighPass, kSubsonicHz, 0.70710678f, 0.0f, sampleRate)
+            : BiquadCoefficients{});
+    }
 
-        // Generate sub-harmonic (half frequency square wave smoothed)
-        float subOsc = subPhase ? 1.0f : -1.0f;
+    int sampleRate = 44100;
+    bool dcBlocker = true;
+    bool subsonic = true;
 
-        // Low pass the square wave to make it more sine-like
-        subLpState = subLpState + 0.01f * (subOsc - subLpState);
+    BiquadCascade filter;
+};
 
-        // Mix sub with original, scaled by bass envelope
-        float envelope = std::abs(bass);
-        return input + subLpState * envelope * amount;
-    }
+// =============================================================================
+// SUB-HARMONIC SYNTHESIZER - Generates octave-below frequencies for perceived bass
+// Octave divider: the bass (80 Hz two-pole low-pass) flips a square wave on
+// every upward zero crossing, so the square runs at half the bass frequency.
+// Each flip is placed at its sub-sample crossing time and band-limited with a
+// PolyBLEP (the square is emitted one sample late to correct both sides of the
+// step). All filters are sample-rate correct. Works on one channel of an
+// interleaved buffer per call, state carried across blocks.
+// Implementation: battle_bass_boost.cpp
+// =============================================================================
 
-    void reset() {
-        lpState = 0;
-        subLpState = 0;
-        subPhase = false;
-        lastPositive = false;
+class SubHarmonicSynthesizer {
+public:
+    void configure(int sampleRate);
+
+    void setAmount(float amount) {
+        this->amount = std::clamp(amount, 0.0f, 1.0f);
     }
 
+    // numFrames samples at samples[0], samples[stride], ... (in place)
+    void process(float* samples, int numFrames, int stride = 1);
+
+    void reset();
+
 private:
     int sampleRate = 44100;
     float amount = 0.0f;
 
-    float lpCoeff = 0.01f;
-    float lpState = 0;
-
-    bool subPhase = false;
-    bool lastPositive = false;
-    float subLpState = 0;
+    // Coefficients (one-pole: y += coeff * (x - y))
+    float detectCoeff = 0.01f;    // 80 Hz bass isolation
+    float smoothCoeff = 0.01f;    // 70 Hz, rounds the square toward a sine
+    float envelopeCoeff = 0.01f;  // 20 Hz, bass level the sub follows
+
+    // State
+    float detect1 = 0.0f, detect2 = 0.0f;  // Bass (two one-poles)
+    bool armed = false;                    // Bass went negative since the last flip
+    float level = -1.0f;                   // Square wave, +-1
+    float held = -1.0f;                    // Band-limited square, one sample behind
+    float smooth = 0.0f;
+    float envelope = 0.0f;
 };
 
 // =============================================================================
 // BASS EXCITER - Adds harmonics for bass presence via soft saturation
+// The 40-90 Hz band is saturated (tanh(3x) / 3) at 2x oversampling: a
+// polyphase halfband interpolator doubles the rate, the rational tanh runs
+// vectorized over the block, a halfband decimator brings it back. Only the
+// harmonics (saturated minus clean band) are added to the input, so their
+// kDelayFrames of filter delay never touches the dry signal. Works on one
+// channel of an interleaved buffer per call, state carried across blocks.
+// Implementation: battle_bass_boost.cpp
 // =============================================================================
 
 class BassExciter {
 public:
-    void configure(int sampleRate) {
-        this->sampleRate = sampleRate;
+    static constexpr int kHalfbandTaps = 8;             // Per polyphase branch
+    static constexpr int kDelayFrames = kHalfbandTaps;  // Up + down group delay
+    static constexpr int kChunkFrames = 64;             // Work buffer size
 
-        // Bandpass around 60-120Hz
-        float fc = 90.0f / sampleRate;
-        lpCoeff = 1.0f - std::exp(-2.0f * M_PI * fc);
-        hpCoeff = 1.0f - std::exp(-2.0f * M_PI * 40.0f / sampleRate);
-
-        reset();
-    }
+    void configure(int sampleRate);
 
     void setAmount(float amount) {
         this->amount = std::clamp(amount, 0.0f, 1.0f);
     }
 
-    float process(float input) {
-        if (amount <= 0) return input;
-
-        // Bandpass filter
-        lpState = lpState + lpCoeff * (input - lpState);
-        hpState = hpState + hpCoeff * (lpState - hpState);
-        float band = lpState - hpState;
+    // numFrames samples at samples[0], samples[stride], ... (in place)
+    void process(float* samples, int numFrames, int stride = 1);
 
-        // Soft saturation for harmonics
-        float saturated = std::tanh(band * 3.0f) / 3.0f;
-
-        // Add harmonics back
-        return input + (saturated - band) * amount;
-    }
-
-    void reset() {
-        lpState = 0;
-        hpState = 0;
-    }
+    void reset();
 
 private:
     int sampleRate = 44100;
@@ -421,6 +793,40 @@ private:
     float hpCoeff = 0.005f;
     float lpState = 0;
     float hpState = 0;
+
+    // kHalfbandTaps history samples followed by the current chunk
+    alignas(16) float bandLine[kHalfbandTaps + kChunkFrames] = {};  // Clean band, base rate
+    alignas(16) float oddLine[kHalfbandTaps + kChunkFrames] = {};   // Saturated in-between samples
+    alignas(16) float harmonics[kChunkFrames] = {};
+};
+
+// =============================================================================
+// MEGA BASS - The ultimate bass enhancement
+// Sub-harmonics + harmonic excitement with its own per-channel state.
+// Implementation: battle_bass_boost.cpp
+// =============================================================================
+
+class MegaBass {
+public:
+    MegaBass() = default;
+
+    void configure(int sampleRate, int channels);
+
+    // 0..1; sub-harmonics at 30% and exciter at 50% of it
+    void setIntensity(float intensity);
+    float getIntensity() const { return intensity; }
+
+    // Interleaved, in place
+    void process(float* samples, int numFrames);
+    void reset();
+
+private:
+    int sampleRate = 44100;
+    int channels = 2;
+    float intensity = 0.0f;
+
+    std::vector<SubHarmonicSynthesizer> subSynth;  // Per channel
+    std::vector<BassExciter> exciter;              // Per channel
 };
 
 } // namespace ultramusic
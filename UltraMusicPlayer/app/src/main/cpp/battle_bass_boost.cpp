@@ -6,41 +6,233 @@
  */
 
 #include "battle_audio_engine.h"
+#include "battle_vector_ops.h"
+
 #include <cmath>
+#include <cstring>
 
 namespace ultramusic {
 
-// MEGA BASS - The ultimate bass enhancement
-void megaBass(float* samples, int numSamples, int channels, int sampleRate, float intensity) {
-    static SubHarmonicSynthesizer subSynth[2];
-    static BassExciter exciter[2];
-    static bool initialized = false;
-
-    if (!initialized) {
-        for (int ch = 0; ch < 2; ch++) {
-            subSynth[ch].configure(sampleRate);
-            exciter[ch].configure(sampleRate);
+namespace {
+
+// y += coeff * (x - y) with its corner at frequency
+float onePoleCoeff(float frequency, int sampleRate) {
+    return 1.0f - std::exp(-2.0f * static_cast<float>(M_PI) * frequency / sampleRate);
+}
+
+// Bass has to dip below this before the next upward crossing counts,
+// so noise around zero can't chatter the divider
+constexpr float kCrossingHysteresis = 1e-4f;
+
+// Halfband interpolator branch: taps at +-0.5, +-1.5, +-2.5, +-3.5 samples
+// (Kaiser-windowed sinc, beta 5, unity DC gain). Flat to 0.2 fs, -50 dB from
+// 0.7 fs. The other branch of a halfband is a plain delay.
+constexpr float kHalfband[BassExciter::kHalfbandTaps] = {
+    -0.010349663f, 0.04864109f, -0.15356642f, 0.615274993f,
+    0.615274993f, -0.15356642f, 0.04864109f, -0.010349663f,
+};
+
+// Harmonics only: tanh(3x) / 3 - x
+inline vec4::Lanes saturate(vec4::Lanes x) {
+    using namespace vec4;
+    return sub(mul(tanhLanes(mul(x, splat(3.0f))), splat(1.0f / 3.0f)), x);
+}
+
+inline float saturate(float x) {
+    return tanhApprox(x * 3.0f) * (1.0f / 3.0f) - x;
+}
+
+} // namespace
+
+// =============================================================================
+// SUB-HARMONIC SYNTHESIZER
+// =============================================================================
+
+void SubHarmonicSynthesizer::configure(int sampleRate) {
+    this->sampleRate = sampleRate;
+    detectCoeff = onePoleCoeff(80.0f, sampleRate);
+    smoothCoeff = onePoleCoeff(70.0f, sampleRate);
+    envelopeCoeff = onePoleCoeff(20.0f, sampleRate);
+    reset();
+}
+
+void SubHarmonicSynthesizer::reset() {
+    detect1 = detect2 = 0.0f;
+    armed = false;
+    level = held = -1.0f;
+    smooth = 0.0f;
+    envelope = 0.0f;
+}
+
+void SubHarmonicSynthesizer::process(float* samples, int numFrames, int stride) {
+    if (amount <= 0.0f) return;
+
+    // State in registers for the whole block
+    float d1 = detect1, d2 = detect2;
+    bool arm = armed;
+    float lvl = level, out = held, sm = smooth, env = envelope;
+    const float dc = detectCoeff, sc = smoothCoeff, ec = envelopeCoeff, amt = amount;
+
+    for (int i = 0; i < numFrames; i++) {
+        float& x = samples[i * stride];
+
+        // Isolate the bass
+        const float previous = d2;
+        d1 += dc * (x - d1);
+        d2 += dc * (d1 - d2);
+
+        // Divide by two: flip on every upward zero crossing
+        float next = lvl;
+        if (d2 < -kCrossingHysteresis) {
+            arm = true;
+        } else if (arm && d2 >= 0.0f) {
+            arm = false;
+            // Crossing t samples after the previous one (0 < t <= 1), by linear interpolation
+            const float t = -previous / (d2 - previous);
+            const float step = -2.0f * lvl;
+            lvl = -lvl;
+            // PolyBLEP: smooth both samples around the step
+            out += step * 0.5f * (1.0f - t) * (1.0f - t);
+            next = lvl - step * 0.5f * t * t;
         }
-        initialized = true;
-    }
 
-    for (int ch = 0; ch < channels && ch < 2; ch++) {
-        subSynth[ch].setAmount(intensity * 0.3f);
-        exciter[ch].setAmount(intensity * 0.5f);
+        // Emit the previous sample's band-limited square, rounded and scaled by the bass level
+        sm += sc * (out - sm);
+        out = next;
+        env += ec * (std::abs(d2) - env);
+        x += sm * env * amt;
     }
 
-    for (int i = 0; i < numSamples; i += channels) {
-        for (int ch = 0; ch < channels && ch < 2; ch++) {
-            float sample = samples[i + ch];
+    detect1 = d1;
+    detect2 = d2;
+    armed = arm;
+    level = lvl;
+    held = out;
+    smooth = sm;
+    envelope = env;
+}
+
+// =============================================================================
+// BASS EXCITER
+// =============================================================================
+
+void BassExciter::configure(int sampleRate) {
+    this->sampleRate = sampleRate;
+
+    // Bandpass around 60-120Hz
+    lpCoeff = onePoleCoeff(90.0f, sampleRate);
+    hpCoeff = onePoleCoeff(40.0f, sampleRate);
+
+    reset();
+}
+
+void BassExciter::reset() {
+    lpState = 0;
+    hpState = 0;
+    std::fill(std::begin(bandLine), std::end(bandLine), 0.0f);
+    std::fill(std::begin(oddLine), std::end(oddLine), 0.0f);
+}
+
+void BassExciter::process(float* samples, int numFrames, int stride) {
+    using namespace vec4;
+    if (amount <= 0.0f) return;
 
-            // Add sub-harmonics
-            sample = subSynth[ch].process(sample);
+    constexpr int K = kHalfbandTaps;
+    const float gain = 0.5f * amount;  // Decimator's 1/2 folded into the mix
+
+    for (int start = 0; start < numFrames; start += kChunkFrames) {
+        const int n = std::min(kChunkFrames, numFrames - start);
+        float* x = samples + static_cast<size_t>(start) * stride;
+
+        // 1. Band-pass at base rate (recursive)
+        float lp = lpState, hp = hpState;
+        for (int i = 0; i < n; i++) {
+            lp += lpCoeff * (x[i * stride] - lp);
+            hp += hpCoeff * (lp - hp);
+            bandLine[K + i] = lp - hp;
+        }
+        lpState = lp;
+        hpState = hp;
 
-            // Add harmonic excitement
-            sample = exciter[ch].process(sample);
+        // 2. Interpolate the in-between (2x rate) samples and saturate them.
+        //    Sample m sits half way between band[m - K/2] and band[m - K/2 + 1].
+        int m = 0;
+        for (; m + 4 <= n; m += 4) {
+            Lanes acc = splat(0.0f);
+            for (int j = 0; j < K; j++) {
+                acc = mulAdd(acc, splat(kHalfband[j]), load(bandLine + m + 1 + j));
+            }
+            store(oddLine + K + m, saturate(acc));
+        }
+        for (; m < n; m++) {
+            float acc = 0.0f;
+            for (int j = 0; j < K; j++) acc += kHalfband[j] * bandLine[m + 1 + j];
+            oddLine[K + m] = saturate(acc);
+        }
 
-            samples[i + ch] = sample;
+        // 3. Saturate the on-grid samples (delayed to line up) and decimate:
+        //    halfband centre tap + the interpolated branch, every other 2x sample
+        m = 0;
+        for (; m + 4 <= n; m += 4) {
+            Lanes acc = saturate(load(bandLine + m));
+            for (int j = 0; j < K; j++) {
+                acc = mulAdd(acc, splat(kHalfband[j]), load(oddLine + m + j));
+            }
+            store(harmonics + m, mul(acc, splat(gain)));
         }
+        for (; m < n; m++) {
+            float acc = saturate(bandLine[m]);
+            for (int j = 0; j < K; j++) acc += kHalfband[j] * oddLine[m + j];
+            harmonics[m] = acc * gain;
+        }
+
+        // 4. Add the harmonics back, keep the last K samples as filter history
+        for (int i = 0; i < n; i++) x[i * stride] += harmonics[i];
+        std::memmove(bandLine, bandLine + n, K * sizeof(float));
+        std::memmove(oddLine, oddLine + n, K * sizeof(float));
+    }
+}
+
+// =============================================================================
+// MEGA BASS - The ultimate bass enhancement
+// =============================================================================
+
+void MegaBass::configure(int sampleRate, int channels) {
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+
+    subSynth.assign(channels, SubHarmonicSynthesizer());
+    exciter.assign(channels, BassExciter());
+    for (int ch = 0; ch < channels; ch++) {
+        subSynth[ch].configure(sampleRate);
+        exciter[ch].configure(sampleRate);
+    }
+    setIntensity(intensity);
+}
+
+void MegaBass::setIntensity(float intensity) {
+    this->intensity = std::clamp(intensity, 0.0f, 1.0f);
+    for (int ch = 0; ch < channels && ch < static_cast<int>(subSynth.size()); ch++) {
+        subSynth[ch].setAmount(this->intensity * 0.3f);
+        exciter[ch].setAmount(this->intensity * 0.5f);
+    }
+}
+
+void MegaBass::reset() {
+    for (auto& sub : subSynth) sub.reset();
+    for (auto& ex : exciter) ex.reset();
+}
+
+void MegaBass::process(float* samples, int numFrames) {
+    if (intensity <= 0.0f) return;
+
+    // Whole channel per call for both stages
+    for (int ch = 0; ch < channels; ch++) {
+        // Add sub-harmonics
+        subSynth[ch].process(samples + ch, numFrames, channels);
+
+        // Add harmonic excitement
+        exciter[ch].process(samples + ch, numFrames, channels);
     }
 }
 
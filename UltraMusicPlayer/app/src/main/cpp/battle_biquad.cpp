@@ -0,0 +1,386 @@
+/**
+ * BATTLE BIQUAD Implementation
+ *
+ * Biquad design, the SIMD biquad cascade and the parametric equalizer built
+ * on it. The bass boost (inline in the header) is a one-section cascade.
+ *
+ * The cascade keeps one section per SIMD lane and runs each group of four
+ * sections as a skewed pipeline: every step, lane 0 takes in a new frame and
+ * each lane hands its output to the next, so lane 3 emits the frame that
+ * entered three steps earlier. The recursion of every section still sees its
+ * own frames in order; only the start (pipeline fill) and end (drain) of a
+ * block run a few scalar steps.
+ */
+
+#include "battle_audio_engine.h"
+#include "battle_vector_ops.h"
+
+#include <cstring>
+
+namespace ultramusic {
+
+// =============================================================================
+// BIQUAD DESIGN
+// =============================================================================
+
+BiquadCoefficients designBiquad(BiquadType type, float frequency, float q, float gainDb,
+                                int sampleRate) {
+    BiquadCoefficients c;
+    const bool hasGain = type == BiquadType::Peaking || type == BiquadType::LowShelf ||
+                         type == BiquadType::HighShelf;
+    if (hasGain && gainDb == 0.0f) return c;  // Flat: exact identity, skipped by the cascade
+
+    const float w0 = 2.0f * static_cast<float>(M_PI) *
+                     std::clamp(frequency, 10.0f, 0.45f * sampleRate) / sampleRate;
+    const float cosw0 = std::cos(w0);
+    const float sinw0 = std::sin(w0);
+    q = std::max(q, 0.01f);
+    float alpha = sinw0 / (2.0f * q);
+    const float A = std::pow(10.0f, gainDb / 40.0f);
+
+    float b0, b1, b2, a0, a1, a2;
+    switch (type) {
+        case BiquadType::LowPass:
+            b0 = (1.0f - cosw0) * 0.5f; b1 = 1.0f - cosw0; b2 = b0;
+            a0 = 1.0f + alpha; a1 = -2.0f * cosw0; a2 = 1.0f - alpha;
+            break;
+        case BiquadType::HighPass:
+            b0 = (1.0f + cosw0) * 0.5f; b1 = -(1.0f + cosw0); b2 = b0;
+            a0 = 1.0f + alpha; a1 = -2.0f * cosw0; a2 = 1.0f - alpha;
+            break;
+        case BiquadType::BandPass:
+            // Constant 0 dB peak gain
+            b0 = alpha; b1 = 0.0f; b2 = -alpha;
+            a0 = 1.0f + alpha; a1 = -2.0f * cosw0; a2 = 1.0f - alpha;
+            break;
+        case BiquadType::Notch:
+            b0 = 1.0f; b1 = -2.0f * cosw0; b2 = 1.0f;
+            a0 = 1.0f + alpha; a1 = -2.0f * cosw0; a2 = 1.0f - alpha;
+            break;
+        case BiquadType::AllPass:
+            b0 = 1.0f - alpha; b1 = -2.0f * cosw0; b2 = 1.0f + alpha;
+            a0 = 1.0f + alpha; a1 = -2.0f * cosw0; a2 = 1.0f - alpha;
+            break;
+        case BiquadType::Peaking:
+            b0 = 1.0f + alpha * A; b1 = -2.0f * cosw0; b2 = 1.0f - alpha * A;
+            a0 = 1.0f + alpha / A; a1 = -2.0f * cosw0; a2 = 1.0f - alpha / A;
+            break;
+        case BiquadType::LowShelf:
+        case BiquadType::HighShelf:
+        default: {
+            // q is the shelf slope S here
+            alpha = sinw0 * 0.5f * std::sqrt(std::max((A + 1.0f / A) * (1.0f / q - 1.0f) + 2.0f, 0.0f));
+            const float twoSqrtAAlpha = 2.0f * std::sqrt(A) * alpha;
+            if (type == BiquadType::LowShelf) {
+                b0 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 + twoSqrtAAlpha);
+                b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw0);
+                b2 = A * ((A + 1.0f) - (A - 1.0f) * cosw0 - twoSqrtAAlpha);
+                a0 = (A + 1.0f) + (A - 1.0f) * cosw0 + twoSqrtAAlpha;
+                a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw0);
+                a2 = (A + 1.0f) + (A - 1.0f) * cosw0 - twoSqrtAAlpha;
+            } else {
+                b0 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 + twoSqrtAAlpha);
+                b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw0);
+                b2 = A * ((A + 1.0f) + (A - 1.0f) * cosw0 - twoSqrtAAlpha);
+                a0 = (A + 1.0f) - (A - 1.0f) * cosw0 + twoSqrtAAlpha;
+                a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cosw0);
+                a2 = (A + 1.0f) - (A - 1.0f) * cosw0 - twoSqrtAAlpha;
+            }
+            break;
+        }
+    }
+
+    c.b0 = b0 / a0;
+    c.b1 = b1 / a0;
+    c.b2 = b2 / a0;
+    c.a1 = a1 / a0;
+    c.a2 = a2 / a0;
+    return c;
+}
+
+// =============================================================================
+// BIQUAD CASCADE
+// =============================================================================
+
+namespace {
+
+using namespace vec4;
+
+constexpr int kLanes = BiquadCascade::kLanes;
+constexpr float kIdentity[5] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+// Move a group's live coefficients one frame along its glide.
+// Linear interpolation between two stable biquads stays stable: the
+// (a1, a2) stability triangle is convex.
+inline void stepGroup(BiquadCascade::Group& group) {
+    if (group.rampFrames <= 0) return;
+    if (--group.rampFrames == 0) {
+        std::memcpy(group.coeffs, group.target, sizeof(group.coeffs));
+        return;
+    }
+    for (int k = 0; k < 5; k++) {
+        for (int l = 0; l < kLanes; l++) group.coeffs[k][l] += group.step[k][l];
+    }
+}
+
+// One pipeline step with only lanes [first, last] busy (pipeline fill / drain).
+// Lanes run high to low so each reads its neighbour's previous output.
+inline void stepLanes(const float (&c)[5][kLanes], float* z1, float* z2, float* y,
+                      float input, int first, int last) {
+    for (int k = last; k >= first; k--) {
+        float x = k == 0 ? input : y[k - 1];
+        // Same operation order as the SIMD steps, so block splits don't change results
+        float out = z1[k] + c[0][k] * x;
+        z1[k] = (z2[k] + c[1][k] * x) - c[3][k] * out;
+        z2[k] = c[2][k] * x - c[4][k] * out;
+        y[k] = out;
+    }
+}
+
+// One group of sections over P planar channel buffers (in place).
+// state[p]: z1[kLanes] then z2[kLanes] for channel p.
+template <int P>
+void runGroup(BiquadCascade::Group& group, float* const* state, float* const* buf, int n) {
+    constexpr int kDepth = kLanes - 1;  // Frames in flight between lane 0 and lane 3
+    alignas(16) float y[P][kLanes] = {};
+
+    // Fill: one more lane comes alive each step
+    const int fill = std::min(kDepth, n);
+    for (int t = 0; t < fill; t++) {
+        stepGroup(group);
+        for (int p = 0; p < P; p++) {
+            stepLanes(group.coeffs, state[p], state[p] + kLanes, y[p], buf[p][t], 0, t);
+        }
+    }
+
+    // Steady state: every lane busy, one frame in and one frame out per step
+    if (n > kDepth) {
+        Lanes b0 = load(group.coeffs[0]), b1 = load(group.coeffs[1]), b2 = load(group.coeffs[2]);
+        Lanes a1 = load(group.coeffs[3]), a2 = load(group.coeffs[4]);
+        int ramp = group.rampFrames;
+
+        Lanes z1[P], z2[P], out[P];
+        for (int p = 0; p < P; p++) {
+            z1[p] = load(state[p]);
+            z2[p] = load(state[p] + kLanes);
+            out[p] = load(y[p]);
+        }
+
+        for (int t = kDepth; t < n; t++) {
+            if (ramp > 0) {
+                if (--ramp == 0) {
+                    b0 = load(group.target[0]); b1 = load(group.target[1]); b2 = load(group.target[2]);
+                    a1 = load(group.target[3]); a2 = load(group.target[4]);
+                } else {
+                    b0 = add(b0, load(group.step[0])); b1 = add(b1, load(group.step[1]));
+                    b2 = add(b2, load(group.step[2]));
+                    a1 = add(a1, load(group.step[3])); a2 = add(a2, load(group.step[4]));
+                }
+            }
+            for (int p = 0; p < P; p++) {
+                Lanes x = shiftIn(out[p], buf[p][t]);
+                out[p] = mulAdd(z1[p], b0, x);
+                z1[p] = sub(mulAdd(z2[p], b1, x), mul(a1, out[p]));
+                z2[p] = sub(mul(b2, x), mul(a2, out[p]));
+                buf[p][t - kDepth] = lastLane(out[p]);
+            }
+        }
+
+        store(group.coeffs[0], b0); store(group.coeffs[1], b1); store(group.coeffs[2], b2);
+        store(group.coeffs[3], a1); store(group.coeffs[4], a2);
+        group.rampFrames = ramp;
+        for (int p = 0; p < P; p++) {
+            store(state[p], z1[p]);
+            store(state[p] + kLanes, z2[p]);
+            store(y[p], out[p]);
+        }
+    }
+
+    // Drain: lanes retire one per step as the last frame moves through
+    for (int t = n; t < n + kDepth; t++) {
+        const int first = t - n + 1;
+        const int last = std::min(kDepth, t);
+        for (int p = 0; p < P; p++) {
+            stepLanes(group.coeffs, state[p], state[p] + kLanes, y[p], 0.0f, first, last);
+            if (last == kDepth) buf[p][t - kDepth] = y[p][kDepth];
+        }
+    }
+}
+
+} // namespace
+
+void BiquadCascade::configure(int sampleRate, int channels, int numSections) {
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+    sections = std::clamp(numSections, 0, kMaxSections);
+
+    // Unused lanes of the last group stay identity
+    Group flat;
+    for (int k = 0; k < 5; k++) {
+        for (int l = 0; l < kLanes; l++) {
+            flat.coeffs[k][l] = kIdentity[k];
+            flat.target[k][l] = kIdentity[k];
+            flat.step[k][l] = 0.0f;
+        }
+    }
+    groups.assign((sections + kLanes - 1) / kLanes, flat);
+    state.assign(static_cast<size_t>(channels) * groups.size() * 2 * kLanes, 0.0f);
+    scratch.assign(static_cast<size_t>(channels) * kChunkFrames, 0.0f);
+}
+
+void BiquadCascade::setSection(int index, BiquadType type, float frequency, float q, float gainDb) {
+    setSection(index, designBiquad(type, frequency, q, gainDb, sampleRate));
+}
+
+void BiquadCascade::setSection(int index, const BiquadCoefficients& coefficients) {
+    if (index < 0 || index >= sections) return;  // Also: not configured yet
+
+    Group& group = groups[index / kLanes];
+    const int lane = index % kLanes;
+    const float values[5] = { coefficients.b0, coefficients.b1, coefficients.b2,
+                              coefficients.a1, coefficients.a2 };
+    for (int k = 0; k < 5; k++) group.target[k][lane] = values[k];
+
+    // Glide the whole group from wherever its live coefficients are now
+    group.rampFrames = parameterRampFrames(sampleRate);
+    for (int k = 0; k < 5; k++) {
+        for (int l = 0; l < kLanes; l++) {
+            group.step[k][l] = (group.target[k][l] - group.coeffs[k][l]) / group.rampFrames;
+        }
+    }
+}
+
+bool BiquadCascade::isRamping() const {
+    for (const Group& group : groups) {
+        if (group.rampFrames > 0) return true;
+    }
+    return false;
+}
+
+bool BiquadCascade::isGroupIdentity(const Group& group) const {
+    if (group.rampFrames > 0) return false;
+    for (int k = 0; k < 5; k++) {
+        for (int l = 0; l < kLanes; l++) {
+            if (group.coeffs[k][l] != kIdentity[k]) return false;
+        }
+    }
+    return true;
+}
+
+bool BiquadCascade::isIdentity() const {
+    for (const Group& group : groups) {
+        if (!isGroupIdentity(group)) return false;
+    }
+    return true;
+}
+
+void BiquadCascade::process(float* samples, int numFrames) {
+    const int numGroups = static_cast<int>(groups.size());
+    if (numGroups == 0 || numFrames <= 0) return;
+
+    for (int start = 0; start < numFrames; start += kChunkFrames) {
+        const int n = std::min(kChunkFrames, numFrames - start);
+        float* frames = samples + static_cast<size_t>(start) * channels;
+
+        // Mono runs in place; otherwise deinterleave once for all groups
+        bool deinterleaved = false;
+        for (int g = 0; g < numGroups; g++) {
+            float* groupState = state.data() + static_cast<size_t>(g) * 2 * kLanes;
+            const size_t channelStride = static_cast<size_t>(numGroups) * 2 * kLanes;
+
+            if (isGroupIdentity(groups[g])) {
+                // Flat: nothing to do, and no stale history when it comes back
+                for (int ch = 0; ch < channels; ch++) {
+                    std::fill_n(groupState + ch * channelStride, 2 * kLanes, 0.0f);
+                }
+                continue;
+            }
+
+            if (channels > 1 && !deinterleaved) {
+                for (int ch = 0; ch < channels; ch++) {
+                    float* plane = scratch.data() + ch * kChunkFrames;
+                    for (int i = 0; i < n; i++) plane[i] = frames[i * channels + ch];
+                }
+                deinterleaved = true;
+            }
+
+            // Every pass starts the glide from the same point; the last one keeps it
+            const Group glideStart = groups[g];
+            for (int ch = 0; ch < channels;) {
+                Group pass = glideStart;
+                if (channels - ch >= 2) {
+                    float* passState[2] = { groupState + ch * channelStride,
+                                            groupState + (ch + 1) * channelStride };
+                    float* bufs[2] = { scratch.data() + ch * kChunkFrames,
+                                       scratch.data() + (ch + 1) * kChunkFrames };
+                    runGroup<2>(pass, passState, bufs, n);
+                    ch += 2;
+                } else {
+                    float* passState[1] = { groupState + ch * channelStride };
+                    float* bufs[1] = { channels == 1 ? frames : scratch.data() + ch * kChunkFrames };
+                    runGroup<1>(pass, passState, bufs, n);
+                    ch += 1;
+                }
+                groups[g] = pass;
+            }
+        }
+
+        if (deinterleaved) {
+            for (int ch = 0; ch < channels; ch++) {
+                const float* plane = scratch.data() + ch * kChunkFrames;
+                for (int i = 0; i < n; i++) frames[i * channels + ch] = plane[i];
+            }
+        }
+    }
+}
+
+void BiquadCascade::reset() {
+    std::fill(state.begin(), state.end(), 0.0f);
+    for (Group& group : groups) {
+        std::memcpy(group.coeffs, group.target, sizeof(group.coeffs));
+        group.rampFrames = 0;
+    }
+}
+
+// =============================================================================
+// PARAMETRIC EQUALIZER
+// =============================================================================
+
+namespace {
+
+constexpr float kEqFrequencies[ParametricEqualizer::kBands] = {
+    31.0f, 62.0f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f,
+};
+
+constexpr float kEqPeakingQ = 1.41f;  // One octave wide
+constexpr float kEqShelfSlope = 0.707f;
+
+} // namespace
+
+void ParametricEqualizer::configure(int sampleRate, int channels) {
+    filter.configure(sampleRate, channels, kBands);
+    for (int b = 0; b < kBands; b++) updateBand(b);
+    reset();
+}
+
+void ParametricEqualizer::setBandGain(int band, float gainDb) {
+    if (band < 0 || band >= kBands) return;
+    gainsDb[band] = std::clamp(gainDb, -kMaxGainDb, kMaxGainDb);
+    updateBand(band);
+}
+
+float ParametricEqualizer::getBandFrequency(int band) {
+    return kEqFrequencies[std::clamp(band, 0, kBands - 1)];
+}
+
+void ParametricEqualizer::updateBand(int band) {
+    if (band == 0) {
+        filter.setSection(band, BiquadType::LowShelf, kEqFrequencies[band], kEqShelfSlope, gainsDb[band]);
+    } else if (band == kBands - 1) {
+        filter.setSection(band, BiquadType::HighShelf, kEqFrequencies[band], kEqShelfSlope, gainsDb[band]);
+    } else {
+        filter.setSection(band, BiquadType::Peaking, kEqFrequencies[band], kEqPeakingQ, gainsDb[band]);
+    }
+}
+
+} // namespace ultramusic
@@ -0,0 +1,198 @@
+/**
+ * BATTLE CHAIN Implementation
+ *
+ * Fused kernel for the battle chain (EQ -> bass boost -> sub-harmonic ->
+ * exciter -> compressor -> limiter). One specialization per (channel count,
+ * stage mask); selectBattleChain() hands out the matching function pointer.
+ *
+ * Audio is walked in 64-frame tiles so it stays in L1 between the stages.
+ */
+
+#include "battle_chain.h"
+#include "battle_vector_ops.h"
+
+#include <array>
+#include <utility>
+
+namespace ultramusic {
+
+namespace {
+
+constexpr int kTileFrames = 64;
+
+// =============================================================================
+// GAIN PASS - Stateless per-frame gain (+ ceiling clamp), vectorized
+// =============================================================================
+
+template <int Channels, bool Clamp>
+inline void applyFrameGains(float* samples, const float* gains, int numFrames, int channels,
+                            float ceiling) {
+    int i = 0;
+
+    if constexpr (Channels == 2) {
+#if BATTLE_SIMD_NEON
+        const float32x4_t hi = vdupq_n_f32(ceiling);
+        const float32x4_t lo = vdupq_n_f32(-ceiling);
+        for (; i + 4 <= numFrames; i += 4) {
+            // {g0,g1,g2,g3} -> {g0,g0,g1,g1}, {g2,g2,g3,g3}
+            float32x4_t g = vld1q_f32(gains + i);
+            float32x4x2_t gg = vzipq_f32(g, g);
+            float32x4_t a = vmulq_f32(vld1q_f32(samples + i * 2), gg.val[0]);
+            float32x4_t b = vmulq_f32(vld1q_f32(samples + i * 2 + 4), gg.val[1]);
+            if (Clamp) {
+                a = vminq_f32(vmaxq_f32(a, lo), hi);
+                b = vminq_f32(vmaxq_f32(b, lo), hi);
+            }
+            vst1q_f32(samples + i * 2, a);
+            vst1q_f32(samples + i * 2 + 4, b);
+        }
+#elif BATTLE_SIMD_SSE2
+        const __m128 hi = _mm_set1_ps(ceiling);
+        const __m128 lo = _mm_set1_ps(-ceiling);
+        for (; i + 4 <= numFrames; i += 4) {
+            __m128 g = _mm_loadu_ps(gains + i);
+            __m128 a = _mm_mul_ps(_mm_loadu_ps(samples + i * 2), _mm_unpacklo_ps(g, g));
+            __m128 b = _mm_mul_ps(_mm_loadu_ps(samples + i * 2 + 4), _mm_unpackhi_ps(g, g));
+            if (Clamp) {
+                a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+                b = _mm_min_ps(_mm_max_ps(b, lo), hi);
+            }
+            _mm_storeu_ps(samples + i * 2, a);
+            _mm_storeu_ps(samples + i * 2 + 4, b);
+        }
+#endif
+    } else if constexpr (Channels == 1) {
+#if BATTLE_SIMD_NEON
+        const float32x4_t hi = vdupq_n_f32(ceiling);
+        const float32x4_t lo = vdupq_n_f32(-ceiling);
+        for (; i + 4 <= numFrames; i += 4) {
+            float32x4_t a = vmulq_f32(vld1q_f32(samples + i), vld1q_f32(gains + i));
+            if (Clamp) a = vminq_f32(vmaxq_f32(a, lo), hi);
+            vst1q_f32(samples + i, a);
+        }
+#elif BATTLE_SIMD_SSE2
+        const __m128 hi = _mm_set1_ps(ceiling);
+        const __m128 lo = _mm_set1_ps(-ceiling);
+        for (; i + 4 <= numFrames; i += 4) {
+            __m128 a = _mm_mul_ps(_mm_loadu_ps(samples + i), _mm_loadu_ps(gains + i));
+            if (Clamp) a = _mm_min_ps(_mm_max_ps(a, lo), hi);
+            _mm_storeu_ps(samples + i, a);
+        }
+#endif
+    }
+
+    for (; i < numFrames; i++) {
+        for (int ch = 0; ch < channels; ch++) {
+            float sample = samples[i * channels + ch] * gains[i];
+            if (Clamp) sample = std::clamp(sample, -ceiling, ceiling);
+            samples[i * channels + ch] = sample;
+        }
+    }
+}
+
+} // namespace
+
+// =============================================================================
+// FUSED KERNEL
+// Channels > 0: compile-time channel count, all state in locals.
+// Channels == 0: runtime channel count.
+// =============================================================================
+
+template <int Channels, unsigned Stages>
+struct BattleChainKernel {
+    static constexpr bool kEqualizer = (Stages & kChainEqualizer) != 0;
+    static constexpr bool kBass = (Stages & kChainBassBoost) != 0;
+    static constexpr bool kSub = (Stages & kChainSubHarmonic) != 0;
+    static constexpr bool kExciter = (Stages & kChainExciter) != 0;
+    static constexpr bool kCompressor = (Stages & kChainCompressor) != 0;
+    static constexpr bool kLimiter = (Stages & kChainLimiter) != 0;
+
+    static void process(const BattleChain& chain, float* samples, int numFrames) {
+        if constexpr (Stages == 0) {
+            return;
+        } else {
+            const int channels = Channels > 0 ? Channels : chain.channels;
+            const int psychoChannels = std::min(channels, 2);
+
+            // --- Limiter (lookahead: planned per tile, applied to the delayed tile) ---
+            BattleLimiter* limiter = chain.limiter;
+            float limCeiling = 1;
+            if constexpr (kLimiter) {
+                limCeiling = limiter->ceiling;
+            }
+
+            float gains[kTileFrames];
+
+            for (int start = 0; start < numFrames; start += kTileFrames) {
+                const int tileFrames = std::min(kTileFrames, numFrames - start);
+                float* tile = samples + start * channels;
+
+                // Pass 1: EQ and bass boost, each a SIMD biquad cascade over the tile
+                if constexpr (kEqualizer) {
+                    chain.equalizer->process(tile, tileFrames);
+                }
+                if constexpr (kBass) {
+                    chain.bassBoost->process(tile, tileFrames);
+                }
+
+                // Pass 2: psychoacoustic stages, a whole channel of the tile per call
+                // (the exciter saturates at 2x oversampling, vectorized over the tile)
+                for (int ch = 0; ch < psychoChannels; ch++) {
+                    if constexpr (kSub) {
+                        chain.subHarmonic[ch]->process(tile + ch, tileFrames, channels);
+                    }
+                    if constexpr (kExciter) {
+                        chain.exciter[ch]->process(tile + ch, tileFrames, channels);
+                    }
+                }
+
+                // Pass 3: multiband compressor over the tile (SIMD across its bands)
+                if constexpr (kCompressor) {
+                    chain.compressor->process(tile, tileFrames);
+                }
+
+                // Pass 4: limiter - true peaks of the compressed tile plan the gains,
+                // the tile swaps through the lookahead delay, then gain + safety ceiling
+                if constexpr (kLimiter) {
+                    limiter->truePeak.process(tile, tileFrames, gains);
+                    for (int i = 0; i < tileFrames; i++) {
+                        gains[i] = limiter->planGain(gains[i]);
+                    }
+                    limiter->delayFrames(tile, tileFrames);
+                    applyFrameGains<Channels, true>(tile, gains, tileFrames, channels, limCeiling);
+                }
+            }
+        }
+    }
+};
+
+// =============================================================================
+// KERNEL TABLES - Every stage mask for mono, stereo and N channels
+// =============================================================================
+
+namespace {
+
+template <int Channels, unsigned... Masks>
+constexpr std::array<BattleChainFn, sizeof...(Masks)> makeKernelTable(
+        std::integer_sequence<unsigned, Masks...>) {
+    return {{ &BattleChainKernel<Channels, Masks>::process... }};
+}
+
+using StageMasks = std::make_integer_sequence<unsigned, kChainAllStages + 1>;
+
+constexpr auto kMonoKernels = makeKernelTable<1>(StageMasks{});
+constexpr auto kStereoKernels = makeKernelTable<2>(StageMasks{});
+constexpr auto kGenericKernels = makeKernelTable<0>(StageMasks{});
+
+} // namespace
+
+BattleChainFn selectBattleChain(int channels, unsigned stages) {
+    stages &= kChainAllStages;
+    switch (channels) {
+        case 1: return kMonoKernels[stages];
+        case 2: return kStereoKernels[stages];
+        default: return kGenericKernels[stages];
+    }
+}
+
+} // namespace ultramusic
@@ -0,0 +1,90 @@
+/**
+ * BATTLE CHAIN - Header
+ *
+ * Fused battle processing kernel.
+ *
+ * Instead of running EQ, bass boost, sub-harmonic, exciter, compressor and
+ * limiter as six separate passes over the output buffer, every frame goes
+ * through all active stages in one pass over small cache-resident tiles:
+ *
+ *   1. Biquad pass: EQ and bass boost on the SIMD biquad cascade, which is
+ *      vectorized across filter sections instead of across frames
+ *   2. Psychoacoustic pass: sub-harmonic and exciter a channel at a time;
+ *      the exciter saturates at 2x oversampling, vectorized across the tile
+ *   3. SIMD pass:   the multiband compressor, vectorized across its four
+ *      bands instead of across frames, then gain multiply + ceiling clamp
+ *
+ * The limiter looks ahead: its gain is planned from each tile's peaks and
+ * applied to the tile as it comes out of the limiter's delay line, so the
+ * chain delays the signal by BattleLimiter::getLatencyFrames() while the
+ * limiter stage is active.
+ *
+ * The kernel is a template over the channel count and a bitmask of enabled
+ * stages, so disabled stages cost nothing and no per-sample branches remain.
+ */
+
+#ifndef BATTLE_CHAIN_H
+#define BATTLE_CHAIN_H
+
+#include "battle_audio_engine.h"
+
+namespace ultramusic {
+
+// =============================================================================
+// CHAIN STAGES - Bitmask selecting which stages the kernel runs
+// =============================================================================
+
+enum BattleChainStage : unsigned {
+    kChainBassBoost   = 1u << 0,
+    kChainSubHarmonic = 1u << 1,
+    kChainExciter     = 1u << 2,
+    kChainCompressor  = 1u << 3,
+    kChainLimiter     = 1u << 4,
+    kChainEqualizer   = 1u << 5,
+};
+
+constexpr unsigned kChainStageCount = 6;
+constexpr unsigned kChainAllStages = (1u << kChainStageCount) - 1;
+
+// Sub-harmonic + exciter only
+constexpr unsigned kChainPsychoacousticStages = kChainSubHarmonic | kChainExciter;
+
+// What the Superpowered engine borrows from the chain (it has its own
+// bass EQ, compressor and limiter, but no 10-band EQ)
+constexpr unsigned kChainSuperpoweredStages = kChainEqualizer | kChainPsychoacousticStages;
+
+// Compressor + limiter: the back half of the chain, which offline rendering
+// runs on its own worker thread (each processor only ever sees one thread)
+constexpr unsigned kChainDynamicsStages = kChainCompressor | kChainLimiter;
+
+// =============================================================================
+// BATTLE CHAIN - The processors a kernel runs over (not owned)
+// =============================================================================
+
+struct BattleChain {
+    ParametricEqualizer* equalizer = nullptr;
+    BattleBassBoost* bassBoost = nullptr;
+    SubHarmonicSynthesizer* subHarmonic[2] = { nullptr, nullptr };  // L, R
+    BassExciter* exciter[2] = { nullptr, nullptr };                 // L, R
+    MultibandCompressor* compressor = nullptr;
+    BattleLimiter* limiter = nullptr;
+    int channels = 2;
+};
+
+// Kernel signature: process numFrames interleaved frames in place
+using BattleChainFn = void (*)(const BattleChain& chain, float* samples, int numFrames);
+
+// Specialized kernel for the given channel count and stage mask.
+// Mono and stereo get dedicated code; other channel counts use a generic kernel.
+BattleChainFn selectBattleChain(int channels, unsigned stages);
+
+// One-shot convenience: select and run
+inline void processBattleChain(const BattleChain& chain, unsigned stages,
+                               float* samples, int numFrames) {
+    if (stages == 0 || numFrames <= 0) return;
+    selectBattleChain(chain.channels, stages)(chain, samples, numFrames);
+}
+
+} // namespace ultramusic
+
+#endif // BATTLE_CHAIN_H
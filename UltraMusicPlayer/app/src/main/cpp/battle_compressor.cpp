@@ -6,6 +6,7 @@
  */
 
 #include "battle_audio_engine.h"
+#include "battle_vector_ops.h"
 
 namespace ultramusic {
 
@@ -21,9 +22,71 @@ float calculateGainReduction(float inputDb, float threshold, float ratio, float
         return (threshold - inputDb) * (1.0f - 1.0f / ratio);
     }
     
-    // In knee region (smooth transition)
+    // In knee region (smooth transition, same sign as above the knee)
     float x = inputDb - threshold + knee / 2;
-    return x * x / (2.0f * knee) * (1.0f - 1.0f / ratio);
+    return -x * x / (2.0f * knee) * (1.0f - 1.0f / ratio);
+}
+
+// =============================================================================
+// BLOCK GAIN COMPUTER
+// Same curve as calculateGainReduction, evaluated in log2 units so the level
+// detector is one log2 and the gain one exp2:
+//   x = log2(env), d = x - T
+//   y = d                    above the knee (d >= K/2)
+//   y = (d + K/2)^2 / (2K)   inside it, 0 below
+//   gain = 2^(slope * y)     slope = 1/ratio - 1
+// =============================================================================
+
+namespace {
+
+constexpr float kLog2PerDb = 0.166096405f;  // log2(10) / 20
+constexpr float kEnvelopeFloor = 0.00001f;  // -100 dB, as in linearToDb
+
+} // namespace
+
+void computeCompressorGains(const float* envelope, const float* slopes, float* gains,
+                            int numFrames, float thresholdDb, float kneeDb) {
+    const float t = thresholdDb * kLog2PerDb;
+    const float halfKnee = 0.5f * kneeDb * kLog2PerDb;
+    const float invTwoKnee = halfKnee > 0.0f ? 0.25f / halfKnee : 0.0f;
+
+    int i = 0;
+#if BATTLE_SIMD_NEON
+    const float32x4_t vt = vdupq_n_f32(t);
+    const float32x4_t vHalf = vdupq_n_f32(halfKnee);
+    const float32x4_t vInv = vdupq_n_f32(invTwoKnee);
+    const float32x4_t vFloor = vdupq_n_f32(kEnvelopeFloor);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= numFrames; i += 4) {
+        float32x4_t x = log2Approx(vmaxq_f32(vld1q_f32(envelope + i), vFloor));
+        float32x4_t d = vsubq_f32(x, vt);
+        float32x4_t over = vmaxq_f32(vaddq_f32(d, vHalf), zero);
+        float32x4_t knee = vmulq_f32(vmulq_f32(over, over), vInv);
+        float32x4_t y = vbslq_f32(vcgeq_f32(d, vHalf), d, knee);
+        vst1q_f32(gains + i, exp2Approx(vmulq_f32(vld1q_f32(slopes + i), y)));
+    }
+#elif BATTLE_SIMD_SSE2
+    const __m128 vt = _mm_set1_ps(t);
+    const __m128 vHalf = _mm_set1_ps(halfKnee);
+    const __m128 vInv = _mm_set1_ps(invTwoKnee);
+    const __m128 vFloor = _mm_set1_ps(kEnvelopeFloor);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= numFrames; i += 4) {
+        __m128 x = log2Approx(_mm_max_ps(_mm_loadu_ps(envelope + i), vFloor));
+        __m128 d = _mm_sub_ps(x, vt);
+        __m128 over = _mm_max_ps(_mm_add_ps(d, vHalf), zero);
+        __m128 knee = _mm_mul_ps(_mm_mul_ps(over, over), vInv);
+        __m128 above = _mm_cmpge_ps(d, vHalf);
+        __m128 y = _mm_or_ps(_mm_and_ps(above, d), _mm_andnot_ps(above, knee));
+        _mm_storeu_ps(gains + i, exp2Approx(_mm_mul_ps(_mm_loadu_ps(slopes + i), y)));
+    }
+#endif
+    for (; i < numFrames; i++) {
+        float d = log2Approx(std::max(envelope[i], kEnvelopeFloor)) - t;
+        float over = std::max(d + halfKnee, 0.0f);
+        float y = d >= halfKnee ? d : over * over * invTwoKnee;
+        gains[i] = exp2Approx(slopes[i] * y);
+    }
 }
 
 // Convert linear to dB
@@ -37,34 +100,284 @@ float dbToLinear(float db) {
     return std::pow(10.0f, db / 20.0f);
 }
 
+// =============================================================================
+// PARALLEL COMPRESSOR
+// =============================================================================
+
+void ParallelCompressor::configure(int sampleRate, int channels) {
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+
+    // One-pole smoothing toward the rectified input: coeff = 1 - e^(-1 / time)
+    attackCoeff = 1.0f - std::exp(-1.0f / (attackMs * sampleRate / 1000.0f));
+    releaseCoeff = 1.0f - std::exp(-1.0f / (releaseMs * sampleRate / 1000.0f));
+    makeup = dbToLinear(makeupDb);
+
+    envelopes.assign(channels, 0.0f);
+}
+
+void ParallelCompressor::reset() {
+    std::fill(envelopes.begin(), envelopes.end(), 0.0f);
+}
+
 // Parallel compression for more punch
-void parallelCompress(float* samples, int numSamples, float wetDry) {
-    // Heavy compression settings
-    const float threshold = -20.0f;
-    const float ratio = 8.0f;
-    const float attack = 0.001f;
-    const float release = 0.1f;
-    const float makeupGain = 12.0f;  // Heavy makeup for NY compression
-    
-    static float envelope = 0.0f;
-    
-    for (int i = 0; i < numSamples; i++) {
-        float input = samples[i];
-        float absInput = std::abs(input);
-        
-        // Envelope detection
-        float coeff = absInput > envelope ? attack : release;
-        envelope = envelope + coeff * (absInput - envelope);
-        
-        // Gain calculation
-        float inputDb = linearToDb(envelope);
-        float gainReduction = calculateGainReduction(inputDb, threshold, ratio, 6.0f);
-        float gain = dbToLinear(gainReduction + makeupGain);
-        
-        // Mix dry and wet
-        float compressed = input * gain;
-        samples[i] = input * (1.0f - wetDry) + compressed * wetDry;
+void ParallelCompressor::process(float* samples, int numFrames) {
+    if (mix <= 0.0f) return;
+
+    constexpr int kBlock = 64;
+    float levels[kBlock];
+    float slopes[kBlock];
+    float gains[kBlock];
+    std::fill(slopes, slopes + kBlock, 1.0f / ratio - 1.0f);
+
+    const float dry = 1.0f - mix;
+    const float wet = mix * makeup;
+
+    for (int start = 0; start < numFrames; start += kBlock) {
+        const int count = std::min(kBlock, numFrames - start);
+        float* block = samples + start * channels;
+
+        for (int ch = 0; ch < channels; ch++) {
+            // Envelope detection
+            float envelope = envelopes[ch];
+            for (int i = 0; i < count; i++) {
+                float absInput = std::abs(block[i * channels + ch]);
+                float coeff = absInput > envelope ? attackCoeff : releaseCoeff;
+                envelope = envelope + coeff * (absInput - envelope);
+                levels[i] = envelope;
+            }
+            envelopes[ch] = envelope;
+
+            // Gain calculation (whole block, log domain)
+            computeCompressorGains(levels, slopes, gains, count, thresholdDb, kneeDb);
+
+            // Mix dry and wet
+            for (int i = 0; i < count; i++) {
+                float input = block[i * channels + ch];
+                block[i * channels + ch] = input * (dry + gains[i] * wet);
+            }
+        }
+    }
+}
+
+// =============================================================================
+// MULTIBAND COMPRESSOR
+// =============================================================================
+
+namespace {
+
+using namespace vec4;
+
+} // namespace
+
+void MultibandCompressor::configure(int sampleRate, int channels) {
+    this->sampleRate = sampleRate;
+    this->channels = channels;
+    filterState.assign(static_cast<size_t>(channels) * kSections * 2 * kBands, 0.0f);
+    bandScratch.assign(static_cast<size_t>(channels) * kBands, 0.0f);
+    updateFilters();
+    updateBands();
+    reset();
+}
+
+void MultibandCompressor::setRatio(float ratio) {
+    this->ratio = std::max(1.0f, ratio);
+    const int rampFrames = parameterRampFrames(sampleRate);
+    for (int b = 0; b < kBands; b++) {
+        float bandRatio = 1.0f + (this->ratio - 1.0f) * ratioScale[b];
+        slopeTarget[b] = 1.0f / bandRatio - 1.0f;
+        slopeStep[b] = (slopeTarget[b] - slope[b]) / rampFrames;
     }
+    slopeRampFrames = rampFrames;
+}
+
+void MultibandCompressor::setCrossovers(float lowHz, float midHz, float highHz) {
+    crossoverHz[0] = lowHz;
+    crossoverHz[1] = std::max(midHz, lowHz * 2.0f);
+    crossoverHz[2] = std::max(highHz, crossoverHz[1] * 2.0f);
+    updateFilters();
+}
+
+// Lane layout per section:
+//   0, 1: LR4 at the mid crossover   { low,  low,  high, high }
+//   2, 3: LR4 at the outer crossovers { low@lo, high@lo, low@hi, high@hi }
+//   4:    allpass compensation        { ap@hi, ap@hi, ap@lo, ap@lo }
+void MultibandCompressor::updateFilters() {
+    // Butterworth Q: two in series = Linkwitz-Riley 4th order
+    const float q = 0.70710678f;
+    const BiquadCoefficients lowLp = designBiquad(BiquadType::LowPass, crossoverHz[0], q, 0.0f, sampleRate);
+    const BiquadCoefficients lowHp = designBiquad(BiquadType::HighPass, crossoverHz[0], q, 0.0f, sampleRate);
+    const BiquadCoefficients lowAp = designBiquad(BiquadType::AllPass, crossoverHz[0], q, 0.0f, sampleRate);  // LR4 low + high sum
+    const BiquadCoefficients midLp = designBiquad(BiquadType::LowPass, crossoverHz[1], q, 0.0f, sampleRate);
+    const BiquadCoefficients midHp = designBiquad(BiquadType::HighPass, crossoverHz[1], q, 0.0f, sampleRate);
+    const BiquadCoefficients highLp = designBiquad(BiquadType::LowPass, crossoverHz[2], q, 0.0f, sampleRate);
+    const BiquadCoefficients highHp = designBiquad(BiquadType::HighPass, crossoverHz[2], q, 0.0f, sampleRate);
+    const BiquadCoefficients highAp = designBiquad(BiquadType::AllPass, crossoverHz[2], q, 0.0f, sampleRate);
+
+    const BiquadCoefficients* lanes[kSections][kBands] = {
+        { &midLp, &midLp, &midHp, &midHp },
+        { &midLp, &midLp, &midHp, &midHp },
+        { &lowLp, &lowHp, &highLp, &highHp },
+        { &lowLp, &lowHp, &highLp, &highHp },
+        { &highAp, &highAp, &lowAp, &lowAp },
+    };
+    for (int s = 0; s < kSections; s++) {
+        for (int b = 0; b < kBands; b++) {
+            const BiquadCoefficients& c = *lanes[s][b];
+            coeffs[s][0][b] = c.b0;
+            coeffs[s][1][b] = c.b1;
+            coeffs[s][2][b] = c.b2;
+            coeffs[s][3][b] = c.a1;
+            coeffs[s][4][b] = c.a2;
+        }
+    }
+}
+
+void MultibandCompressor::updateBands() {
+    for (int b = 0; b < kBands; b++) {
+        thresholdLog2[b] = thresholdDb[b] * kLog2PerDb;
+        halfKnee[b] = 0.5f * kneeDb * kLog2PerDb;
+        invTwoKnee[b] = halfKnee[b] > 0.0f ? 0.25f / halfKnee[b] : 0.0f;
+        makeup[b] = dbToLinear(makeupDb[b]);
+        attackCoeff[b] = std::exp(-1.0f / (attackMs[b] * sampleRate / 1000.0f));
+        releaseCoeff[b] = std::exp(-1.0f / (releaseMs[b] * sampleRate / 1000.0f));
+    }
+    setRatio(ratio);
+}
+
+void MultibandCompressor::reset() {
+    std::fill(filterState.begin(), filterState.end(), 0.0f);
+    std::fill(envelope, envelope + kBands, 0.0f);
+    std::fill(gain, gain + kBands, 1.0f);
+    std::copy(slopeTarget, slopeTarget + kBands, slope);
+    slopeRampFrames = 0;
+}
+
+void MultibandCompressor::process(float* samples, int numFrames) {
+    if (!enabled) return;
+
+    switch (channels) {
+        case 1:  processChannels<1>(samples, numFrames); break;
+        case 2:  processChannels<2>(samples, numFrames); break;
+        default: processChannels<0>(samples, numFrames); break;
+    }
+}
+
+// Channels > 0: filter state held in registers for the whole block.
+// Channels == 0: runtime channel count, filter state stays in filterState.
+template <int Channels>
+void MultibandCompressor::processChannels(float* samples, int numFrames) {
+    const int numChannels = Channels > 0 ? Channels : channels;
+    constexpr int kStateChannels = Channels > 0 ? Channels : 1;
+    constexpr int kChannelState = kSections * 2 * kBands;
+
+    // Everything per band lives in registers for the whole block
+    Lanes c[kSections][5];
+    for (int s = 0; s < kSections; s++) {
+        for (int k = 0; k < 5; k++) c[s][k] = load(coeffs[s][k]);
+    }
+    const Lanes threshold = load(thresholdLog2);
+    const Lanes knee = load(halfKnee);
+    const Lanes kneeScale = load(invTwoKnee);
+    const Lanes makeupGain = load(makeup);
+    const Lanes attack = load(attackCoeff);
+    const Lanes release = load(releaseCoeff);
+    const Lanes floor = splat(kEnvelopeFloor);
+    const Lanes zero = splat(0.0f);
+    const Lanes smoothing = splat(0.9f);
+    Lanes env = load(envelope);
+    Lanes bandGain = load(gain);
+    Lanes slopes = load(slope);
+    const Lanes step = load(slopeStep);
+
+    Lanes z[kStateChannels][kSections][2];
+    if constexpr (Channels > 0) {
+        for (int ch = 0; ch < Channels; ch++) {
+            for (int s = 0; s < kSections; s++) {
+                z[ch][s][0] = load(filterState.data() + ch * kChannelState + (s * 2) * kBands);
+                z[ch][s][1] = load(filterState.data() + ch * kChannelState + (s * 2 + 1) * kBands);
+            }
+        }
+    }
+
+    for (int i = 0; i < numFrames; i++) {
+        float* frame = samples + i * numChannels;
+
+        // Split every channel into 4 bands (one lane each); linked detection
+        Lanes peak = zero;
+        Lanes split[kStateChannels];
+        for (int ch = 0; ch < numChannels; ch++) {
+            Lanes v = splat(frame[ch]);
+            for (int s = 0; s < kSections; s++) {
+                // Transposed direct form II
+                Lanes z1, z2;
+                float* state = filterState.data() + ch * kChannelState + (s * 2) * kBands;
+                if constexpr (Channels > 0) {
+                    z1 = z[ch][s][0];
+                    z2 = z[ch][s][1];
+                } else {
+                    z1 = load(state);
+                    z2 = load(state + kBands);
+                }
+                Lanes y = mulAdd(z1, c[s][0], v);
+                z1 = sub(mulAdd(z2, c[s][1], v), mul(c[s][3], y));
+                z2 = sub(mul(c[s][2], v), mul(c[s][4], y));
+                if constexpr (Channels > 0) {
+                    z[ch][s][0] = z1;
+                    z[ch][s][1] = z2;
+                } else {
+                    store(state, z1);
+                    store(state + kBands, z2);
+                }
+                v = y;
+            }
+            if constexpr (Channels > 0) {
+                split[ch] = v;
+            } else {
+                store(bandScratch.data() + ch * kBands, v);
+            }
+            peak = max(peak, abs(v));
+        }
+
+        // Envelope follower: env = peak + coeff * (env - peak)
+        Lanes coeff = selectGreater(peak, env, attack, release);
+        env = mulAdd(peak, coeff, sub(env, peak));
+
+        // Ratio glide
+        if (slopeRampFrames > 0) {
+            slopes = add(slopes, step);
+            if (--slopeRampFrames == 0) slopes = load(slopeTarget);
+        }
+
+        // Soft-knee gain curve in the log2 domain (see computeCompressorGains)
+        Lanes d = sub(log2Lanes(max(env, floor)), threshold);
+        Lanes over = max(add(d, knee), zero);
+        Lanes y = selectGreaterEqual(d, knee, d, mul(mul(over, over), kneeScale));
+        Lanes target = exp2Lanes(mul(slopes, y));
+
+        // Smooth gain (one-pole, 0.9 / 0.1), then makeup
+        bandGain = mulAdd(target, smoothing, sub(bandGain, target));
+        Lanes g = mul(bandGain, makeupGain);
+
+        // Recombine
+        for (int ch = 0; ch < numChannels; ch++) {
+            Lanes bands = Channels > 0 ? split[ch] : load(bandScratch.data() + ch * kBands);
+            frame[ch] = sum(mul(bands, g));
+        }
+    }
+
+    if constexpr (Channels > 0) {
+        for (int ch = 0; ch < Channels; ch++) {
+            for (int s = 0; s < kSections; s++) {
+                store(filterState.data() + ch * kChannelState + (s * 2) * kBands, z[ch][s][0]);
+                store(filterState.data() + ch * kChannelState + (s * 2 + 1) * kBands, z[ch][s][1]);
+            }
+        }
+    }
+
+    store(envelope, env);
+    store(gain, bandGain);
+    store(slope, slopes);
 }
 
 } // namespace ultramusic
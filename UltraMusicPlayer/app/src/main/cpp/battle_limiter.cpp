@@ -3,48 +3,162 @@
  * 
  * True peak limiter with lookahead for zero clipping.
  * Essential for sound system battles where volume is MAXIMUM.
+ *
+ * The limiter class itself is inline in the header; this file holds the
+ * 4x oversampled true-peak detector it (and the output meter) runs on.
  */
 
 #include "battle_audio_engine.h"
+#include "battle_vector_ops.h"
 
 // Implementation is in header (inline class)
 // This file is for any additional limiter functions
 
 namespace ultramusic {
 
-// Advanced true peak detection with oversampling
-float detectTruePeak(const float* samples, int numSamples, int channels) {
-    float maxPeak = 0.0f;
-    
-    for (int i = 0; i < numSamples; i++) {
-        float absVal = std::abs(samples[i]);
-        if (absVal > maxPeak) {
-            maxPeak = absVal;
+// =============================================================================
+// TRUE PEAK DETECTOR
+// =============================================================================
+
+namespace {
+
+// ITU-R BS.1770-4 Annex 2 interpolation filter, laid out tap-major so one
+// vector load gives the coefficient of all 4 phases for tap k (x[n - k])
+alignas(16) constexpr float kTruePeakCoeffs[TruePeakDetector::kTaps][TruePeakDetector::kOversampling] = {
+    {  0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+    {  0.0109863281250f,  0.0292968750000f,  0.0330810546875f,  0.0148925781250f },
+    { -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+    {  0.0332031250000f,  0.0891113281250f,  0.1015625000000f,  0.0476074218750f },
+    { -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+    {  0.1373291015625f,  0.4650878906250f,  0.7797851562500f,  0.9721679687500f },
+    {  0.9721679687500f,  0.7797851562500f,  0.4650878906250f,  0.1373291015625f },
+    { -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+    {  0.0476074218750f,  0.1015625000000f,  0.0891113281250f,  0.0332031250000f },
+    { -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+    {  0.0148925781250f,  0.0330810546875f,  0.0292968750000f,  0.0109863281250f },
+    { -0.0083007812500f, -0.0189208984375f, -0.0291748046875f,  0.0017089843750f },
+};
+
+constexpr int kHistory = TruePeakDetector::kTaps - 1;
+constexpr int kLineLength = kHistory + TruePeakDetector::kChunkFrames;
+
+// Largest interpolated magnitude of each sample in line[kHistory .. kHistory + numFrames).
+// framePeaks (optional) is max-accumulated per frame.
+float interpolatePeaks(const float* line, int numFrames, float* framePeaks) {
+    const float* x = line + kHistory;
+
+#if BATTLE_SIMD_NEON
+    float32x4_t c[TruePeakDetector::kTaps];
+    for (int k = 0; k < TruePeakDetector::kTaps; k++) c[k] = vld1q_f32(kTruePeakCoeffs[k]);
+
+    float32x4_t peak = vdupq_n_f32(0.0f);
+    for (int n = 0; n < numFrames; n++) {
+        // All 4 phases of output sample n at once
+        float32x4_t acc = vmulq_n_f32(c[0], x[n]);
+        for (int k = 1; k < TruePeakDetector::kTaps; k++) {
+            acc = vmlaq_n_f32(acc, c[k], x[n - k]);
+        }
+        acc = vabsq_f32(acc);
+        peak = vmaxq_f32(peak, acc);
+        if (framePeaks) {
+            float32x2_t m = vpmax_f32(vget_low_f32(acc), vget_high_f32(acc));
+            framePeaks[n] = std::max(framePeaks[n], vget_lane_f32(vpmax_f32(m, m), 0));
         }
     }
-    
-    // Estimate inter-sample peaks (simplified)
-    // Full implementation would use 4x oversampling
-    for (int i = 1; i < numSamples - 1; i++) {
-        // Parabolic interpolation for inter-sample peak estimation
-        float y0 = samples[i - 1];
-        float y1 = samples[i];
-        float y2 = samples[i + 1];
-        
-        // If this is a local maximum
-        if ((y1 > y0 && y1 > y2) || (y1 < y0 && y1 < y2)) {
-            float d = (y0 - y2) / (2.0f * (y0 - 2.0f * y1 + y2));
-            if (std::abs(d) < 1.0f) {
-                float peak = y1 - 0.25f * (y0 - y2) * d;
-                float absPeak = std::abs(peak);
-                if (absPeak > maxPeak) {
-                    maxPeak = absPeak;
-                }
+    float32x2_t m = vpmax_f32(vget_low_f32(peak), vget_high_f32(peak));
+    return vget_lane_f32(vpmax_f32(m, m), 0);
+#elif BATTLE_SIMD_SSE2
+    __m128 c[TruePeakDetector::kTaps];
+    for (int k = 0; k < TruePeakDetector::kTaps; k++) c[k] = _mm_load_ps(kTruePeakCoeffs[k]);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    __m128 peak = _mm_setzero_ps();
+    for (int n = 0; n < numFrames; n++) {
+        __m128 acc = _mm_mul_ps(c[0], _mm_set1_ps(x[n]));
+        for (int k = 1; k < TruePeakDetector::kTaps; k++) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(c[k], _mm_set1_ps(x[n - k])));
+        }
+        acc = _mm_and_ps(acc, absMask);
+        peak = _mm_max_ps(peak, acc);
+        if (framePeaks) {
+            __m128 m = _mm_max_ps(acc, _mm_movehl_ps(acc, acc));
+            m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+            framePeaks[n] = std::max(framePeaks[n], _mm_cvtss_f32(m));
+        }
+    }
+    __m128 m = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+#else
+    float peak = 0.0f;
+    for (int n = 0; n < numFrames; n++) {
+        float framePeak = 0.0f;
+        for (int phase = 0; phase < TruePeakDetector::kOversampling; phase++) {
+            float acc = 0.0f;
+            for (int k = 0; k < TruePeakDetector::kTaps; k++) {
+                acc += kTruePeakCoeffs[k][phase] * x[n - k];
             }
+            framePeak = std::max(framePeak, std::abs(acc));
         }
+        peak = std::max(peak, framePeak);
+        if (framePeaks) framePeaks[n] = std::max(framePeaks[n], framePeak);
     }
-    
-    return maxPeak;
+    return peak;
+#endif
+}
+
+} // namespace
+
+void TruePeakDetector::configure(int channels) {
+    this->channels = channels;
+    lines.assign(static_cast<size_t>(channels) * kLineLength, 0.0f);
+    channelPeaks.assign(channels, 0.0f);
+}
+
+void TruePeakDetector::reset() {
+    std::fill(lines.begin(), lines.end(), 0.0f);
+    resetPeaks();
+}
+
+float TruePeakDetector::process(const float* samples, int numFrames, float* framePeaks) {
+    float blockPeak = 0.0f;
+
+    for (int start = 0; start < numFrames; start += kChunkFrames) {
+        const int chunkFrames = std::min(kChunkFrames, numFrames - start);
+        const float* chunk = samples + start * channels;
+        float* chunkPeaks = framePeaks ? framePeaks + start : nullptr;
+        if (chunkPeaks) std::fill(chunkPeaks, chunkPeaks + chunkFrames, 0.0f);
+
+        for (int ch = 0; ch < channels; ch++) {
+            float* line = lines.data() + ch * kLineLength;
+
+            // Channel ch of the chunk goes right after the filter history
+            for (int n = 0; n < chunkFrames; n++) {
+                line[kHistory + n] = chunk[n * channels + ch];
+            }
+
+            float peak = interpolatePeaks(line, chunkFrames, chunkPeaks);
+            channelPeaks[ch] = std::max(channelPeaks[ch], peak);
+            blockPeak = std::max(blockPeak, peak);
+
+            // Newest samples become the history for the next chunk
+            std::copy(line + chunkFrames, line + chunkFrames + kHistory, line);
+        }
+    }
+
+    return blockPeak;
+}
+
+// One-shot true peak (allocates - not for the audio thread)
+float detectTruePeak(const float* samples, int numSamples, int channels) {
+    if (channels <= 0) return 0.0f;
+    TruePeakDetector detector;
+    detector.configure(channels);
+    float peak = detector.process(samples, numSamples / channels);
+
+    // Flush the interpolator so the last samples are looked at too
+    std::vector<float> tail(TruePeakDetector::kDelayFrames * channels, 0.0f);
+    return std::max(peak, detector.process(tail.data(), TruePeakDetector::kDelayFrames));
 }
 
 // Soft clip function for gentle limiting
@@ -0,0 +1,454 @@
+/**
+ * BATTLE OFFLINE Implementation
+ *
+ * WAV streaming in and out, the chunk pipeline used by offline rendering and
+ * the work-stealing pool that spreads batch renders over the big cores.
+ * WAV data is little-endian, as is every ABI the app ships for (arm64, armv7,
+ * x86, x86_64), so 16-bit and float samples are converted straight from the
+ * bytes read.
+ */
+
+#include "battle_offline.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace ultramusic {
+
+namespace {
+
+constexpr uint16_t kWavFormatPcm = 1;
+constexpr uint16_t kWavFormatFloat = 3;
+constexpr uint16_t kWavFormatExtensible = 0xFFFE;
+
+constexpr long kWavHeaderBytes = 44;
+
+uint16_t readLE16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void writeLE16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void writeLE32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+} // namespace
+
+// =============================================================================
+// WAV READER
+// =============================================================================
+
+bool WavReader::open(const char* path) {
+    close();
+    file = std::fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t riff[12];
+    if (std::fread(riff, 1, sizeof(riff), file) != sizeof(riff) ||
+        std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        close();
+        return false;
+    }
+
+    // Walk the chunks for "fmt " and "data"; anything else (LIST, fact...) is skipped
+    bool haveFormat = false;
+    uint16_t format = 0;
+    int bits = 0;
+    uint8_t header[8];
+    while (std::fread(header, 1, sizeof(header), file) == sizeof(header)) {
+        const uint32_t size = readLE32(header + 4);
+
+        if (std::memcmp(header, "fmt ", 4) == 0) {
+            uint8_t fmt[40] = {};
+            const size_t wanted = std::min<size_t>(size, sizeof(fmt));
+            if (size < 16 || std::fread(fmt, 1, wanted, file) != wanted) break;
+            format = readLE16(fmt);
+            channels = readLE16(fmt + 2);
+            sampleRate = static_cast<int>(readLE32(fmt + 4));
+            bits = readLE16(fmt + 14);
+            if (format == kWavFormatExtensible && size >= 26) {
+                format = readLE16(fmt + 24);  // First two bytes of the sub-format GUID
+            }
+            haveFormat = true;
+            std::fseek(file, static_cast<long>((size - wanted) + (size & 1)), SEEK_CUR);
+        } else if (std::memcmp(header, "data", 4) == 0) {
+            if (!haveFormat) break;
+            dataOffset = std::ftell(file);
+
+            // Streaming writers leave the size open (0 or 0xFFFFFFFF): trust the file length
+            std::fseek(file, 0, SEEK_END);
+            const long available = std::ftell(file) - dataOffset;
+            std::fseek(file, dataOffset, SEEK_SET);
+            int64_t dataBytes = size;
+            if (dataBytes == 0 || dataBytes > available) dataBytes = available;
+
+            floatSamples = format == kWavFormatFloat && bits == 32;
+            const bool pcm = format == kWavFormatPcm && (bits == 16 || bits == 24);
+            if ((!floatSamples && !pcm) || channels <= 0 || sampleRate <= 0) break;
+
+            bytesPerSample = bits / 8;
+            totalFrames = dataBytes / (static_cast<int64_t>(bytesPerSample) * channels);
+            framesRead = 0;
+            return true;
+        } else {
+            std::fseek(file, static_cast<long>(size + (size & 1)), SEEK_CUR);
+        }
+    }
+
+    close();
+    return false;
+}
+
+void WavReader::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+    totalFrames = 0;
+    framesRead = 0;
+}
+
+int WavReader::read(float* output, int maxFrames) {
+    if (!file || maxFrames <= 0) return 0;
+
+    const int wanted = static_cast<int>(std::min<int64_t>(maxFrames, totalFrames - framesRead));
+    if (wanted <= 0) return 0;
+
+    const size_t frameBytes = static_cast<size_t>(bytesPerSample) * channels;
+    raw.resize(static_cast<size_t>(wanted) * frameBytes);
+    const int frames = static_cast<int>(std::fread(raw.data(), 1, raw.size(), file) / frameBytes);
+    const int samples = frames * channels;
+
+    if (floatSamples) {
+        std::memcpy(output, raw.data(), static_cast<size_t>(samples) * sizeof(float));
+    } else if (bytesPerSample == 2) {
+        convertInt16ToFloat(reinterpret_cast<const short*>(raw.data()), output, samples);
+    } else {
+        // 24-bit: sign-extend through the top of an int32, then scale
+        const uint8_t* p = raw.data();
+        for (int i = 0; i < samples; i++, p += 3) {
+            const int32_t v = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+                                                   (static_cast<uint32_t>(p[1]) << 16) |
+                                                   (static_cast<uint32_t>(p[2]) << 24));
+            output[i] = static_cast<float>(v) * (1.0f / 2147483648.0f);
+        }
+    }
+
+    framesRead += frames;
+    return frames;
+}
+
+bool WavReader::rewind() {
+    if (!file || std::fseek(file, dataOffset, SEEK_SET) != 0) return false;
+    framesRead = 0;
+    return true;
+}
+
+// =============================================================================
+// WAV WRITER
+// =============================================================================
+
+bool WavWriter::open(const char* path, int sampleRate, int channels, bool floatSamples,
+                     float ceiling, DitherMode ditherMode) {
+    close();
+    if (channels <= 0 || sampleRate <= 0) return false;
+
+    file = std::fopen(path, "wb");
+    if (!file) return false;
+
+    this->channels = channels;
+    this->floatSamples = floatSamples;
+    this->ceiling = ceiling;
+    this->ditherMode = ditherMode;
+    dither.reset();
+    framesWritten = 0;
+    failed = false;
+
+    // Canonical 44-byte header; the two sizes are filled in by close()
+    const uint16_t bits = floatSamples ? 32 : 16;
+    const uint16_t blockAlign = static_cast<uint16_t>(channels * bits / 8);
+    uint8_t header[kWavHeaderBytes] = {};
+    std::memcpy(header, "RIFF", 4);
+    std::memcpy(header + 8, "WAVE", 4);
+    std::memcpy(header + 12, "fmt ", 4);
+    writeLE32(header + 16, 16);
+    writeLE16(header + 20, floatSamples ? kWavFormatFloat : kWavFormatPcm);
+    writeLE16(header + 22, static_cast<uint16_t>(channels));
+    writeLE32(header + 24, static_cast<uint32_t>(sampleRate));
+    writeLE32(header + 28, static_cast<uint32_t>(sampleRate) * blockAlign);
+    writeLE16(header + 32, blockAlign);
+    writeLE16(header + 34, bits);
+    std::memcpy(header + 36, "data", 4);
+
+    if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        failed = true;
+    }
+    return !failed;
+}
+
+bool WavWriter::write(const float* samples, int numFrames) {
+    if (!file || failed) return false;
+    if (numFrames <= 0) return true;
+
+    const size_t numSamples = static_cast<size_t>(numFrames) * channels;
+    size_t written = 0;
+    if (floatSamples) {
+        const float* source = samples;
+        if (ceiling < 1.0f) {
+            clamped.assign(samples, samples + numSamples);
+            clampBlock(clamped.data(), static_cast<int>(numSamples), ceiling);
+            source = clamped.data();
+        }
+        written = std::fwrite(source, sizeof(float), numSamples, file);
+    } else {
+        pcm.resize(numSamples);
+        convertFloatToInt16(samples, pcm.data(), static_cast<int>(numSamples), channels,
+                            ceiling, ditherMode, dither);
+        written = std::fwrite(pcm.data(), sizeof(short), numSamples, file);
+    }
+
+    if (written != numSamples) failed = true;
+    framesWritten += numFrames;
+    return !failed;
+}
+
+bool WavWriter::close() {
+    if (!file) return !failed;
+
+    const int64_t dataBytes = framesWritten * channels * (floatSamples ? 4 : 2);
+    if (dataBytes > 0xFFFFFFFFll - (kWavHeaderBytes - 8)) {
+        failed = true;  // Past what a RIFF size field can describe
+    } else {
+        uint8_t size[4];
+        writeLE32(size, static_cast<uint32_t>(dataBytes + kWavHeaderBytes - 8));
+        failed |= std::fseek(file, 4, SEEK_SET) != 0 || std::fwrite(size, 1, 4, file) != 4;
+        writeLE32(size, static_cast<uint32_t>(dataBytes));
+        failed |= std::fseek(file, 40, SEEK_SET) != 0 || std::fwrite(size, 1, 4, file) != 4;
+    }
+
+    failed |= std::fclose(file) != 0;
+    file = nullptr;
+    return !failed;
+}
+
+// =============================================================================
+// CHUNK PIPELINE
+// =============================================================================
+
+void ChunkPipeline::Queue::push(AudioChunk* chunk) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.push_back(chunk);
+    }
+    ready.notify_one();
+}
+
+AudioChunk* ChunkPipeline::Queue::pop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [this] { return !chunks.empty() || closed; });
+    if (chunks.empty()) return nullptr;
+    AudioChunk* chunk = chunks.front();
+    chunks.pop_front();
+    return chunk;
+}
+
+void ChunkPipeline::Queue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    ready.notify_all();
+}
+
+ChunkPipeline::ChunkPipeline(std::vector<Stage> stageList, int chunkFrames, int channels,
+                             bool threaded, int depth)
+    : chunkFrames(chunkFrames), threaded(threaded), stages(std::move(stageList)) {
+    depth = threaded ? std::max(depth, static_cast<int>(stages.size()) + 1) : 1;
+    for (int i = 0; i < depth; i++) {
+        pool.push_back(std::make_unique<AudioChunk>());
+        pool.back()->samples.assign(static_cast<size_t>(chunkFrames) * channels, 0.0f);
+        freeChunks.push(pool.back().get());
+    }
+
+    if (!threaded) return;
+
+    for (size_t i = 0; i < stages.size(); i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < stages.size(); i++) {
+        workers.emplace_back(&ChunkPipeline::runStage, this, i);
+    }
+}
+
+AudioChunk* ChunkPipeline::acquire() {
+    AudioChunk* chunk = freeChunks.pop();
+    chunk->frames = 0;
+    return chunk;
+}
+
+void ChunkPipeline::submit(AudioChunk* chunk) {
+    if (!threaded || stages.empty()) {
+        for (Stage& stage : stages) stage(*chunk);
+        freeChunks.push(chunk);
+        return;
+    }
+    queues.front()->push(chunk);
+}
+
+void ChunkPipeline::finish() {
+    if (finished) return;
+    finished = true;
+
+    // Closing the first queue ripples down: each stage closes the next once drained
+    if (!queues.empty()) queues.front()->close();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ChunkPipeline::runStage(size_t index) {
+    const bool last = index + 1 == stages.size();
+    while (AudioChunk* chunk = queues[index]->pop()) {
+        stages[index](*chunk);
+        if (last) {
+            freeChunks.push(chunk);
+        } else {
+            queues[index + 1]->push(chunk);
+        }
+    }
+    if (!last) queues[index + 1]->close();
+}
+
+// =============================================================================
+// WORK-STEALING POOL
+// =============================================================================
+
+std::vector<int> WorkStealingPool::bigCores() {
+    const int cpus = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> all(cpus);
+    for (int cpu = 0; cpu < cpus; cpu++) all[cpu] = cpu;
+
+    // big.LITTLE: the little cluster has the lowest maximum frequency;
+    // everything clocked above it is a big (or prime) core
+    std::vector<long> maxFreq(cpus, 0);
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        char path[96];
+        std::snprintf(path, sizeof(path),
+                      "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+        if (FILE* file = std::fopen(path, "r")) {
+            if (std::fscanf(file, "%ld", &maxFreq[cpu]) != 1) maxFreq[cpu] = 0;
+            std::fclose(file);
+        }
+        if (maxFreq[cpu] <= 0) return all;  // Unknown (host, restricted sysfs)
+    }
+
+    const long littleFreq = *std::min_element(maxFreq.begin(), maxFreq.end());
+    std::vector<int> big;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        if (maxFreq[cpu] > littleFreq) big.push_back(cpu);
+    }
+    return big.empty() ? all : big;
+}
+
+WorkStealingPool::WorkStealingPool(int workerCount) {
+    const std::vector<int> big = bigCores();
+    if (workerCount <= 0) workerCount = static_cast<int>(big.size());
+    if (workerCount <= static_cast<int>(big.size()) &&
+        big.size() < std::thread::hardware_concurrency()) {
+        pinnedCores = big;  // Keep batch work off the little cores
+    }
+
+    for (int w = 0; w < workerCount; w++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int w = 0; w < workerCount; w++) {
+        threads.emplace_back(&WorkStealingPool::run, this, w);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    Worker& worker = *workers[nextWorker++ % workers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queued++;
+        pending++;
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    idle.wait(lock, [this] { return pending == 0; });
+}
+
+// Own deque first, then another worker's. Always the oldest task: callers submit
+// longest first, so each worker starts on its longest job and steals the longest
+// one left, leaving the short ones to fill in at the end.
+bool WorkStealingPool::take(int index, Task& task) {
+    const int count = static_cast<int>(workers.size());
+    for (int i = 0; i < count; i++) {
+        Worker& worker = *workers[(index + i) % count];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) continue;
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int index) {
+#if defined(__linux__)
+    if (!pinnedCores.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : pinnedCores) CPU_SET(cpu, &set);
+        sched_setaffinity(0, sizeof(set), &set);  // Best effort
+    }
+#endif
+
+    for (;;) {
+        {
+            // Claim one queued task; it is then guaranteed to be in some deque
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wake.wait(lock, [this] { return queued > 0 || stopping; });
+            if (queued == 0) return;
+            queued--;
+        }
+
+        Task task;
+        while (!take(index, task)) {
+            std::this_thread::yield();  // Claimed task is being pushed or stolen around
+        }
+        task(index);
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (--pending == 0) idle.notify_all();
+    }
+}
+
+} // namespace ultramusic
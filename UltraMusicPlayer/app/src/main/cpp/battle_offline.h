@@ -0,0 +1,228 @@
+/**
+ * BATTLE OFFLINE - Header
+ *
+ * Building blocks for rendering a whole track faster than real time
+ * (BattleAudioEngine::renderFile / battle_engine_render_file).
+ * None of this runs on the audio thread - it allocates, blocks and does file I/O.
+ *
+ * - WavReader:     Streaming WAV reader (PCM 16/24-bit, float32), rewindable so a
+ *                  stretcher can study() the file before processing it
+ * - WavWriter:     Streaming WAV writer (PCM16 with ceiling + optional dither, or
+ *                  float32); sizes are patched into the header on close()
+ * - ChunkPipeline: Fixed pool of audio chunks handed through a row of stages, one
+ *                  worker thread per stage. Each stage's DSP state lives on its
+ *                  own thread; chunks pass from stage to stage in order, so the
+ *                  stages work on consecutive chunks at the same time.
+ *                  Unthreaded, the stages simply run in turn on the caller.
+ * - WorkStealingPool: Worker threads (one per big core by default) with a task
+ *                  deque each; an idle worker steals from the others, so a
+ *                  batch of uneven jobs (short and long tracks) keeps every core busy
+ */
+
+#ifndef BATTLE_OFFLINE_H
+#define BATTLE_OFFLINE_H
+
+#include "battle_vector_ops.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ultramusic {
+
+// =============================================================================
+// WAV READER - Streaming, converts to interleaved float as it goes
+// =============================================================================
+
+class WavReader {
+public:
+    WavReader() = default;
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+    ~WavReader() { close(); }
+
+    // Parse the header and position at the first frame. False for anything
+    // that is not PCM 16/24-bit or float32 (including WAVE_FORMAT_EXTENSIBLE of those).
+    bool open(const char* path);
+    void close();
+
+    int getSampleRate() const { return sampleRate; }
+    int getChannels() const { return channels; }
+    int64_t getFrames() const { return totalFrames; }
+
+    // Read up to maxFrames interleaved frames. Returns frames read (0 at the end).
+    int read(float* output, int maxFrames);
+
+    // Back to the first frame (second pass after a study pass)
+    bool rewind();
+
+private:
+    FILE* file = nullptr;
+    int sampleRate = 0;
+    int channels = 0;
+    int bytesPerSample = 0;
+    bool floatSamples = false;
+    long dataOffset = 0;
+    int64_t totalFrames = 0;
+    int64_t framesRead = 0;
+    std::vector<uint8_t> raw;  // One read's worth of file bytes
+};
+
+// =============================================================================
+// WAV WRITER - Streaming, PCM16 or float32
+// =============================================================================
+
+class WavWriter {
+public:
+    WavWriter() = default;
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+    ~WavWriter() { close(); }
+
+    // PCM16 output is clamped to ceiling and dithered per ditherMode (NONE = rounded).
+    // Float output is clamped to ceiling when ceiling < 1, otherwise left as is.
+    bool open(const char* path, int sampleRate, int channels, bool floatSamples,
+              float ceiling, DitherMode ditherMode);
+
+    // Append interleaved frames. False once a write has failed.
+    bool write(const float* samples, int numFrames);
+
+    // Patch the RIFF/data sizes and close. False if anything failed along the way.
+    bool close();
+
+    int64_t getFramesWritten() const { return framesWritten; }
+
+private:
+    FILE* file = nullptr;
+    int channels = 0;
+    bool floatSamples = false;
+    float ceiling = 1.0f;
+    DitherMode ditherMode = DitherMode::NONE;
+    DitherState dither;
+    int64_t framesWritten = 0;
+    bool failed = false;
+    std::vector<short> pcm;      // PCM16 conversion block
+    std::vector<float> clamped;  // Float clamp block
+};
+
+// =============================================================================
+// CHUNK PIPELINE - Ordered chunk handoff between per-stage worker threads
+// =============================================================================
+
+struct AudioChunk {
+    std::vector<float> samples;  // Interleaved, chunkFrames * channels
+    int frames = 0;              // Valid frames
+};
+
+class ChunkPipeline {
+public:
+    // A stage processes one chunk in place; it may shrink chunk.frames (e.g. to trim)
+    using Stage = std::function<void(AudioChunk& chunk)>;
+
+    // depth chunks circulate in total, which bounds memory and how far the
+    // producer can run ahead of the slowest stage. threaded = false runs every
+    // stage inside submit() with a single chunk (for callers that are already
+    // one of many parallel workers).
+    ChunkPipeline(std::vector<Stage> stages, int chunkFrames, int channels,
+                  bool threaded = true, int depth = 6);
+    ChunkPipeline(const ChunkPipeline&) = delete;
+    ChunkPipeline& operator=(const ChunkPipeline&) = delete;
+    ~ChunkPipeline() { finish(); }
+
+    // Producer side: take an empty chunk (blocks until one is free) ...
+    AudioChunk* acquire();
+    // ... and hand it, filled, to the first stage
+    void submit(AudioChunk* chunk);
+
+    // Let every chunk drain through the last stage, then join the workers
+    void finish();
+
+    int getChunkFrames() const { return chunkFrames; }
+
+private:
+    // Blocking FIFO; pop() returns nullptr once closed and empty
+    class Queue {
+    public:
+        void push(AudioChunk* chunk);
+        AudioChunk* pop();
+        void close();
+
+    private:
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<AudioChunk*> chunks;
+        bool closed = false;
+    };
+
+    void runStage(size_t index);
+
+    int chunkFrames = 0;
+    bool threaded = true;
+    std::vector<Stage> stages;
+    std::vector<std::unique_ptr<AudioChunk>> pool;
+    Queue freeChunks;
+    std::vector<std::unique_ptr<Queue>> queues;  // queues[i] feeds stages[i]
+    std::vector<std::thread> workers;
+    bool finished = false;
+};
+
+// =============================================================================
+// WORK-STEALING POOL - Independent jobs spread over the big cores
+// =============================================================================
+
+class WorkStealingPool {
+public:
+    // A task gets the index of the worker running it (for per-worker state)
+    using Task = std::function<void(int worker)>;
+
+    // workers <= 0: one per big core. Workers are kept on the big cores when
+    // there are no more of them than big cores.
+    explicit WorkStealingPool(int workers = 0);
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    ~WorkStealingPool();
+
+    // Queue a task; tasks are dealt round-robin, run in submission order, and idle
+    // workers steal the rest
+    void submit(Task task);
+
+    // Block until every submitted task has run
+    void wait();
+
+    int getWorkerCount() const { return static_cast<int>(workers.size()); }
+
+    // CPUs of the fastest clusters (big + prime on big.LITTLE), read from
+    // cpufreq; every CPU when the clusters cannot be told apart
+    static std::vector<int> bigCores();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;  // Owner pops the back, thieves take the front
+    };
+
+    bool take(int worker, Task& task);
+    void run(int worker);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::vector<int> pinnedCores;  // Empty = no affinity
+
+    std::mutex stateMutex;
+    std::condition_variable wake;  // Tasks queued or stopping
+    std::condition_variable idle;  // Last pending task finished
+    int queued = 0;                // In a deque, not yet claimed by a worker
+    int pending = 0;               // Submitted, not yet finished
+    size_t nextWorker = 0;
+    bool stopping = false;
+};
+
+} // namespace ultramusic
+
+#endif // BATTLE_OFFLINE_H
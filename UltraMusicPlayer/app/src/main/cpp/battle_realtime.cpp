@@ -0,0 +1,130 @@
+/**
+ * BATTLE REALTIME Implementation
+ *
+ * Debug-build allocation trap for the audio thread.
+ * Any operator new (aligned ones included) while a RealtimeScope is active
+ * logs and aborts, so an allocation sneaking into process() shows up as a
+ * crash in testing instead of an XRUN on a low-end device. Host Debug builds
+ * on Linux also link with --wrap for malloc, calloc, realloc and
+ * posix_memalign (ULTRAMUSIC_RT_WRAP_MALLOC), which catches C allocations
+ * made by our code and the vendored stretchers. Android builds trap
+ * operator new only.
+ */
+
+#include "battle_realtime.h"
+
+#if ULTRAMUSIC_RT_ALLOC_TRAP
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <android/log.h>
+
+#define LOG_TAG "BattleRealtime"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace ultramusic {
+
+int& RealtimeScope::depth() {
+    static thread_local int scopeDepth = 0;
+    return scopeDepth;
+}
+
+} // namespace ultramusic
+
+namespace {
+
+void checkAllocation(std::size_t size) {
+    if (ultramusic::RealtimeScope::isActive()) {
+        LOGE("Heap allocation of %zu bytes on the audio thread - aborting", size);
+        std::abort();
+    }
+}
+
+void* trappedAllocate(std::size_t size) {
+    checkAllocation(size);
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* trappedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    checkAllocation(size);
+    void* ptr = nullptr;
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    if (posix_memalign(&ptr, align, size ? size : 1) != 0) return nullptr;
+    return ptr;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return trappedAllocate(size); }
+void* operator new[](std::size_t size) { return trappedAllocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    checkAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* ptr = trappedAllocateAligned(size, alignment);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return trappedAllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return trappedAllocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+#if ULTRAMUSIC_RT_WRAP_MALLOC
+// Linked with -Wl,--wrap=<name>: our calls land here, __real_<name> is libc's
+extern "C" {
+void* __real_malloc(std::size_t size);
+void* __real_calloc(std::size_t count, std::size_t size);
+void* __real_realloc(void* ptr, std::size_t size);
+int __real_posix_memalign(void** ptr, std::size_t alignment, std::size_t size);
+
+void* __wrap_malloc(std::size_t size) {
+    checkAllocation(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(std::size_t count, std::size_t size) {
+    checkAllocation(count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, std::size_t size) {
+    checkAllocation(size);
+    return __real_realloc(ptr, size);
+}
+
+int __wrap_posix_memalign(void** ptr, std::size_t alignment, std::size_t size) {
+    checkAllocation(size);
+    return __real_posix_memalign(ptr, alignment, size);
+}
+} // extern "C"
+#endif // ULTRAMUSIC_RT_WRAP_MALLOC
+
+#endif // ULTRAMUSIC_RT_ALLOC_TRAP
@@ -0,0 +1,220 @@
+/**
+ * BATTLE REALTIME - Header
+ *
+ * Support code for the audio thread. Everything here is sized once at
+ * configure time so the process() path never touches the heap.
+ *
+ * - ScratchArena:  Pre-sized, SIMD-aligned bump allocator for per-block work buffers
+ * - RealtimeScope: Marks the audio thread; debug builds abort on any allocation inside it
+ * - TripleBuffer:  Lock-free parameter snapshot handoff (UI thread -> audio thread)
+ * - AudioEpoch:    Counter the audio thread bumps around every block
+ * - Scavenger:     Deletes objects swapped out of the audio path once the audio
+ *                  thread can no longer be using them (same idea as Rubberband's Scavenger)
+ */
+
+#ifndef BATTLE_REALTIME_H
+#define BATTLE_REALTIME_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Debug builds trap heap allocations made inside a RealtimeScope.
+// CMake turns this on for Debug configurations only.
+#ifndef ULTRAMUSIC_RT_ALLOC_TRAP
+#define ULTRAMUSIC_RT_ALLOC_TRAP 0
+#endif
+
+// With the trap: also check malloc/calloc/realloc/posix_memalign through
+// -Wl,--wrap (Linux host Debug builds only; the link options come with it).
+#ifndef ULTRAMUSIC_RT_WRAP_MALLOC
+#define ULTRAMUSIC_RT_WRAP_MALLOC 0
+#endif
+
+namespace ultramusic {
+
+// =============================================================================
+// SCRATCH ARENA - One allocation at configure(), reused by every audio block
+// =============================================================================
+
+class ScratchArena {
+public:
+    // Every slice starts on a 64-byte boundary (one cache line, full NEON/AVX width)
+    static constexpr size_t kAlignFloats = 16;
+
+    // Allocate backing storage for numFloats samples. NOT real-time safe.
+    void reserve(size_t numFloats) {
+        size_t rounded = roundUp(numFloats);
+        storage.assign(rounded + kAlignFloats, 0.0f);
+
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+        uintptr_t alignBytes = kAlignFloats * sizeof(float);
+        size_t pad = ((alignBytes - (address % alignBytes)) % alignBytes) / sizeof(float);
+
+        base = storage.data() + pad;
+        capacityFloats = rounded;
+        used = 0;
+    }
+
+    // Carve out numFloats samples. Returns nullptr when the arena is exhausted.
+    float* take(size_t numFloats) {
+        size_t rounded = roundUp(numFloats);
+        if (!base || used + rounded > capacityFloats) return nullptr;
+        float* slice = base + used;
+        used += rounded;
+        return slice;
+    }
+
+    // Release all slices (storage is kept)
+    void rewind() { used = 0; }
+
+    size_t capacity() const { return capacityFloats; }
+    size_t remaining() const { return capacityFloats - used; }
+
+    // Space needed to take() a slice of numFloats samples
+    static size_t footprint(size_t numFloats) { return roundUp(numFloats); }
+
+private:
+    static size_t roundUp(size_t numFloats) {
+        return (numFloats + kAlignFloats - 1) / kAlignFloats * kAlignFloats;
+    }
+
+    std::vector<float> storage;
+    float* base = nullptr;
+    size_t capacityFloats = 0;
+    size_t used = 0;
+};
+
+// =============================================================================
+// REALTIME SCOPE - RAII marker for code running on the audio thread
+// With ULTRAMUSIC_RT_ALLOC_TRAP=1, operator new aborts while a scope is active.
+// =============================================================================
+
+class RealtimeScope {
+public:
+#if ULTRAMUSIC_RT_ALLOC_TRAP
+    RealtimeScope() { ++depth(); }
+    ~RealtimeScope() { --depth(); }
+    static bool isActive() { return depth() > 0; }
+
+private:
+    static int& depth();
+#else
+    RealtimeScope() = default;
+    static bool isActive() { return false; }
+#endif
+
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
+
+// =============================================================================
+// TRIPLE BUFFER - Wait-free latest-value handoff, one writer and one reader
+// The writer fills writeBuffer() and publishes it; the reader swaps in the
+// newest published snapshot at a block boundary. Neither side ever blocks.
+// =============================================================================
+
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side (serialise writers externally)
+    T& writeBuffer() { return slots[back]; }
+
+    void publish() {
+        back = middle.exchange(static_cast<uint8_t>(back | kDirty), std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader side (audio thread). Returns true if a newer snapshot was picked up.
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & kDirty)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    const T& read() const { return slots[front]; }
+
+private:
+    static constexpr uint8_t kDirty = 0x4;
+    static constexpr uint8_t kIndexMask = 0x3;
+
+    T slots[3] = {};
+    std::atomic<uint8_t> middle{ 1 };
+    uint8_t back = 2;   // writer only
+    uint8_t front = 0;  // reader only
+};
+
+// =============================================================================
+// AUDIO EPOCH - Odd while the audio thread is inside a block, even between blocks
+// =============================================================================
+
+class AudioEpoch {
+public:
+    void enter() { value.fetch_add(1, std::memory_order_seq_cst); }
+    void exit() { value.fetch_add(1, std::memory_order_seq_cst); }
+    uint64_t now() const { return value.load(std::memory_order_seq_cst); }
+
+private:
+    std::atomic<uint64_t> value{ 0 };
+};
+
+// =============================================================================
+// SCAVENGER - Deferred delete for objects unpublished from the audio path
+// retire() must be called AFTER the object's pointer has been swapped out.
+// It is freed once the audio thread has left the block that might have seen it.
+// NOT real-time safe: call from control threads only.
+// =============================================================================
+
+template <typename T>
+class Scavenger {
+public:
+    explicit Scavenger(const AudioEpoch& epoch) : epoch(epoch) {}
+
+    ~Scavenger() {
+        // Owner guarantees the audio thread is gone by now
+        for (const Retired& item : retired) delete item.object;
+    }
+
+    void retire(T* object) {
+        if (!object) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        retired.push_back({ object, epoch.now() });
+        collect();
+    }
+
+    // Free everything the audio thread can no longer reach
+    void scavenge() {
+        std::lock_guard<std::mutex> lock(mutex);
+        collect();
+    }
+
+private:
+    struct Retired {
+        T* object;
+        uint64_t epoch;
+    };
+
+    void collect() {
+        uint64_t current = epoch.now();
+        auto it = retired.begin();
+        while (it != retired.end()) {
+            // Retired between blocks, or the block in flight at retire time has ended
+            bool safe = (it->epoch % 2 == 0) || current > it->epoch;
+            if (safe) {
+                delete it->object;
+                it = retired.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    const AudioEpoch& epoch;
+    std::mutex mutex;
+    std::vector<Retired> retired;
+};
+
+} // namespace ultramusic
+
+#endif // BATTLE_REALTIME_H
@@ -0,0 +1,714 @@
+/**
+ * BATTLE VECTOR OPS - Header
+ *
+ * SIMD sample-format conversion used at the edges of the float pipeline.
+ * Audio stays float inside the engine; int16 is only touched here, rounded
+ * and optionally dithered on the way out.
+ * Also home to the vectorized fast math (exp2, log2, tanh) used by the chain kernels.
+ *
+ * NEON on ARM, SSE2 on x86, scalar fallback everywhere else.
+ */
+
+#ifndef BATTLE_VECTOR_OPS_H
+#define BATTLE_VECTOR_OPS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BATTLE_SIMD_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BATTLE_SIMD_SSE2 1
+#endif
+
+namespace ultramusic {
+
+// int16 full scale in and out (matches the engine's historic scaling)
+constexpr float kInt16ToFloat = 1.0f / 32768.0f;
+constexpr float kFloatToInt16 = 32767.0f;
+
+// =============================================================================
+// INT16 <-> FLOAT
+// =============================================================================
+
+inline void convertInt16ToFloat(const short* input, float* output, int numSamples) {
+    int i = 0;
+#if BATTLE_SIMD_NEON
+    const float32x4_t scale = vdupq_n_f32(kInt16ToFloat);
+    for (; i + 8 <= numSamples; i += 8) {
+        int16x8_t s = vld1q_s16(input + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        vst1q_f32(output + i, vmulq_f32(lo, scale));
+        vst1q_f32(output + i + 4, vmulq_f32(hi, scale));
+    }
+#elif BATTLE_SIMD_SSE2
+    const __m128 scale = _mm_set1_ps(kInt16ToFloat);
+    for (; i + 8 <= numSamples; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i sign = _mm_srai_epi16(s, 15);
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, sign));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, sign));
+        _mm_storeu_ps(output + i, _mm_mul_ps(lo, scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(hi, scale));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        output[i] = input[i] * kInt16ToFloat;
+    }
+}
+
+// =============================================================================
+// DITHER - Random +-1 LSB triangular noise added before the int16 rounding,
+// so low-level detail decorrelates into a noise floor instead of distortion
+// =============================================================================
+
+enum class DitherMode {
+    NONE = 0,          // Round to nearest only
+    TPDF = 1,          // Flat triangular dither: u1 - u2
+    NOISE_SHAPED = 2   // TPDF plus first-order error feedback: each channel's last
+                       // rounding error is subtracted from its next sample, so the
+                       // requantisation noise is shaped by (1 - z^-1), out of the midrange
+};
+
+// Per-output dither state: four xorshift32 streams (one per SIMD lane) and,
+// for noise shaping, each channel's last rounding error (in LSBs).
+struct DitherState {
+    // Wider layouts fall back to flat TPDF
+    static constexpr int kMaxShapedChannels = 8;
+
+    alignas(16) uint32_t rng[4] = { 0x9E3779B9u, 0x7F4A7C15u, 0x85EBCA6Bu, 0xC2B2AE35u };
+    float error[kMaxShapedChannels] = {};
+
+    void reset() { std::fill(std::begin(error), std::end(error), 0.0f); }
+};
+
+namespace detail {
+
+// numSamples (multiple of 4) uniforms in [-0.5, 0.5) LSB, four streams at a time
+inline void fillUniformNoise(DitherState& state, float* out, int numSamples) {
+    constexpr float kScale = 1.0f / 4294967296.0f;  // int32 -> [-0.5, 0.5)
+#if BATTLE_SIMD_NEON
+    uint32x4_t x = vld1q_u32(state.rng);
+    const float32x4_t scale = vdupq_n_f32(kScale);
+    for (int i = 0; i < numSamples; i += 4) {
+        x = veorq_u32(x, vshlq_n_u32(x, 13));
+        x = veorq_u32(x, vshrq_n_u32(x, 17));
+        x = veorq_u32(x, vshlq_n_u32(x, 5));
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(x)), scale));
+    }
+    vst1q_u32(state.rng, x);
+#elif BATTLE_SIMD_SSE2
+    __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(state.rng));
+    const __m128 scale = _mm_set1_ps(kScale);
+    for (int i = 0; i < numSamples; i += 4) {
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(state.rng), x);
+#else
+    for (int i = 0; i < numSamples; i += 4) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint32_t x = state.rng[lane];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            state.rng[lane] = x;
+            out[i + lane] = static_cast<float>(static_cast<int32_t>(x)) * kScale;
+        }
+    }
+#endif
+}
+
+#if BATTLE_SIMD_NEON
+inline int32x4_t roundToInt32(float32x4_t v) {
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(v);
+#else
+    // ARMv7 only truncates: add +-0.5 first (round half away from zero)
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0x80000000u));
+    const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(sign, vdupq_n_u32(0x3F000000u)));
+    return vcvtq_s32_f32(vaddq_f32(v, half));
+#endif
+}
+#endif
+
+// Scale, add dither (in LSBs), clamp to +-ceiling and round to nearest int16.
+// The SSE2 conversion rounds with the default (nearest) MXCSR mode.
+template <bool Dither>
+inline void packInt16(const float* input, const float* dither, short* output, int numSamples,
+                      float ceiling) {
+    const float limit = std::min(ceiling, 1.0f) * kFloatToInt16;
+    int i = 0;
+#if BATTLE_SIMD_NEON
+    const float32x4_t scale = vdupq_n_f32(kFloatToInt16);
+    const float32x4_t hi = vdupq_n_f32(limit);
+    const float32x4_t lo = vdupq_n_f32(-limit);
+    for (; i + 8 <= numSamples; i += 8) {
+        float32x4_t a = vmulq_f32(vld1q_f32(input + i), scale);
+        float32x4_t b = vmulq_f32(vld1q_f32(input + i + 4), scale);
+        if (Dither) {
+            a = vaddq_f32(a, vld1q_f32(dither + i));
+            b = vaddq_f32(b, vld1q_f32(dither + i + 4));
+        }
+        int32x4_t ia = roundToInt32(vminq_f32(vmaxq_f32(a, lo), hi));
+        int32x4_t ib = roundToInt32(vminq_f32(vmaxq_f32(b, lo), hi));
+        vst1q_s16(output + i, vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib)));
+    }
+#elif BATTLE_SIMD_SSE2
+    const __m128 scale = _mm_set1_ps(kFloatToInt16);
+    const __m128 hi = _mm_set1_ps(limit);
+    const __m128 lo = _mm_set1_ps(-limit);
+    for (; i + 8 <= numSamples; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(input + i), scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(input + i + 4), scale);
+        if (Dither) {
+            a = _mm_add_ps(a, _mm_loadu_ps(dither + i));
+            b = _mm_add_ps(b, _mm_loadu_ps(dither + i + 4));
+        }
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, lo), hi)),
+                                         _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, lo), hi)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+    }
+#endif
+    for (; i < numSamples; i++) {
+        float sample = input[i] * kFloatToInt16;
+        if (Dither) sample += dither[i];
+        output[i] = static_cast<short>(std::lrint(std::clamp(sample, -limit, limit)));
+    }
+}
+
+// Same as packInt16<true>, with first-order error feedback. Serial: every
+// sample needs its channel's previous error. numSamples covers whole frames.
+inline void packInt16Shaped(const float* input, const float* dither, short* output,
+                            int numSamples, int channels, float ceiling, float* error) {
+    // Dither plus rounding stays within +-1.5 LSB; only clipping goes beyond,
+    // and feeding that back would ring, so the error is capped
+    constexpr float kMaxErrorLsb = 1.5f;
+    const float limit = std::min(ceiling, 1.0f) * kFloatToInt16;
+    for (int i = 0; i < numSamples; i += channels) {
+        for (int ch = 0; ch < channels; ch++) {
+            const float wanted = input[i + ch] * kFloatToInt16 - error[ch];
+            const long rounded = std::lrint(std::clamp(wanted + dither[i + ch], -limit, limit));
+            output[i + ch] = static_cast<short>(rounded);
+            error[ch] = std::clamp(static_cast<float>(rounded) - wanted, -kMaxErrorLsb, kMaxErrorLsb);
+        }
+    }
+}
+
+} // namespace detail
+
+// Clamp to +-ceiling (hardware protection, <= 1.0), scale and round to int16.
+// The ceiling rides along with the conversion, so it costs no extra pass.
+inline void convertFloatToInt16(const float* input, short* output, int numSamples,
+                                float ceiling = 1.0f) {
+    detail::packInt16<false>(input, nullptr, output, numSamples, ceiling);
+}
+
+// Same, with dither. numSamples covers whole frames of `channels` samples;
+// the noise is generated a chunk at a time and added inside the packing loop.
+inline void convertFloatToInt16(const float* input, short* output, int numSamples, int channels,
+                                float ceiling, DitherMode mode, DitherState& state) {
+    if (mode == DitherMode::NONE) {
+        convertFloatToInt16(input, output, numSamples, ceiling);
+        return;
+    }
+    if (mode == DitherMode::NOISE_SHAPED && channels > DitherState::kMaxShapedChannels) {
+        mode = DitherMode::TPDF;
+    }
+
+    constexpr int kChunk = 256;
+    alignas(16) float noise[kChunk];
+    alignas(16) float second[kChunk];
+    const int chunk = kChunk - kChunk % channels;  // Whole frames, for the error feedback
+
+    for (int start = 0; start < numSamples; start += chunk) {
+        const int n = std::min(chunk, numSamples - start);
+        const int padded = (n + 3) & ~3;
+
+        detail::fillUniformNoise(state, noise, padded);
+        detail::fillUniformNoise(state, second, padded);
+        for (int i = 0; i < n; i++) noise[i] -= second[i];
+
+        if (mode == DitherMode::NOISE_SHAPED) {
+            detail::packInt16Shaped(input + start, noise, output + start, n, channels, ceiling,
+                                    state.error);
+        } else {
+            detail::packInt16<true>(input + start, noise, output + start, n, ceiling);
+        }
+    }
+}
+
+// Float outputs get the same ceiling as a clamp in place
+inline void clampBlock(float* samples, int numSamples, float ceiling) {
+    int i = 0;
+#if BATTLE_SIMD_NEON
+    const float32x4_t hi = vdupq_n_f32(ceiling);
+    const float32x4_t lo = vdupq_n_f32(-ceiling);
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(samples + i, vminq_f32(vmaxq_f32(vld1q_f32(samples + i), lo), hi));
+    }
+#elif BATTLE_SIMD_SSE2
+    const __m128 hi = _mm_set1_ps(ceiling);
+    const __m128 lo = _mm_set1_ps(-ceiling);
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), lo), hi));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        samples[i] = std::clamp(samples[i], -ceiling, ceiling);
+    }
+}
+
+// =============================================================================
+// MIX - Gain-scaled copy / accumulate (deck mixing)
+// =============================================================================
+
+// output = input * gain (Accumulate: output += input * gain)
+template <bool Accumulate>
+inline void mixBlock(const float* input, float* output, int numSamples, float gain) {
+    int i = 0;
+#if BATTLE_SIMD_NEON
+    const float32x4_t g = vdupq_n_f32(gain);
+    for (; i + 4 <= numSamples; i += 4) {
+        float32x4_t v = vmulq_f32(vld1q_f32(input + i), g);
+        if (Accumulate) v = vaddq_f32(v, vld1q_f32(output + i));
+        vst1q_f32(output + i, v);
+    }
+#elif BATTLE_SIMD_SSE2
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(input + i), g);
+        if (Accumulate) v = _mm_add_ps(v, _mm_loadu_ps(output + i));
+        _mm_storeu_ps(output + i, v);
+    }
+#endif
+    for (; i < numSamples; i++) {
+        output[i] = Accumulate ? output[i] + input[i] * gain : input[i] * gain;
+    }
+}
+
+// =============================================================================
+// PLANAR <-> INTERLEAVED
+// =============================================================================
+
+inline void interleave(const float* const* planes, float* output, int numFrames, int channels) {
+    if (channels == 2) {
+        const float* left = planes[0];
+        const float* right = planes[1];
+        int i = 0;
+#if BATTLE_SIMD_NEON
+        for (; i + 4 <= numFrames; i += 4) {
+            float32x4x2_t lr = { { vld1q_f32(left + i), vld1q_f32(right + i) } };
+            vst2q_f32(output + i * 2, lr);
+        }
+#elif BATTLE_SIMD_SSE2
+        for (; i + 4 <= numFrames; i += 4) {
+            __m128 l = _mm_loadu_ps(left + i);
+            __m128 r = _mm_loadu_ps(right + i);
+            _mm_storeu_ps(output + i * 2, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(output + i * 2 + 4, _mm_unpackhi_ps(l, r));
+        }
+#endif
+        for (; i < numFrames; i++) {
+            output[i * 2] = left[i];
+            output[i * 2 + 1] = right[i];
+        }
+        return;
+    }
+
+    for (int ch = 0; ch < channels; ch++) {
+        const float* plane = planes[ch];
+        for (int i = 0; i < numFrames; i++) {
+            output[i * channels + ch] = plane[i];
+        }
+    }
+}
+
+inline void deinterleave(const float* input, float* const* planes, int numFrames, int channels) {
+    if (channels == 2) {
+        float* left = planes[0];
+        float* right = planes[1];
+        int i = 0;
+#if BATTLE_SIMD_NEON
+        for (; i + 4 <= numFrames; i += 4) {
+            float32x4x2_t lr = vld2q_f32(input + i * 2);
+            vst1q_f32(left + i, lr.val[0]);
+            vst1q_f32(right + i, lr.val[1]);
+        }
+#elif BATTLE_SIMD_SSE2
+        for (; i + 4 <= numFrames; i += 4) {
+            __m128 a = _mm_loadu_ps(input + i * 2);
+            __m128 b = _mm_loadu_ps(input + i * 2 + 4);
+            _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#endif
+        for (; i < numFrames; i++) {
+            left[i] = input[i * 2];
+            right[i] = input[i * 2 + 1];
+        }
+        return;
+    }
+
+    for (int ch = 0; ch < channels; ch++) {
+        float* plane = planes[ch];
+        for (int i = 0; i < numFrames; i++) {
+            plane[i] = input[i * channels + ch];
+        }
+    }
+}
+
+// =============================================================================
+// RAMPS - Linear parameter ramps, four steps per instruction
+// =============================================================================
+
+// output[i] = start + step * (i + 1)  (the first value is one step past start)
+inline void fillRamp(float* output, float start, float step, int numSamples) {
+    int i = 0;
+#if BATTLE_SIMD_NEON
+    const float lanes[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    float32x4_t value = vmlaq_n_f32(vdupq_n_f32(start), vld1q_f32(lanes), step);
+    const float32x4_t stride = vdupq_n_f32(step * 4.0f);
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(output + i, value);
+        value = vaddq_f32(value, stride);
+    }
+#elif BATTLE_SIMD_SSE2
+    __m128 value = _mm_add_ps(_mm_set1_ps(start),
+                              _mm_mul_ps(_mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f), _mm_set1_ps(step)));
+    const __m128 stride = _mm_set1_ps(step * 4.0f);
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(output + i, value);
+        value = _mm_add_ps(value, stride);
+    }
+#endif
+    for (; i < numSamples; i++) {
+        output[i] = start + step * static_cast<float>(i + 1);
+    }
+}
+
+// =============================================================================
+// FAST TRANSCENDENTALS - exp2 / log2 / tanh for the stateless parts of the battle chain
+// exp2: round-to-nearest split, degree-6 polynomial on [-0.5, 0.5] (~1e-7 rel error)
+// log2: exponent + mantissa in [sqrt(1/2), sqrt(2)), atanh series to s^9
+//       (~1e-7 abs error; positive normal inputs only)
+// tanh: Lambert continued fraction cut at 7/6 - one division, no exp
+//       (~1e-4 abs error; exactly +-1 from |x| = 4.97 on)
+// =============================================================================
+
+namespace detail {
+
+constexpr float kExp2C1 = 0.693147181f;
+constexpr float kExp2C2 = 0.240226507f;
+constexpr float kExp2C3 = 0.0555041087f;
+constexpr float kExp2C4 = 0.00961812911f;
+constexpr float kExp2C5 = 0.00133335581f;
+constexpr float kExp2C6 = 0.000154035304f;
+constexpr float kTanhLimit = 4.97f;  // Where the 7/6 fraction reaches 1
+
+// tanh(x) ~= x * P(x^2) / Q(x^2)
+constexpr float kTanhP0 = 135135.0f;
+constexpr float kTanhP1 = 17325.0f;
+constexpr float kTanhP2 = 378.0f;
+constexpr float kTanhQ1 = 62370.0f;
+constexpr float kTanhQ2 = 3150.0f;
+constexpr float kTanhQ3 = 28.0f;
+
+// log2(m) = 2/ln(2) * atanh(s), s = (m - 1) / (m + 1): odd series coefficients
+constexpr float kLog2C1 = 2.88539008f;   // 2 / ln(2)
+constexpr float kLog2C3 = 0.961796694f;  // / 3
+constexpr float kLog2C5 = 0.577078016f;  // / 5
+constexpr float kLog2C7 = 0.412198583f;  // / 7
+constexpr float kLog2C9 = 0.320598898f;  // / 9
+constexpr float kSqrt2 = 1.41421356f;
+
+} // namespace detail
+
+inline float exp2Approx(float y) {
+    y = std::clamp(y, -126.0f, 126.0f);
+    float n = std::floor(y + 0.5f);
+    float f = y - n;
+    float p = detail::kExp2C6;
+    p = p * f + detail::kExp2C5;
+    p = p * f + detail::kExp2C4;
+    p = p * f + detail::kExp2C3;
+    p = p * f + detail::kExp2C2;
+    p = p * f + detail::kExp2C1;
+    p = p * f + 1.0f;
+    return std::ldexp(p, static_cast<int>(n));
+}
+
+inline float log2Approx(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    int e = static_cast<int>((bits >> 23) & 0xff) - 127;
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    if (m > detail::kSqrt2) {
+        m *= 0.5f;
+        e++;
+    }
+
+    float s = (m - 1.0f) / (m + 1.0f);
+    float s2 = s * s;
+    float p = detail::kLog2C9;
+    p = p * s2 + detail::kLog2C7;
+    p = p * s2 + detail::kLog2C5;
+    p = p * s2 + detail::kLog2C3;
+    p = p * s2 + detail::kLog2C1;
+    return static_cast<float>(e) + s * p;
+}
+
+inline float tanhApprox(float x) {
+    x = std::clamp(x, -detail::kTanhLimit, detail::kTanhLimit);
+    float x2 = x * x;
+    float p = ((x2 + detail::kTanhP2) * x2 + detail::kTanhP1) * x2 + detail::kTanhP0;
+    float q = ((detail::kTanhQ3 * x2 + detail::kTanhQ2) * x2 + detail::kTanhQ1) * x2 + detail::kTanhP0;
+    return std::clamp(x * p / q, -1.0f, 1.0f);
+}
+
+#if BATTLE_SIMD_NEON
+inline float32x4_t exp2Approx(float32x4_t y) {
+    y = vminq_f32(vmaxq_f32(y, vdupq_n_f32(-126.0f)), vdupq_n_f32(126.0f));
+    float32x4_t shifted = vaddq_f32(y, vdupq_n_f32(0.5f));
+    int32x4_t n = vcvtq_s32_f32(shifted);  // truncates; fix up to floor below
+    uint32x4_t over = vcgtq_f32(vcvtq_f32_s32(n), shifted);
+    n = vsubq_s32(n, vreinterpretq_s32_u32(vandq_u32(over, vdupq_n_u32(1))));
+    float32x4_t f = vsubq_f32(y, vcvtq_f32_s32(n));
+
+    float32x4_t p = vdupq_n_f32(detail::kExp2C6);
+    p = vmlaq_f32(vdupq_n_f32(detail::kExp2C5), p, f);
+    p = vmlaq_f32(vdupq_n_f32(detail::kExp2C4), p, f);
+    p = vmlaq_f32(vdupq_n_f32(detail::kExp2C3), p, f);
+    p = vmlaq_f32(vdupq_n_f32(detail::kExp2C2), p, f);
+    p = vmlaq_f32(vdupq_n_f32(detail::kExp2C1), p, f);
+    p = vmlaq_f32(vdupq_n_f32(1.0f), p, f);
+
+    int32x4_t bits = vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23);
+    return vmulq_f32(p, vreinterpretq_f32_s32(bits));
+}
+
+inline float32x4_t log2Approx(float32x4_t x) {
+    int32x4_t bits = vreinterpretq_s32_f32(x);
+    int32x4_t e = vsubq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(127));
+    float32x4_t m = vreinterpretq_f32_s32(
+            vorrq_s32(vandq_s32(bits, vdupq_n_s32(0x007fffff)), vdupq_n_s32(0x3f800000)));
+    uint32x4_t big = vcgtq_f32(m, vdupq_n_f32(detail::kSqrt2));
+    m = vbslq_f32(big, vmulq_f32(m, vdupq_n_f32(0.5f)), m);
+    e = vsubq_s32(e, vreinterpretq_s32_u32(big));  // all-ones lane == -1, so e + 1
+
+    float32x4_t den = vaddq_f32(m, vdupq_n_f32(1.0f));
+    float32x4_t inv = vrecpeq_f32(den);
+    inv = vmulq_f32(inv, vrecpsq_f32(den, inv));
+    inv = vmulq_f32(inv, vrecpsq_f32(den, inv));
+    float32x4_t s = vmulq_f32(vsubq_f32(m, vdupq_n_f32(1.0f)), inv);
+    float32x4_t s2 = vmulq_f32(s, s);
+
+    float32x4_t p = vdupq_n_f32(detail::kLog2C9);
+    p = vmlaq_f32(vdupq_n_f32(detail::kLog2C7), p, s2);
+    p = vmlaq_f32(vdupq_n_f32(detail::kLog2C5), p, s2);
+    p = vmlaq_f32(vdupq_n_f32(detail::kLog2C3), p, s2);
+    p = vmlaq_f32(vdupq_n_f32(detail::kLog2C1), p, s2);
+    return vmlaq_f32(vcvtq_f32_s32(e), s, p);
+}
+
+inline float32x4_t tanhApprox(float32x4_t x) {
+    const float32x4_t limit = vdupq_n_f32(detail::kTanhLimit);
+    x = vminq_f32(vmaxq_f32(x, vnegq_f32(limit)), limit);
+    float32x4_t x2 = vmulq_f32(x, x);
+    float32x4_t p = vaddq_f32(x2, vdupq_n_f32(detail::kTanhP2));
+    p = vmlaq_f32(vdupq_n_f32(detail::kTanhP1), p, x2);
+    p = vmlaq_f32(vdupq_n_f32(detail::kTanhP0), p, x2);
+    float32x4_t q = vmlaq_f32(vdupq_n_f32(detail::kTanhQ2), vdupq_n_f32(detail::kTanhQ3), x2);
+    q = vmlaq_f32(vdupq_n_f32(detail::kTanhQ1), q, x2);
+    q = vmlaq_f32(vdupq_n_f32(detail::kTanhP0), q, x2);
+    float32x4_t inv = vrecpeq_f32(q);
+    inv = vmulq_f32(inv, vrecpsq_f32(q, inv));
+    inv = vmulq_f32(inv, vrecpsq_f32(q, inv));
+    float32x4_t t = vmulq_f32(vmulq_f32(x, p), inv);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    return vminq_f32(vmaxq_f32(t, vnegq_f32(one)), one);
+}
+#elif BATTLE_SIMD_SSE2
+inline __m128 exp2Approx(__m128 y) {
+    y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+    __m128 shifted = _mm_add_ps(y, _mm_set1_ps(0.5f));
+    __m128i n = _mm_cvttps_epi32(shifted);  // truncates; fix up to floor below
+    __m128 over = _mm_cmpgt_ps(_mm_cvtepi32_ps(n), shifted);
+    n = _mm_sub_epi32(n, _mm_and_si128(_mm_castps_si128(over), _mm_set1_epi32(1)));
+    __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(n));
+
+    __m128 p = _mm_set1_ps(detail::kExp2C6);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(detail::kExp2C5));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(detail::kExp2C4));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(detail::kExp2C3));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(detail::kExp2C2));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(detail::kExp2C1));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+    __m128i bits = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(bits));
+}
+
+inline __m128 log2Approx(__m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                             _mm_set1_epi32(0x3f800000)));
+    __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(detail::kSqrt2));
+    m = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(big, m));
+    e = _mm_sub_epi32(e, _mm_castps_si128(big));  // all-ones lane == -1, so e + 1
+
+    __m128 s = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1.0f)), _mm_add_ps(m, _mm_set1_ps(1.0f)));
+    __m128 s2 = _mm_mul_ps(s, s);
+
+    __m128 p = _mm_set1_ps(detail::kLog2C9);
+    p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(detail::kLog2C7));
+    p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(detail::kLog2C5));
+    p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(detail::kLog2C3));
+    p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(detail::kLog2C1));
+    return _mm_add_ps(_mm_cvtepi32_ps(e), _mm_mul_ps(s, p));
+}
+
+inline __m128 tanhApprox(__m128 x) {
+    const __m128 limit = _mm_set1_ps(detail::kTanhLimit);
+    x = _mm_min_ps(_mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), limit)), limit);
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p = _mm_add_ps(x2, _mm_set1_ps(detail::kTanhP2));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(detail::kTanhP1));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(detail::kTanhP0));
+    __m128 q = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(detail::kTanhQ3), x2), _mm_set1_ps(detail::kTanhQ2));
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(detail::kTanhQ1));
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(detail::kTanhP0));
+    __m128 t = _mm_div_ps(_mm_mul_ps(x, p), q);
+    const __m128 one = _mm_set1_ps(1.0f);
+    return _mm_min_ps(_mm_max_ps(t, _mm_sub_ps(_mm_setzero_ps(), one)), one);
+}
+#endif
+
+// output[i] = tanh(input[i]); in-place is fine
+inline void tanhBlock(const float* input, float* output, int numSamples) {
+    int i = 0;
+#if BATTLE_SIMD_NEON
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f32(output + i, tanhApprox(vld1q_f32(input + i)));
+    }
+#elif BATTLE_SIMD_SSE2
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_ps(output + i, tanhApprox(_mm_loadu_ps(input + i)));
+    }
+#endif
+    for (; i < numSamples; i++) {
+        output[i] = tanhApprox(input[i]);
+    }
+}
+
+// =============================================================================
+// 4-LANE HELPERS - Thin wrappers so structure-of-arrays DSP (one lane per band
+// or per filter section) is written once for NEON, SSE2 and scalar.
+// shiftIn(v, x) = {x, v0, v1, v2} moves every lane up one to feed a pipeline;
+// lastLane(v) reads lane 3, the end of it.
+// =============================================================================
+
+namespace vec4 {
+
+#if BATTLE_SIMD_NEON
+using Lanes = float32x4_t;
+inline Lanes load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, Lanes v) { vst1q_f32(p, v); }
+inline Lanes splat(float x) { return vdupq_n_f32(x); }
+inline Lanes add(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+inline Lanes mulAdd(Lanes acc, Lanes a, Lanes b) { return vmlaq_f32(acc, a, b); }
+inline Lanes max(Lanes a, Lanes b) { return vmaxq_f32(a, b); }
+inline Lanes abs(Lanes a) { return vabsq_f32(a); }
+inline Lanes selectGreater(Lanes a, Lanes b, Lanes x, Lanes y) { return vbslq_f32(vcgtq_f32(a, b), x, y); }
+inline Lanes selectGreaterEqual(Lanes a, Lanes b, Lanes x, Lanes y) { return vbslq_f32(vcgeq_f32(a, b), x, y); }
+inline Lanes log2Lanes(Lanes a) { return log2Approx(a); }
+inline Lanes exp2Lanes(Lanes a) { return exp2Approx(a); }
+inline Lanes tanhLanes(Lanes a) { return tanhApprox(a); }
+inline Lanes shiftIn(Lanes v, float x) { return vextq_f32(vdupq_n_f32(x), v, 3); }
+inline float lastLane(Lanes v) { return vgetq_lane_f32(v, 3); }
+inline float sum(Lanes v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+}
+#elif BATTLE_SIMD_SSE2
+using Lanes = __m128;
+inline Lanes load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+inline Lanes splat(float x) { return _mm_set1_ps(x); }
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes mulAdd(Lanes acc, Lanes a, Lanes b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+inline Lanes max(Lanes a, Lanes b) { return _mm_max_ps(a, b); }
+inline Lanes abs(Lanes a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline Lanes select(Lanes mask, Lanes x, Lanes y) { return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y)); }
+inline Lanes selectGreater(Lanes a, Lanes b, Lanes x, Lanes y) { return select(_mm_cmpgt_ps(a, b), x, y); }
+inline Lanes selectGreaterEqual(Lanes a, Lanes b, Lanes x, Lanes y) { return select(_mm_cmpge_ps(a, b), x, y); }
+inline Lanes log2Lanes(Lanes a) { return log2Approx(a); }
+inline Lanes exp2Lanes(Lanes a) { return exp2Approx(a); }
+inline Lanes tanhLanes(Lanes a) { return tanhApprox(a); }
+inline Lanes shiftIn(Lanes v, float x) {
+    return _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)), _mm_set_ss(x));
+}
+inline float lastLane(Lanes v) { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+inline float sum(Lanes v) {
+    __m128 pair = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+}
+#else
+struct Lanes { float v[4]; };
+template <typename Op>
+inline Lanes map(Lanes a, Lanes b, Op op) {
+    Lanes r;
+    for (int i = 0; i < 4; i++) r.v[i] = op(a.v[i], b.v[i]);
+    return r;
+}
+inline Lanes load(const float* p) { Lanes r; std::copy(p, p + 4, r.v); return r; }
+inline void store(float* p, Lanes v) { std::copy(v.v, v.v + 4, p); }
+inline Lanes splat(float x) { return { { x, x, x, x } }; }
+inline Lanes add(Lanes a, Lanes b) { return map(a, b, [](float x, float y) { return x + y; }); }
+inline Lanes sub(Lanes a, Lanes b) { return map(a, b, [](float x, float y) { return x - y; }); }
+inline Lanes mul(Lanes a, Lanes b) { return map(a, b, [](float x, float y) { return x * y; }); }
+inline Lanes mulAdd(Lanes acc, Lanes a, Lanes b) { return add(acc, mul(a, b)); }
+inline Lanes max(Lanes a, Lanes b) { return map(a, b, [](float x, float y) { return std::max(x, y); }); }
+inline Lanes abs(Lanes a) { return map(a, a, [](float x, float) { return std::abs(x); }); }
+inline Lanes selectGreater(Lanes a, Lanes b, Lanes x, Lanes y) {
+    Lanes r;
+    for (int i = 0; i < 4; i++) r.v[i] = a.v[i] > b.v[i] ? x.v[i] : y.v[i];
+    return r;
+}
+inline Lanes selectGreaterEqual(Lanes a, Lanes b, Lanes x, Lanes y) {
+    Lanes r;
+    for (int i = 0; i < 4; i++) r.v[i] = a.v[i] >= b.v[i] ? x.v[i] : y.v[i];
+    return r;
+}
+inline Lanes log2Lanes(Lanes a) { return map(a, a, [](float x, float) { return log2Approx(x); }); }
+inline Lanes exp2Lanes(Lanes a) { return map(a, a, [](float x, float) { return exp2Approx(x); }); }
+inline Lanes tanhLanes(Lanes a) { return map(a, a, [](float x, float) { return tanhApprox(x); }); }
+inline Lanes shiftIn(Lanes v, float x) { return { { x, v.v[0], v.v[1], v.v[2] } }; }
+inline float lastLane(Lanes v) { return v.v[3]; }
+inline float sum(Lanes v) { return (v.v[0] + v.v[1]) + (v.v[2] + v.v[3]); }
+#endif
+
+} // namespace vec4
+
+} // namespace ultramusic
+
+#endif // BATTLE_VECTOR_OPS_H
@@ -0,0 +1,42 @@
+/**
+ * ANDROID LOG - Host shim
+ *
+ * Stand-in for the NDK's <android/log.h> so the engine sources build off-device
+ * (ultramusic_bench). Warnings and errors go to stderr; info/debug chatter from
+ * the setters is dropped unless ULTRAMUSIC_BENCH_VERBOSE is set, so it never
+ * lands in the middle of a timing table.
+ */
+
+#ifndef ULTRAMUSIC_BENCH_ANDROID_LOG_H
+#define ULTRAMUSIC_BENCH_ANDROID_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT
+} android_LogPriority;
+
+inline int __android_log_print(int priority, const char* tag, const char* format, ...) {
+    static const bool verbose = std::getenv("ULTRAMUSIC_BENCH_VERBOSE") != nullptr;
+    if (priority < ANDROID_LOG_WARN && !verbose) return 0;
+
+    std::fprintf(stderr, "[%s] ", tag);
+    va_list args;
+    va_start(args, format);
+    int written = std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+    return written;
+}
+
+#endif // ULTRAMUSIC_BENCH_ANDROID_LOG_H
@@ -0,0 +1,130 @@
+/**
+ * SUPERPOWERED - Host stubs
+ *
+ * The Superpowered SDK ships as prebuilt Android archives only, so the host
+ * benchmark links these stand-ins instead. They keep the engine's
+ * SUPERPOWERED path runnable end to end:
+ *
+ * - TimeStretching is a stereo FIFO (output = input, no stretching)
+ * - Compressor / Limiter / ThreeBandEQ pass audio through
+ *
+ * Numbers measured on the SUPERPOWERED engine are therefore the engine's own
+ * overhead (buffering, battle chain, conversion), not Superpowered's DSP.
+ */
+
+#include "Superpowered.h"
+#include "SuperpoweredTimeStretching.h"
+#include "SuperpoweredCompressor.h"
+#include "SuperpoweredLimiter.h"
+#include "Superpowered3BandEQ.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace Superpowered {
+
+void Initialize(const char* /* licenseKey */) {}
+
+// =============================================================================
+// TIME STRETCHING - Pass-through FIFO
+// =============================================================================
+
+struct stretchInternals {
+    std::vector<float> fifo;  // Interleaved stereo
+    size_t readPos = 0;       // Samples already handed out
+
+    size_t available() const { return fifo.size() - readPos; }
+
+    void compact() {
+        // Drop consumed audio once it is the bulk of the buffer
+        if (readPos > 0 && readPos >= fifo.size() / 2) {
+            fifo.erase(fifo.begin(), fifo.begin() + static_cast<std::ptrdiff_t>(readPos));
+            readPos = 0;
+        }
+    }
+};
+
+TimeStretching::TimeStretching(unsigned int samplerate, float /* minimumRate */)
+    : rate(1.0f), pitchShiftCents(0), samplerate(samplerate), sound(1),
+      formantCorrection(0.0f), preciseTurningOn(true), outputList(nullptr),
+      internals(new stretchInternals) {
+    // Nothing is stretched here, so a crossfade from SoundTouch at speed 10 / pitch
+    // -24 (tempo 40, seconds of latency) queues input 1:1 until both sides have output
+    internals->fifo.reserve(1 << 19);
+}
+
+TimeStretching::~TimeStretching() {
+    delete internals;
+}
+
+unsigned int TimeStretching::getNumberOfInputFramesNeeded() {
+    return 0;
+}
+
+unsigned int TimeStretching::getOutputLengthFrames() {
+    return static_cast<unsigned int>(internals->available() / 2);
+}
+
+void TimeStretching::addInput(float* input, int numberOfFrames) {
+    internals->compact();
+    internals->fifo.insert(internals->fifo.end(), input, input + numberOfFrames * 2);
+}
+
+bool TimeStretching::getOutput(float* output, int numberOfFrames) {
+    const size_t samples = static_cast<size_t>(numberOfFrames) * 2;
+    if (internals->available() < samples) return false;
+    std::memcpy(output, internals->fifo.data() + internals->readPos, samples * sizeof(float));
+    internals->readPos += samples;
+    return true;
+}
+
+void TimeStretching::reset() {
+    internals->fifo.clear();
+    internals->readPos = 0;
+}
+
+// =============================================================================
+// EFFECTS - Pass-through
+// =============================================================================
+
+namespace {
+
+bool passThrough(float* input, float* output, unsigned int numberOfFrames) {
+    if (input != output) std::memmove(output, input, numberOfFrames * 2 * sizeof(float));
+    return true;
+}
+
+} // namespace
+
+Compressor::Compressor(unsigned int samplerate) : internals(nullptr) {
+    this->samplerate = samplerate;
+}
+
+Compressor::~Compressor() {}
+
+bool Compressor::process(float* input, float* output, unsigned int numberOfFrames) {
+    return passThrough(input, output, numberOfFrames);
+}
+
+Limiter::Limiter(unsigned int samplerate) : internals(nullptr) {
+    this->samplerate = samplerate;
+}
+
+Limiter::~Limiter() {}
+
+bool Limiter::process(float* input, float* output, unsigned int numberOfFrames) {
+    return passThrough(input, output, numberOfFrames);
+}
+
+ThreeBandEQ::ThreeBandEQ(unsigned int samplerate) : internals(nullptr) {
+    this->samplerate = samplerate;
+}
+
+ThreeBandEQ::~ThreeBandEQ() {}
+
+bool ThreeBandEQ::process(float* input, float* output, unsigned int numberOfFrames) {
+    return passThrough(input, output, numberOfFrames);
+}
+
+} // namespace Superpowered
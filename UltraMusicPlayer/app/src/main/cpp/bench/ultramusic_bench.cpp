@@ -0,0 +1,770 @@
+/**
+ * ULTRAMUSIC BENCH
+ *
+ * Host benchmark for the battle audio engine. Drives the engine through its
+ * C API exactly like the JNI bridge does, over every engine x battle-chain
+ * configuration, and reports per scenario:
+ *
+ * - ns/frame:  wall time per input frame
+ * - RTF:       real-time factor (processing time / audio time, lower is better)
+ * - p50/p99/max: per-block processing time in microseconds, against the
+ *   block's real-time budget
+ *
+ * With --decks N every scenario runs N independent engines mixed by
+ * battle_engine_mix (float I/O), each deck playing the signal from a different
+ * position - the dual-deck / sampler setup.
+ *
+ * With --export every battle-chain configuration is rendered instead through
+ * the offline path (battle_engine_render_file): the signal is written to a
+ * temporary WAV and rendered file to file, reporting ns/frame and RTF of the
+ * whole render (no per-block columns - there is no callback). Adding --jobs N
+ * renders N copies at once through battle_engine_render_batch; ns/frame and
+ * RTF are then per frame of all jobs together, so scaling across cores shows
+ * up as a drop against --jobs 1.
+ *
+ * With --glide each engine instead plays a pure sine while the pitch target
+ * sweeps -12..+12 semitones (through 0) and back, moving every block. The
+ * output must stay a smooth sinusoid: the worst second difference is reported
+ * against what a clean sine at the top of the sweep can reach, and a stretcher
+ * that resets filter state when it re-tunes fails the run.
+ *
+ * With --gain-check no audio runs: the compressor gain computer
+ * (computeCompressorGains, fast log2/exp2) is swept over envelope levels from
+ * -100 to +24 dBFS for a grid of thresholds, knees and ratios, against the libm
+ * reference calculateGainReduction. The SIMD block path (NEON or SSE2, as
+ * built) and the scalar tail are measured separately; either one exceeding
+ * kMaxGainErrorDb fails the run.
+ *
+ * Signals: a synthetic battle mix (kick-like bass, chords, hats, noise) or
+ * any 16-bit / float WAV file (--wav), looped to the requested length.
+ *
+ * Superpowered is stubbed on host (see superpowered_stub.cpp), so its rows
+ * measure the engine around it, not the SDK's DSP.
+ *
+ *   ultramusic_bench [--quick] [--seconds S] [--block FRAMES] [--rate HZ]
+ *                    [--speed X] [--pitch SEMITONES] [--float] [--decks N]
+ *                    [--engine NAME] [--config NAME] [--wav FILE] [--export]
+ *                    [--jobs N] [--glide] [--gain-check]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "battle_vector_ops.h"  // BATTLE_SIMD_* - which block path the engine was built with
+
+extern "C" {
+    void* battle_engine_create();
+    void battle_engine_destroy(void* handle);
+    void battle_engine_configure(void* handle, int sampleRate, int channels);
+    void battle_engine_set_speed(void* handle, float speed);
+    void battle_engine_set_pitch(void* handle, float semitones);
+    void battle_engine_set_battle_mode(void* handle, bool enabled);
+    void battle_engine_set_bass_boost(void* handle, float amount);
+    void battle_engine_set_eq_band(void* handle, int band, float gainDb);
+    void battle_engine_set_sub_harmonic(void* handle, float amount);
+    void battle_engine_set_exciter(void* handle, float amount);
+    void battle_engine_set_mega_bass(void* handle, float intensity);
+    void battle_engine_set_parallel_compression(void* handle, float mix);
+    void battle_engine_set_limiter_enabled(void* handle, bool enabled);
+    void battle_engine_set_audiophile_mode(void* handle, bool enabled);
+    void battle_engine_set_audio_engine(void* handle, int engineType);
+    void battle_engine_process_int16(void* handle, const short* input, int numSamples,
+                                     short* output, int maxOutputSamples, int* outputSamples);
+    void battle_engine_process_float(void* handle, const float* input, int numSamples,
+                                     float* output, int maxOutputSamples, int* outputSamples);
+    int battle_engine_mix(void* const* handles, const float* const* inputs, const int* inputSamples,
+                          const float* gains, int count, float* output, int maxOutputSamples);
+    long long battle_engine_render_file(void* handle, const char* inputPath,
+                                        const char* outputPath, bool floatOutput);
+    int battle_engine_render_batch(void* const* settings, const char* const* inputPaths,
+                                   const char* const* outputPaths, const float* speeds,
+                                   const float* pitches, int count, bool floatOutput, int threads,
+                                   long long* framesWritten);
+}
+
+// Engine internals checked directly by --gain-check (battle_compressor.cpp)
+namespace ultramusic {
+    void computeCompressorGains(const float* envelope, const float* slopes, float* gains,
+                                int numFrames, float thresholdDb, float kneeDb);
+    float calculateGainReduction(float inputDb, float threshold, float ratio, float knee);
+}
+
+namespace {
+
+constexpr int kChannels = 2;
+
+// =============================================================================
+// SCENARIOS
+// =============================================================================
+
+struct EngineCase {
+    const char* name;
+    int type;  // AudioEngineType
+};
+
+const EngineCase kEngines[] = {
+    { "soundtouch", 0 },
+    { "superpowered", 1 },
+#if USE_RUBBERBAND
+    { "rubberband", 2 },
+#endif
+};
+
+struct ChainConfig {
+    const char* name;
+    bool battleMode;
+    float bassBoostDb;
+    float eqTiltDb;      // +-dB across the 10 bands (0 = flat, EQ bypassed)
+    float subHarmonic;
+    float exciter;
+    float megaBass;
+    float parallel;      // Parallel compression mix
+    bool limiter;
+    bool audiophile;
+};
+
+const ChainConfig kConfigs[] = {
+    // name         battle bass  eq    sub   exc   mega  par   lim    audiophile
+    { "clean",      false, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, true,  false },
+    { "audiophile", false, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, true,  true  },
+    { "dynamics",   true,  0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, true,  false },
+    { "bass",       true,  9.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, true,  false },
+    { "eq",         true,  0.0f, 6.0f, 0.0f, 0.0f, 0.0f, 0.0f, true,  false },
+    { "psycho",     true,  0.0f, 0.0f, 0.6f, 0.5f, 0.0f, 0.0f, true,  false },
+    { "extras",     true,  0.0f, 0.0f, 0.0f, 0.0f, 0.7f, 0.5f, true,  false },
+    { "full",       true,  9.0f, 6.0f, 0.6f, 0.5f, 0.7f, 0.5f, true,  false },
+};
+
+struct Options {
+    double seconds = 10.0;
+    int blockFrames = 256;
+    int sampleRate = 48000;
+    float speed = 1.0f;
+    float pitch = 0.0f;
+    bool floatPath = false;
+    bool quick = false;
+    bool exportMode = false;
+    bool glide = false;
+    bool gainCheck = false;
+    int jobs = 1;
+    int decks = 1;
+    std::string engine;
+    std::string config;
+    std::string wavPath;
+};
+
+// =============================================================================
+// SIGNALS
+// =============================================================================
+
+// Kick-like bass, a minor chord, off-beat hats and a little noise, around -10 dBFS
+std::vector<float> makeSyntheticMix(int sampleRate, int frames) {
+    std::vector<float> audio(static_cast<size_t>(frames) * kChannels);
+    uint32_t noise = 0x12345678u;
+    const double beat = 60.0 / 140.0;  // 140 BPM
+
+    for (int i = 0; i < frames; i++) {
+        const double t = static_cast<double>(i) / sampleRate;
+        const double inBeat = std::fmod(t, beat);
+        const double inHalf = std::fmod(t + beat / 2, beat);
+
+        const double kick = std::exp(-inBeat * 12.0) *
+                            std::sin(2.0 * M_PI * (45.0 + 80.0 * std::exp(-inBeat * 30.0)) * inBeat);
+        const double chord = (std::sin(2.0 * M_PI * 220.0 * t) +
+                              std::sin(2.0 * M_PI * 261.63 * t) +
+                              std::sin(2.0 * M_PI * 329.63 * t)) / 3.0;
+
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        const double white = static_cast<int32_t>(noise) / 2147483648.0;
+        const double hat = std::exp(-inHalf * 60.0) * white;
+
+        const double mono = 0.45 * kick + 0.15 * chord + 0.1 * hat + 0.01 * white;
+        audio[i * 2] = static_cast<float>(mono + 0.03 * chord);
+        audio[i * 2 + 1] = static_cast<float>(mono - 0.03 * chord);
+    }
+    return audio;
+}
+
+uint32_t readLE(const unsigned char* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = (value << 8) | p[i];
+    return value;
+}
+
+// PCM16 / float32 WAV -> interleaved stereo float (mono duplicated, extra channels dropped)
+bool loadWav(const std::string& path, std::vector<float>& audio, int& sampleRate) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::vector<unsigned char> bytes;
+    unsigned char chunk[1 << 16];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) bytes.insert(bytes.end(), chunk, chunk + n);
+    std::fclose(file);
+
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) || std::memcmp(bytes.data() + 8, "WAVE", 4)) {
+        return false;
+    }
+
+    int format = 0, channels = 0, bits = 0;
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const unsigned char* header = bytes.data() + pos;
+        const size_t size = readLE(header + 4, 4);
+        const unsigned char* body = header + 8;
+        if (pos + 8 + size > bytes.size()) break;
+
+        if (!std::memcmp(header, "fmt ", 4) && size >= 16) {
+            format = static_cast<int>(readLE(body, 2));
+            channels = static_cast<int>(readLE(body + 2, 2));
+            sampleRate = static_cast<int>(readLE(body + 4, 4));
+            bits = static_cast<int>(readLE(body + 14, 2));
+            if (format == 0xFFFE && size >= 26) format = static_cast<int>(readLE(body + 24, 2));
+        } else if (!std::memcmp(header, "data", 4) && channels > 0) {
+            const bool pcm16 = format == 1 && bits == 16;
+            const bool float32 = format == 3 && bits == 32;
+            if (!pcm16 && !float32) return false;
+
+            const size_t frames = size / (static_cast<size_t>(channels) * (bits / 8));
+            audio.resize(frames * kChannels);
+            for (size_t f = 0; f < frames; f++) {
+                for (int ch = 0; ch < kChannels; ch++) {
+                    const size_t index = f * channels + std::min(ch, channels - 1);
+                    float sample;
+                    if (pcm16) {
+                        sample = static_cast<int16_t>(readLE(body + index * 2, 2)) / 32768.0f;
+                    } else {
+                        std::memcpy(&sample, body + index * 4, sizeof(float));
+                    }
+                    audio[f * kChannels + ch] = sample;
+                }
+            }
+            return frames > 0;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+// Interleaved stereo float -> float32 WAV, the signal looped to `frames`
+bool writeFloatWav(const std::string& path, const std::vector<float>& signal, int sampleRate,
+                   long frames) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    auto le = [](unsigned char* p, uint32_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) p[i] = static_cast<unsigned char>(value >> (8 * i));
+    };
+    const uint32_t dataBytes = static_cast<uint32_t>(frames * kChannels * sizeof(float));
+    unsigned char header[44] = {};
+    std::memcpy(header, "RIFF", 4);
+    le(header + 4, 36 + dataBytes, 4);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    le(header + 16, 16, 4);
+    le(header + 20, 3, 2);  // IEEE float
+    le(header + 22, kChannels, 2);
+    le(header + 24, static_cast<uint32_t>(sampleRate), 4);
+    le(header + 28, static_cast<uint32_t>(sampleRate * kChannels * sizeof(float)), 4);
+    le(header + 32, kChannels * sizeof(float), 2);
+    le(header + 34, 32, 2);
+    std::memcpy(header + 36, "data", 4);
+    le(header + 40, dataBytes, 4);
+
+    bool ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    const long signalFrames = static_cast<long>(signal.size() / kChannels);
+    for (long written = 0; ok && written < frames;) {
+        const long n = std::min(signalFrames, frames - written);
+        ok = std::fwrite(signal.data(), sizeof(float), n * kChannels, file) ==
+             static_cast<size_t>(n * kChannels);
+        written += n;
+    }
+    return std::fclose(file) == 0 && ok;
+}
+
+// =============================================================================
+// RUN
+// =============================================================================
+
+struct Result {
+    double nsPerFrame = 0;
+    double rtf = 0;
+    double p50 = 0, p99 = 0, max = 0;  // microseconds
+    long framesOut = 0;
+};
+
+void applyConfig(void* engine, const ChainConfig& config) {
+    battle_engine_set_audiophile_mode(engine, config.audiophile);
+    battle_engine_set_battle_mode(engine, config.battleMode);
+    battle_engine_set_bass_boost(engine, config.bassBoostDb);
+    battle_engine_set_sub_harmonic(engine, config.subHarmonic);
+    battle_engine_set_exciter(engine, config.exciter);
+    battle_engine_set_mega_bass(engine, config.megaBass);
+    battle_engine_set_parallel_compression(engine, config.parallel);
+    battle_engine_set_limiter_enabled(engine, config.limiter);
+    for (int band = 0; band < 10; band++) {
+        // Smile curve: lows and highs up, mids down
+        const float tilt = std::fabs(band - 4.5f) / 4.5f * 2.0f - 1.0f;
+        battle_engine_set_eq_band(engine, band, config.eqTiltDb * tilt);
+    }
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+Result runScenario(const EngineCase& engineCase, const ChainConfig& config,
+                   const std::vector<float>& signal, int sampleRate, const Options& options) {
+    const int decks = options.decks;
+    std::vector<void*> engines(decks);
+    for (void*& engine : engines) {
+        engine = battle_engine_create();
+        battle_engine_configure(engine, sampleRate, kChannels);
+        battle_engine_set_audio_engine(engine, engineCase.type);
+        battle_engine_set_speed(engine, options.speed);
+        battle_engine_set_pitch(engine, options.pitch);
+        applyConfig(engine, config);
+    }
+
+    const int block = options.blockFrames;
+    const int blockSamples = block * kChannels;
+    const int signalFrames = static_cast<int>(signal.size() / kChannels);
+    const int warmupBlocks = std::max(1, static_cast<int>(0.5 * sampleRate / block));
+    const int timedBlocks = std::max(1, static_cast<int>(options.seconds * sampleRate / block));
+
+    // Output room for the slowest speed the engine accepts
+    const int maxOut = blockSamples * 32;
+    std::vector<float> inFloat(static_cast<size_t>(blockSamples) * decks);
+    std::vector<short> inShort(blockSamples);
+    std::vector<float> outFloat(maxOut);
+    std::vector<short> outShort(maxOut);
+    std::vector<double> blockUs;
+    blockUs.reserve(timedBlocks);
+
+    // Mix arguments: every deck gets one block, equal gains
+    std::vector<const float*> deckInputs(decks);
+    std::vector<int> deckSamples(decks, blockSamples);
+    std::vector<float> deckGains(decks, 1.0f / decks);
+    std::vector<int> readFrame(decks);
+    for (int d = 0; d < decks; d++) {
+        deckInputs[d] = inFloat.data() + static_cast<size_t>(d) * blockSamples;
+        readFrame[d] = static_cast<int>(static_cast<long>(signalFrames) * d / decks);
+    }
+
+    Result result;
+    double totalNs = 0;
+
+    for (int b = 0; b < warmupBlocks + timedBlocks; b++) {
+        for (int d = 0; d < decks; d++) {
+            float* deckIn = inFloat.data() + static_cast<size_t>(d) * blockSamples;
+            for (int i = 0; i < block; i++) {
+                for (int ch = 0; ch < kChannels; ch++) {
+                    const float sample = signal[static_cast<size_t>(readFrame[d]) * kChannels + ch];
+                    deckIn[i * kChannels + ch] = sample;
+                    if (d == 0) {
+                        inShort[i * kChannels + ch] =
+                            static_cast<short>(std::lrint(std::clamp(sample, -1.0f, 1.0f) * 32767.0f));
+                    }
+                }
+                readFrame[d] = (readFrame[d] + 1) % signalFrames;
+            }
+        }
+
+        int produced = 0;
+        const auto start = std::chrono::steady_clock::now();
+        if (decks > 1) {
+            produced = battle_engine_mix(engines.data(), deckInputs.data(), deckSamples.data(),
+                                         deckGains.data(), decks, outFloat.data(), maxOut);
+        } else if (options.floatPath) {
+            battle_engine_process_float(engines[0], inFloat.data(), blockSamples,
+                                        outFloat.data(), maxOut, &produced);
+        } else {
+            battle_engine_process_int16(engines[0], inShort.data(), blockSamples,
+                                        outShort.data(), maxOut, &produced);
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        if (b >= warmupBlocks) {
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            totalNs += ns;
+            blockUs.push_back(ns / 1000.0);
+            result.framesOut += produced / kChannels;
+        }
+    }
+
+    for (void* engine : engines) battle_engine_destroy(engine);
+
+    const double frames = static_cast<double>(timedBlocks) * block;
+    result.nsPerFrame = totalNs / frames;
+    result.rtf = (totalNs * 1e-9) / (frames / sampleRate);
+    result.p50 = percentile(blockUs, 0.50);
+    result.p99 = percentile(blockUs, 0.99);
+    result.max = *std::max_element(blockUs.begin(), blockUs.end());
+    return result;
+}
+
+// Offline render of inputPath with one chain configuration (file to file);
+// --jobs N renders N copies as one batch
+Result runExport(const ChainConfig& config, const std::string& inputPath,
+                 const std::string& outputBase, long inputFrames, int sampleRate,
+                 const Options& options) {
+    void* engine = battle_engine_create();
+    battle_engine_set_speed(engine, options.speed);
+    battle_engine_set_pitch(engine, options.pitch);
+    applyConfig(engine, config);
+
+    const int jobs = options.jobs;
+    std::vector<std::string> outputPaths(jobs);
+    std::vector<const char*> inputs(jobs, inputPath.c_str());
+    std::vector<const char*> outputs(jobs);
+    for (int j = 0; j < jobs; j++) {
+        outputPaths[j] = outputBase + std::to_string(j) + ".wav";
+        outputs[j] = outputPaths[j].c_str();
+    }
+    std::vector<void*> settings(jobs, engine);
+    std::vector<float> speeds(jobs, options.speed);
+    std::vector<float> pitches(jobs, options.pitch);
+    std::vector<long long> framesWritten(jobs, -1);
+
+    const auto start = std::chrono::steady_clock::now();
+    if (jobs == 1) {
+        framesWritten[0] = battle_engine_render_file(engine, inputs[0], outputs[0],
+                                                     options.floatPath);
+    } else {
+        battle_engine_render_batch(settings.data(), inputs.data(), outputs.data(), speeds.data(),
+                                   pitches.data(), jobs, options.floatPath, 0,
+                                   framesWritten.data());
+    }
+    const auto end = std::chrono::steady_clock::now();
+    battle_engine_destroy(engine);
+
+    Result result;
+    const double frames = static_cast<double>(inputFrames) * jobs;
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    result.nsPerFrame = ns / frames;
+    result.rtf = (ns * 1e-9) / (frames / sampleRate);
+    for (int j = 0; j < jobs; j++) {
+        if (framesWritten[j] <= 0) {
+            result.framesOut = 0;  // Any failed job fails the row
+            break;
+        }
+        result.framesOut += static_cast<long>(framesWritten[j]);
+    }
+    for (const std::string& path : outputPaths) std::remove(path.c_str());
+    return result;
+}
+
+// =============================================================================
+// GLIDE CHECK
+// =============================================================================
+
+struct GlideResult {
+    double worst = 0;  // Largest |x[n] - 2x[n-1] + x[n-2]| after warm-up
+    double limit = 0;
+    long framesOut = 0;
+};
+
+// A 440 Hz sine at -12 dBFS through a pitch glide that moves every block. A clean
+// sinusoid's second difference never exceeds A * (2 sin(pi f / fs))^2, so a
+// stretcher that clicks when it re-tunes (zeroed filter history, a latency jump
+// at unity) lands an order of magnitude above the limit.
+GlideResult runGlide(const EngineCase& engineCase, int sampleRate, const Options& options) {
+    constexpr double kFrequency = 440.0;
+    constexpr double kAmplitude = 0.25;
+    constexpr float kSweepSemitones = 12.0f;
+    constexpr double kHeadroom = 4.0;  // WSOLA overlaps and the sweep itself bend the sine a little
+
+    void* engine = battle_engine_create();
+    battle_engine_configure(engine, sampleRate, kChannels);
+    battle_engine_set_audio_engine(engine, engineCase.type);
+
+    const int block = options.blockFrames;
+    const int blockSamples = block * kChannels;
+    const int maxOut = blockSamples * 32;
+    const int sweepBlocks = std::max(8, static_cast<int>(sampleRate / block));  // One second up, one down
+    const long warmupFrames = sampleRate / 4;
+    std::vector<float> in(blockSamples);
+    std::vector<float> out(maxOut);
+
+    GlideResult result;
+    const double topFrequency = kFrequency * std::pow(2.0, kSweepSemitones / 12.0);
+    const double step = 2.0 * std::sin(M_PI * topFrequency / sampleRate);
+    result.limit = kHeadroom * kAmplitude * step * step;
+
+    double phase = 0;
+    const double phaseStep = 2.0 * M_PI * kFrequency / sampleRate;
+    float previous[2] = {}, beforePrevious[2] = {};
+    for (int b = 0; b < sweepBlocks * 2; b++) {
+        // Triangle: -12 -> +12 over sweepBlocks, then back down
+        const float position = b < sweepBlocks ? static_cast<float>(b) / sweepBlocks
+                                               : static_cast<float>(sweepBlocks * 2 - b) / sweepBlocks;
+        battle_engine_set_pitch(engine, -kSweepSemitones + 2.0f * kSweepSemitones * position);
+
+        for (int i = 0; i < block; i++) {
+            const float sample = static_cast<float>(kAmplitude * std::sin(phase));
+            phase += phaseStep;
+            for (int ch = 0; ch < kChannels; ch++) in[i * kChannels + ch] = sample;
+        }
+
+        int produced = 0;
+        battle_engine_process_float(engine, in.data(), blockSamples, out.data(), maxOut, &produced);
+
+        for (int i = 0; i < produced / kChannels; i++, result.framesOut++) {
+            for (int ch = 0; ch < kChannels; ch++) {
+                const float x = out[i * kChannels + ch];
+                if (result.framesOut >= warmupFrames) {
+                    result.worst = std::max(result.worst,
+                                            std::fabs(static_cast<double>(x) - 2.0 * previous[ch] + beforePrevious[ch]));
+                }
+                beforePrevious[ch] = previous[ch];
+                previous[ch] = x;
+            }
+        }
+    }
+
+    battle_engine_destroy(engine);
+    return result;
+}
+
+// =============================================================================
+// GAIN COMPUTER CHECK
+// =============================================================================
+
+constexpr double kMaxGainErrorDb = 1e-4;  // Measured ~1e-5 on SSE2 and scalar
+
+#if BATTLE_SIMD_NEON
+const char* const kBlockPath = "neon";
+#elif BATTLE_SIMD_SSE2
+const char* const kBlockPath = "sse2";
+#else
+const char* const kBlockPath = "scalar";
+#endif
+
+struct GainPathError {
+    double maxDb = 0;
+    double atLevelDb = 0;
+};
+
+// Levels -100..+24 dBFS in 0.01 dB steps through computeCompressorGains, either
+// as whole blocks (multiples of 4: SIMD body) or one frame per call (scalar tail)
+GainPathError measureGainPath(bool blockPath, float thresholdDb, float kneeDb, float ratio) {
+    constexpr int kSteps = 12400;
+    std::vector<float> envelope(kSteps), slopes(kSteps, 1.0f / ratio - 1.0f), gains(kSteps);
+    for (int i = 0; i < kSteps; i++) {
+        envelope[i] = static_cast<float>(std::pow(10.0, (-100.0 + 0.01 * i) / 20.0));
+    }
+
+    if (blockPath) {
+        ultramusic::computeCompressorGains(envelope.data(), slopes.data(), gains.data(), kSteps,
+                                           thresholdDb, kneeDb);
+    } else {
+        for (int i = 0; i < kSteps; i++) {
+            ultramusic::computeCompressorGains(&envelope[i], &slopes[i], &gains[i], 1,
+                                               thresholdDb, kneeDb);
+        }
+    }
+
+    GainPathError error;
+    for (int i = 0; i < kSteps; i++) {
+        const double levelDb = 20.0 * std::log10(envelope[i]);
+        const double expectedDb = ultramusic::calculateGainReduction(
+            static_cast<float>(levelDb), thresholdDb, ratio, kneeDb);
+        const double actualDb = 20.0 * std::log10(gains[i]);
+        const double diff = std::fabs(actualDb - expectedDb);
+        if (diff > error.maxDb) {
+            error.maxDb = diff;
+            error.atLevelDb = levelDb;
+        }
+    }
+    return error;
+}
+
+int runGainCheck() {
+    const float thresholds[] = { -36.0f, -12.0f, 0.0f };
+    const float knees[] = { 0.0f, 6.0f, 12.0f };
+    const float ratios[] = { 1.5f, 4.0f, 20.0f };
+
+    std::printf("ultramusic_bench: compressor gain computer vs libm, -100..+24 dBFS, "
+                "limit %g dB\n", kMaxGainErrorDb);
+    std::printf("%-7s %12s %12s\n", "path", "max err dB", "at dBFS");
+
+    int failures = 0;
+    for (const bool blockPath : { true, false }) {
+        GainPathError worst;
+        for (float threshold : thresholds) {
+            for (float knee : knees) {
+                for (float ratio : ratios) {
+                    const GainPathError e = measureGainPath(blockPath, threshold, knee, ratio);
+                    if (e.maxDb > worst.maxDb) worst = e;
+                }
+            }
+        }
+        const bool ok = worst.maxDb <= kMaxGainErrorDb;
+        std::printf("%-7s %12.6f %12.2f%s\n", blockPath ? kBlockPath : "scalar", worst.maxDb,
+                    worst.atLevelDb, ok ? "" : "  (too far from libm!)");
+        if (!ok) failures++;
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--gain-check") {
+            options.gainCheck = true;
+        } else if (arg == "--glide") {
+            options.glide = true;
+        } else if (arg == "--export") {
+            options.exportMode = true;
+        } else if (arg == "--jobs" && hasValue) {
+            options.jobs = std::clamp(std::atoi(argv[++i]), 1, 64);
+        } else if (arg == "--float") {
+            options.floatPath = true;
+        } else if (arg == "--decks" && hasValue) {
+            options.decks = std::clamp(std::atoi(argv[++i]), 1, 8);
+        } else if (arg == "--seconds" && hasValue) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (arg == "--block" && hasValue) {
+            options.blockFrames = std::max(16, std::atoi(argv[++i]));
+        } else if (arg == "--rate" && hasValue) {
+            options.sampleRate = std::max(8000, std::atoi(argv[++i]));
+        } else if (arg == "--speed" && hasValue) {
+            options.speed = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--pitch" && hasValue) {
+            options.pitch = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--engine" && hasValue) {
+            options.engine = argv[++i];
+        } else if (arg == "--config" && hasValue) {
+            options.config = argv[++i];
+        } else if (arg == "--wav" && hasValue) {
+            options.wavPath = argv[++i];
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--quick] [--seconds S] [--block FRAMES] [--rate HZ]\n"
+                         "       [--speed X] [--pitch SEMITONES] [--float] [--decks N]\n"
+                         "       [--engine NAME] [--config NAME] [--wav FILE] [--export]\n"
+                         "       [--jobs N] [--glide] [--gain-check]\n", argv[0]);
+            return false;
+        }
+    }
+    if (options.quick) options.seconds = std::min(options.seconds, 0.25);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 2;
+
+    int sampleRate = options.sampleRate;
+    std::vector<float> signal;
+    std::string signalName = "synth";
+    if (!options.wavPath.empty()) {
+        if (!loadWav(options.wavPath, signal, sampleRate)) {
+            std::fprintf(stderr, "cannot read %s (PCM16 or float32 WAV expected)\n", options.wavPath.c_str());
+            return 2;
+        }
+        signalName = "wav";
+    } else {
+        signal = makeSyntheticMix(sampleRate, sampleRate * 4);
+    }
+
+    if (options.gainCheck) return runGainCheck();
+
+    if (options.glide) {
+        std::printf("ultramusic_bench: pitch glide +-12 st over a 440 Hz sine, %d Hz, block %d frames\n",
+                    sampleRate, options.blockFrames);
+        std::printf("%-13s %12s %12s %12s\n", "engine", "worst d2", "limit", "frames out");
+
+        int failures = 0;
+        for (const EngineCase& engineCase : kEngines) {
+            if (!options.engine.empty() && options.engine != engineCase.name) continue;
+
+            const GlideResult r = runGlide(engineCase, sampleRate, options);
+            const bool ok = r.framesOut > 0 && r.worst <= r.limit;
+            std::printf("%-13s %12.5f %12.5f %12ld%s\n", engineCase.name, r.worst, r.limit,
+                        r.framesOut, ok ? "" : "  (discontinuity!)");
+            if (!ok) failures++;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    if (options.exportMode) {
+        // Offline stretcher: Rubberband when built in, SoundTouch otherwise
+#if USE_RUBBERBAND
+        const char* stretcher = "rubberband-offline";
+#else
+        const char* stretcher = "soundtouch";
+#endif
+        const char* tempDir = std::getenv("TMPDIR");
+        const std::string base = std::string(tempDir ? tempDir : "/tmp") + "/ultramusic_bench_";
+        const std::string inputPath = base + "in.wav";
+        const std::string outputBase = base + "out";
+        const long inputFrames = std::max(1L, static_cast<long>(options.seconds * sampleRate));
+        if (!writeFloatWav(inputPath, signal, sampleRate, inputFrames)) {
+            std::fprintf(stderr, "cannot write %s\n", inputPath.c_str());
+            return 2;
+        }
+
+        std::printf("ultramusic_bench: offline export, %s signal, %d Hz, %.2f s file, "
+                    "speed %.2f, pitch %+.1f st, %s output, %d job%s\n",
+                    signalName.c_str(), sampleRate, options.seconds, options.speed,
+                    options.pitch, options.floatPath ? "float" : "int16", options.jobs,
+                    options.jobs > 1 ? "s batched" : "");
+        std::printf("%-19s %-11s %10s %9s %12s\n", "stretcher", "config", "ns/frame", "RTF",
+                    "frames out");
+
+        int failures = 0;
+        for (const ChainConfig& config : kConfigs) {
+            if (!options.config.empty() && options.config != config.name) continue;
+
+            const Result r = runExport(config, inputPath, outputBase, inputFrames, sampleRate,
+                                       options);
+            std::printf("%-19s %-11s %10.1f %9.4f %12ld%s\n", stretcher, config.name,
+                        r.nsPerFrame, r.rtf, r.framesOut, r.framesOut > 0 ? "" : "  (no output!)");
+            if (r.framesOut <= 0) failures++;
+        }
+        std::remove(inputPath.c_str());
+        return failures == 0 ? 0 : 1;
+    }
+
+    const double budgetUs = 1e6 * options.blockFrames / sampleRate;
+    std::printf("ultramusic_bench: %s signal, %d Hz, block %d frames (budget %.0f us), "
+                "%.2f s per run, speed %.2f, pitch %+.1f st, %s I/O",
+                signalName.c_str(), sampleRate, options.blockFrames, budgetUs, options.seconds,
+                options.speed, options.pitch,
+                options.floatPath || options.decks > 1 ? "float" : "int16");
+    if (options.decks > 1) std::printf(", %d decks mixed", options.decks);
+    std::printf("\n");
+    std::printf("%-13s %-11s %10s %9s %9s %9s %9s\n",
+                "engine", "config", "ns/frame", "RTF", "p50 us", "p99 us", "max us");
+
+    int failures = 0;
+    for (const EngineCase& engineCase : kEngines) {
+        if (!options.engine.empty() && options.engine != engineCase.name) continue;
+        for (const ChainConfig& config : kConfigs) {
+            if (!options.config.empty() && options.config != config.name) continue;
+
+            const Result r = runScenario(engineCase, config, signal, sampleRate, options);
+            std::printf("%-13s %-11s %10.1f %9.4f %9.1f %9.1f %9.1f%s\n",
+                        engineCase.name, config.name, r.nsPerFrame, r.rtf, r.p50, r.p99, r.max,
+                        r.framesOut > 0 ? "" : "  (no output!)");
+            if (r.framesOut <= 0) failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -10,6 +10,10 @@
 #include "battle_audio_engine.h"
 #include "SoundTouch.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #define LOG_TAG "JNI_Bridge"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
@@ -25,15 +29,37 @@ extern "C" {
     void battle_engine_set_rate(void* handle, float rate);
     void battle_engine_set_battle_mode(void* handle, bool enabled);
     void battle_engine_set_bass_boost(void* handle, float amount);
+    void battle_engine_set_eq_enabled(void* handle, bool enabled);
+    void battle_engine_set_eq_band(void* handle, int band, float gainDb);
     void battle_engine_set_sub_harmonic(void* handle, float amount);
     void battle_engine_set_exciter(void* handle, float amount);
+    void battle_engine_set_mega_bass(void* handle, float intensity);
+    void battle_engine_set_parallel_compression(void* handle, float mix);
     void battle_engine_set_limiter_enabled(void* handle, bool enabled);
     void battle_engine_set_hardware_protection(void* handle, bool enabled);
     void battle_engine_set_audiophile_mode(void* handle, bool enabled);
+    void battle_engine_set_dither_mode(void* handle, int mode);
     void battle_engine_set_audio_engine(void* handle, int engineType);
     int battle_engine_get_audio_engine(void* handle);
-    void battle_engine_process(void* handle, const short* input, int numSamples,
-                               short* output, int* outputSamples);
+    void battle_engine_set_engine_crossfade(void* handle, float milliseconds);
+    int battle_engine_read_true_peaks(void* handle, float* peaksDb, int maxChannels);
+    int battle_engine_get_latency_frames(void* handle);
+    void battle_engine_set_latency_compensation(void* handle, bool enabled);
+    void battle_engine_process_int16(void* handle, const short* input, int numSamples,
+                                     short* output, int maxOutputSamples, int* outputSamples);
+    void battle_engine_process_float(void* handle, const float* input, int numSamples,
+                                     float* output, int maxOutputSamples, int* outputSamples);
+    int battle_engine_mix(void* const* handles, const float* const* inputs, const int* inputSamples,
+                          const float* gains, int count, float* output, int maxOutputSamples);
+    long long battle_engine_render_file(void* handle, const char* inputPath,
+                                        const char* outputPath, bool floatOutput);
+    int battle_engine_render_batch(void* const* settings, const char* const* inputPaths,
+                                   const char* const* outputPaths, const float* speeds,
+                                   const float* pitches, int count, bool floatOutput, int threads,
+                                   long long* framesWritten);
+    bool battle_engine_set_direct_buffers(void* handle, void* input, size_t inputBytes,
+                                          void* output, size_t outputBytes, bool floatSamples);
+    int battle_engine_process_direct(void* handle, int numSamples);
     void battle_engine_flush(void* handle);
     void battle_engine_clear(void* handle);
 }
@@ -99,6 +125,18 @@ Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetBassBoost(
     battle_engine_set_bass_boost(reinterpret_cast<void*>(handle), amount);
 }
 
+JNIEXPORT void JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetEqEnabled(
+        JNIEnv* env, jobject thiz, jlong handle, jboolean enabled) {
+    battle_engine_set_eq_enabled(reinterpret_cast<void*>(handle), enabled);
+}
+
+JNIEXPORT void JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetEqBand(
+        JNIEnv* env, jobject thiz, jlong handle, jint band, jfloat gainDb) {
+    battle_engine_set_eq_band(reinterpret_cast<void*>(handle), band, gainDb);
+}
+
 JNIEXPORT void JNICALL
 Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetSubHarmonic(
         JNIEnv* env, jobject thiz, jlong handle, jfloat amount) {
@@ -111,6 +149,18 @@ Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetExciter(
     battle_engine_set_exciter(reinterpret_cast<void*>(handle), amount);
 }
 
+JNIEXPORT void JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetMegaBass(
+        JNIEnv* env, jobject thiz, jlong handle, jfloat intensity) {
+    battle_engine_set_mega_bass(reinterpret_cast<void*>(handle), intensity);
+}
+
+JNIEXPORT void JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetParallelCompression(
+        JNIEnv* env, jobject thiz, jlong handle, jfloat mix) {
+    battle_engine_set_parallel_compression(reinterpret_cast<void*>(handle), mix);
+}
+
 JNIEXPORT void JNICALL
 Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetLimiterEnabled(
         JNIEnv* env, jobject thiz, jlong handle, jboolean enabled) {
@@ -136,6 +186,12 @@ Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetAudiophileMode(
     LOGI("Audiophile Mode: %s", enabled ? "ON (pure quality)" : "OFF (battle ready)");
 }
 
+JNIEXPORT void JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetDitherMode(
+        JNIEnv* env, jobject thiz, jlong handle, jint mode) {
+    battle_engine_set_dither_mode(reinterpret_cast<void*>(handle), mode);
+}
+
 JNIEXPORT void JNICALL
 Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetAudioEngine(
         JNIEnv* env, jobject thiz, jlong handle, jint engineType) {
@@ -151,6 +207,38 @@ Java_com_ultramusic_player_audio_NativeBattleEngine_nativeGetAudioEngine(
     return battle_engine_get_audio_engine(reinterpret_cast<void*>(handle));
 }
 
+JNIEXPORT void JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetEngineCrossfade(
+        JNIEnv* env, jobject thiz, jlong handle, jfloat milliseconds) {
+    battle_engine_set_engine_crossfade(reinterpret_cast<void*>(handle), milliseconds);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeReadTruePeaks(
+        JNIEnv* env, jobject thiz, jlong handle, jfloatArray peaksArray) {
+    
+    // Tiny array: region copy instead of pinning
+    jsize capacity = std::min<jsize>(env->GetArrayLength(peaksArray), 8);
+    jfloat peaks[8];
+    int channels = battle_engine_read_true_peaks(reinterpret_cast<void*>(handle), peaks, capacity);
+    if (channels > 0) {
+        env->SetFloatArrayRegion(peaksArray, 0, channels, peaks);
+    }
+    return channels;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeGetLatencyFrames(
+        JNIEnv* env, jobject thiz, jlong handle) {
+    return battle_engine_get_latency_frames(reinterpret_cast<void*>(handle));
+}
+
+JNIEXPORT void JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetLatencyCompensation(
+        JNIEnv* env, jobject thiz, jlong handle, jboolean enabled) {
+    battle_engine_set_latency_compensation(reinterpret_cast<void*>(handle), enabled);
+}
+
 JNIEXPORT jint JNICALL
 Java_com_ultramusic_player_audio_NativeBattleEngine_nativeProcess(
         JNIEnv* env, jobject thiz, jlong handle, 
@@ -171,10 +259,11 @@ Java_com_ultramusic_player_audio_NativeBattleEngine_nativeProcess(
         return 0;
     }
     
-    // Process
+    // Process (bounded by the Java array - slow speeds produce more than they take)
     int outputSamples = 0;
-    battle_engine_process(reinterpret_cast<void*>(handle), 
-                          input, numSamples, output, &outputSamples);
+    jsize maxOutputSamples = env->GetArrayLength(outputArray);
+    battle_engine_process_int16(reinterpret_cast<void*>(handle),
+                                input, numSamples, output, maxOutputSamples, &outputSamples);
     
     // Release arrays
     env->ReleaseShortArrayElements(inputArray, input, 0);
@@ -183,6 +272,203 @@ Java_com_ultramusic_player_audio_NativeBattleEngine_nativeProcess(
     return outputSamples;
 }
 
+JNIEXPORT jint JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeProcessFloat(
+        JNIEnv* env, jobject thiz, jlong handle,
+        jfloatArray inputArray, jint numSamples, jfloatArray outputArray) {
+
+    // Get input samples (float, -1..1)
+    jfloat* input = env->GetFloatArrayElements(inputArray, nullptr);
+    if (!input) {
+        LOGE("Failed to get float input array");
+        return 0;
+    }
+
+    // Prepare output buffer
+    jfloat* output = env->GetFloatArrayElements(outputArray, nullptr);
+    if (!output) {
+        env->ReleaseFloatArrayElements(inputArray, input, JNI_ABORT);
+        LOGE("Failed to get float output array");
+        return 0;
+    }
+
+    // Process (float end-to-end, no int16 conversion)
+    int outputSamples = 0;
+    jsize maxOutputSamples = env->GetArrayLength(outputArray);
+    battle_engine_process_float(reinterpret_cast<void*>(handle),
+                                input, numSamples, output, maxOutputSamples, &outputSamples);
+
+    // Release arrays (input was only read - skip the copy back)
+    env->ReleaseFloatArrayElements(inputArray, input, JNI_ABORT);
+    env->ReleaseFloatArrayElements(outputArray, output, 0);
+
+    return outputSamples;
+}
+
+// Dual-deck / sampler mixing: every deck processed and summed in one JNI call.
+// Decks beyond kMaxMixDecks are ignored.
+constexpr int kMaxMixDecks = 8;
+
+JNIEXPORT jint JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeMix(
+        JNIEnv* env, jclass clazz, jlongArray handleArray, jobjectArray inputArrays,
+        jintArray inputSamplesArray, jfloatArray gainArray, jfloatArray outputArray) {
+
+    int count = std::min<int>(env->GetArrayLength(handleArray), kMaxMixDecks);
+    count = std::min<int>(count, env->GetArrayLength(inputArrays));
+    count = std::min<int>(count, env->GetArrayLength(inputSamplesArray));
+    count = std::min<int>(count, env->GetArrayLength(gainArray));
+    if (count <= 0) return 0;
+
+    jlong handles[kMaxMixDecks];
+    jint inputSamples[kMaxMixDecks];
+    jfloat gains[kMaxMixDecks];
+    env->GetLongArrayRegion(handleArray, 0, count, handles);
+    env->GetIntArrayRegion(inputSamplesArray, 0, count, inputSamples);
+    env->GetFloatArrayRegion(gainArray, 0, count, gains);
+
+    void* decks[kMaxMixDecks];
+    jfloatArray arrays[kMaxMixDecks];
+    const float* inputs[kMaxMixDecks];
+    int samples[kMaxMixDecks];
+    for (int d = 0; d < count; d++) {
+        decks[d] = reinterpret_cast<void*>(handles[d]);
+        arrays[d] = static_cast<jfloatArray>(env->GetObjectArrayElement(inputArrays, d));
+        inputs[d] = arrays[d] ? env->GetFloatArrayElements(arrays[d], nullptr) : nullptr;
+        samples[d] = inputs[d] ? std::min<int>(inputSamples[d], env->GetArrayLength(arrays[d])) : 0;
+    }
+
+    int outputSamples = 0;
+    jfloat* output = env->GetFloatArrayElements(outputArray, nullptr);
+    if (output) {
+        outputSamples = battle_engine_mix(decks, inputs, samples, gains, count,
+                                          output, env->GetArrayLength(outputArray));
+        env->ReleaseFloatArrayElements(outputArray, output, 0);
+    } else {
+        LOGE("Failed to get mix output array");
+    }
+
+    // Inputs were only read - skip the copy back
+    for (int d = 0; d < count; d++) {
+        if (inputs[d]) {
+            env->ReleaseFloatArrayElements(arrays[d], const_cast<jfloat*>(inputs[d]), JNI_ABORT);
+        }
+        if (arrays[d]) env->DeleteLocalRef(arrays[d]);
+    }
+
+    return outputSamples;
+}
+
+// Offline export. Blocks until the whole file is rendered - Kotlin calls it
+// from a background dispatcher, never the main or audio thread.
+JNIEXPORT jlong JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeRenderFile(
+        JNIEnv* env, jobject thiz, jlong handle, jstring inputPath, jstring outputPath,
+        jboolean floatOutput) {
+
+    const char* input = inputPath ? env->GetStringUTFChars(inputPath, nullptr) : nullptr;
+    const char* output = outputPath ? env->GetStringUTFChars(outputPath, nullptr) : nullptr;
+
+    jlong framesWritten = -1;
+    if (input && output) {
+        framesWritten = battle_engine_render_file(reinterpret_cast<void*>(handle), input, output,
+                                                  floatOutput == JNI_TRUE);
+    } else {
+        LOGE("Failed to get render file paths");
+    }
+
+    if (input) env->ReleaseStringUTFChars(inputPath, input);
+    if (output) env->ReleaseStringUTFChars(outputPath, output);
+    return framesWritten;
+}
+
+// Batch export: String[] paths are copied up front so the render itself makes
+// no JNI calls. Blocks until every job has finished.
+JNIEXPORT jint JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeRenderBatch(
+        JNIEnv* env, jclass clazz, jlongArray settingsArray, jobjectArray inputArray,
+        jobjectArray outputArray, jfloatArray speedArray, jfloatArray pitchArray,
+        jboolean floatOutput, jint threads, jlongArray framesArray) {
+
+    int count = env->GetArrayLength(settingsArray);
+    count = std::min<int>(count, env->GetArrayLength(inputArray));
+    count = std::min<int>(count, env->GetArrayLength(outputArray));
+    count = std::min<int>(count, env->GetArrayLength(speedArray));
+    count = std::min<int>(count, env->GetArrayLength(pitchArray));
+    count = std::min<int>(count, env->GetArrayLength(framesArray));
+    if (count <= 0) return 0;
+
+    std::vector<jlong> handles(count);
+    std::vector<jfloat> speeds(count);
+    std::vector<jfloat> pitches(count);
+    env->GetLongArrayRegion(settingsArray, 0, count, handles.data());
+    env->GetFloatArrayRegion(speedArray, 0, count, speeds.data());
+    env->GetFloatArrayRegion(pitchArray, 0, count, pitches.data());
+
+    // Paths are copied out so a long playlist never holds hundreds of local refs
+    std::vector<void*> settings(count);
+    std::vector<std::string> paths(count * 2);  // inputs, then outputs
+    std::vector<const char*> pathPtrs(count * 2, nullptr);
+    auto copyPath = [env](jobjectArray array, int i, std::string& path) {
+        auto string = static_cast<jstring>(env->GetObjectArrayElement(array, i));
+        if (!string) return false;
+        const char* chars = env->GetStringUTFChars(string, nullptr);
+        if (chars) {
+            path = chars;
+            env->ReleaseStringUTFChars(string, chars);
+        }
+        env->DeleteLocalRef(string);
+        return chars != nullptr;
+    };
+    for (int i = 0; i < count; i++) {
+        settings[i] = reinterpret_cast<void*>(handles[i]);
+        if (copyPath(inputArray, i, paths[i])) pathPtrs[i] = paths[i].c_str();
+        if (copyPath(outputArray, i, paths[count + i])) pathPtrs[count + i] = paths[count + i].c_str();
+    }
+
+    std::vector<long long> frames(count, -1);
+    int succeeded = battle_engine_render_batch(settings.data(), pathPtrs.data(),
+                                               pathPtrs.data() + count, speeds.data(),
+                                               pitches.data(), count, floatOutput == JNI_TRUE,
+                                               threads, frames.data());
+
+    std::vector<jlong> framesOut(frames.begin(), frames.end());
+    env->SetLongArrayRegion(framesArray, 0, count, framesOut.data());
+    return succeeded;
+}
+
+// Zero-copy path: the direct ByteBuffers are resolved once here, then every
+// nativeProcessDirect call works on their memory with no array pinning or copies.
+// Kotlin keeps strong references to both buffers while they are registered.
+JNIEXPORT jboolean JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeSetDirectBuffers(
+        JNIEnv* env, jobject thiz, jlong handle,
+        jobject inputBuffer, jobject outputBuffer, jboolean floatSamples) {
+
+    void* input = inputBuffer ? env->GetDirectBufferAddress(inputBuffer) : nullptr;
+    void* output = outputBuffer ? env->GetDirectBufferAddress(outputBuffer) : nullptr;
+    if (!input || !output) {
+        LOGE("Direct buffers required (ByteBuffer.allocateDirect)");
+        battle_engine_set_direct_buffers(reinterpret_cast<void*>(handle),
+                                         nullptr, 0, nullptr, 0, false);
+        return JNI_FALSE;
+    }
+
+    jlong inputBytes = env->GetDirectBufferCapacity(inputBuffer);
+    jlong outputBytes = env->GetDirectBufferCapacity(outputBuffer);
+
+    return battle_engine_set_direct_buffers(reinterpret_cast<void*>(handle),
+                                            input, static_cast<size_t>(inputBytes),
+                                            output, static_cast<size_t>(outputBytes),
+                                            floatSamples) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_ultramusic_player_audio_NativeBattleEngine_nativeProcessDirect(
+        JNIEnv* env, jobject thiz, jlong handle, jint numSamples) {
+    return battle_engine_process_direct(reinterpret_cast<void*>(handle), numSamples);
+}
+
 JNIEXPORT void JNICALL
 Java_com_ultramusic_player_audio_NativeBattleEngine_nativeFlush(
         JNIEnv* env, jobject thiz, jlong handle) {
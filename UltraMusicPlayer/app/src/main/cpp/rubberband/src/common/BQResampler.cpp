@@ -71,7 +71,11 @@ BQResampler::BQResampler(Parameters parameters, int channels) :
         m_prototype.push_back(0.0); // interpolate without fear
     }
 
-    int phase_reserve = 2 * int(round(m_initial_rate));
+    // A ratio's phase table has one entry per numerator step, and
+    // pick_params() allows numerators up to rational_max: reserve that
+    // much so no ratio change reallocates in realtime use
+    int phase_reserve = max(2 * int(round(m_initial_rate)),
+                            m_qparams.rational_max);
     int buffer_reserve = 1000 * m_channels;
     m_state_a.phase_info.reserve(phase_reserve);
     m_state_a.buffer.reserve(buffer_reserve);
@@ -556,7 +560,7 @@ BQResampler::state_for_ratio(BQResampler::state &target_state,
             target_state.buffer = prev_state.buffer;
             target_state.fill = prev_state.fill;
         } else {
-            target_state.buffer = floatbuf(buffer_length, 0.0);
+            target_state.buffer.assign(buffer_length, 0.0f); // reuses the reserve
             for (int i = 0; i < prev_state.fill; ++i) {
                 int offset = i - prev_state.centre;
                 int new_ix = offset + target_state.centre;
@@ -575,7 +579,7 @@ BQResampler::state_for_ratio(BQResampler::state &target_state,
             target_state.current_phase = n_phases - 1;
         }
     } else {
-        target_state.buffer = floatbuf(buffer_length, 0.0);
+        target_state.buffer.assign(buffer_length, 0.0f); // reuses the reserve
     }
 }
 
@@ -35,7 +35,8 @@ namespace RubberBand
 PercussiveAudioCurve::PercussiveAudioCurve(Parameters parameters) :
     AudioCurveCalculator(parameters)
 {
-    m_prevMag = allocate_and_zero<double>(m_fftSize/2 + 1);
+    m_prevMagCapacity = m_fftSize/2 + 1;
+    m_prevMag = allocate_and_zero<double>(m_prevMagCapacity);
 }
 
 PercussiveAudioCurve::~PercussiveAudioCurve()
@@ -52,7 +53,12 @@ PercussiveAudioCurve::reset()
 void
 PercussiveAudioCurve::setFftSize(int newSize)
 {
-    m_prevMag = reallocate(m_prevMag, m_fftSize/2 + 1, newSize/2 + 1);
+    // Keep the larger buffer when shrinking, so switching back and forth
+    // between FFT sizes in realtime mode does not reallocate
+    if (newSize/2 + 1 > m_prevMagCapacity) {
+        m_prevMag = reallocate(m_prevMag, m_prevMagCapacity, newSize/2 + 1);
+        m_prevMagCapacity = newSize/2 + 1;
+    }
     AudioCurveCalculator::setFftSize(newSize);
     reset();
 }
@@ -47,6 +47,7 @@ public:
 
 protected:
     double *R__ m_prevMag;
+    int m_prevMagCapacity; // bins allocated; only ever grows
 };
 
 }
@@ -1,13 +1,25 @@
 /**
- * SoundTouch Library - Stub Implementation
- * 
- * This is a MINIMAL implementation for building without the full SoundTouch library.
- * It provides basic functionality using a simplified WSOLA algorithm.
- * 
- * For FULL quality, download the real SoundTouch source:
- * https://codeberg.org/soundtouch/soundtouch
- * 
- * Run: ./setup_soundtouch.sh to download automatically
+ * SoundTouch Library - UltraMusic WSOLA Implementation
+ *
+ * Self-contained replacement for the SoundTouch library, API compatible with
+ * the subset declared in SoundTouch.h.
+ *
+ * Processing chain (float samples, interleaved):
+ *   input -> WSOLA tempo stretch -> rate transposer (+ anti-alias FIR) -> output
+ *
+ * - WSOLA: waveform-similarity overlap-add. Each sequence of
+ *   SETTING_SEQUENCE_MS is placed at the offset (within SETTING_SEEKWINDOW_MS)
+ *   whose normalized cross-correlation with the previous sequence's tail is
+ *   highest, then cross-faded over SETTING_OVERLAP_MS.
+ * - Rate transposer: linear interpolation, windowed-sinc anti-alias filter of
+ *   SETTING_AA_FILTER_LENGTH taps when SETTING_USE_AA_FILTER is on.
+ *
+ * Everything is processed incrementally: unconsumed input stays queued for
+ * the next putSamples() call. Stages are linked by fixed-capacity ring FIFOs
+ * sized at configure time, so streaming does no allocation and no memmove.
+ *
+ * The official library is still available: https://codeberg.org/soundtouch/soundtouch
+ * (./setup_soundtouch.sh downloads it)
  */
 
 #include "SoundTouch.h"
@@ -16,57 +28,663 @@
 #include <algorithm>
 #include <cstring>
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SOUNDTOUCH_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOUNDTOUCH_SSE2 1
+#endif
+
 namespace soundtouch {
 
-// Internal implementation
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+
+// Ring sizing: largest block a caller is expected to push in one putSamples()
+// (the engine feeds at most 8192 frames), the fastest stretch it can reach, and
+// the most output it lets pile up between receiveSamples() calls. The stretcher
+// runs at tempo / pitch, so speed 10 at pitch -24 or lower consumes 40x. Slow tempos
+// multiply output (8192 frames at 0.05x is 160k), so the caller keeps each
+// block's output within kMaxOutputBlockFrames instead of the rings covering it.
+constexpr unsigned int kMaxBlockFrames = 8192;
+constexpr unsigned int kMaxOutputBlockFrames = 32768;
+constexpr float kMaxTempo = 10.0f;
+constexpr float kMinPitch = 0.25f;
+constexpr float kMaxStretchTempo = kMaxTempo / kMinPitch;
+constexpr float kMinTransposeRate = 0.25f;  // Pitch -24 semitones (x4 upsampling)
+
+// Dot product of two float vectors - the inner loop of the correlation search
+inline float dotProduct(const float* a, const float* b, int n) {
+    int i = 0;
+    float sum = 0.0f;
+#if SOUNDTOUCH_NEON
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+    float32x2_t half = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(half, half), 0);
+#elif SOUNDTOUCH_SSE2
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// Sum of squares over whole frames [first, first + count)
+inline double frameEnergy(const float* samples, int first, int count, int channels) {
+    double sum = 0.0;
+    const float* p = samples + first * channels;
+    for (int i = 0; i < count * channels; i++) {
+        sum += static_cast<double>(p[i]) * p[i];
+    }
+    return sum;
+}
+
+} // namespace
+
+// =============================================================================
+// FIFO SAMPLE BUFFER - Fixed-capacity ring shared by all pipeline stages
+//
+// Power-of-two ring (same read/write index scheme as Rubberband's RingBuffer)
+// with a mirrored second half: every frame written at index i is also stored
+// at i + capacity. Any run of up to `capacity` queued frames is therefore
+// contiguous from ptrBegin(), which the correlation search and the FIR need,
+// and reading never moves data.
+// =============================================================================
+
+class FIFOSampleBuffer {
+public:
+    void setChannels(unsigned int ch) {
+        channels = ch;
+        capacity = 0;
+        mask = 0;
+        storage.clear();
+        clear();
+    }
+
+    // Size the ring for at least numFrames queued frames. NOT real-time safe;
+    // only reallocates when growing, and keeps queued audio.
+    void reserve(unsigned int numFrames) {
+        if (numFrames <= capacity) return;
+
+        unsigned int newCapacity = 1;
+        while (newCapacity < numFrames) newCapacity <<= 1;
+
+        std::vector<float> newStorage(static_cast<size_t>(newCapacity) * 2 * channels, 0.0f);
+        if (count > 0) {
+            std::memcpy(newStorage.data(), ptrBegin(), count * channels * sizeof(float));
+            std::memcpy(newStorage.data() + static_cast<size_t>(newCapacity) * channels,
+                        newStorage.data(), count * channels * sizeof(float));
+        }
+
+        storage.swap(newStorage);
+        capacity = newCapacity;
+        mask = newCapacity - 1;
+        readIndex = 0;
+    }
+
+    unsigned int numSamples() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    unsigned int getCapacity() const { return capacity; }
+
+    float* ptrBegin() { return storage.data() + readIndex * channels; }
+    const float* ptrBegin() const { return storage.data() + readIndex * channels; }
+
+    // Room for numFrames at the end; commit them with putSamples(numFrames)
+    float* ptrEnd(unsigned int numFrames) {
+        ensureSpace(numFrames);
+        return storage.data() + writeIndex() * channels;
+    }
+
+    void putSamples(unsigned int numFrames) {
+        mirror(writeIndex(), numFrames);
+        count += numFrames;
+    }
+
+    void putSamples(const float* input, unsigned int numFrames) {
+        std::memcpy(ptrEnd(numFrames), input, numFrames * channels * sizeof(float));
+        putSamples(numFrames);
+    }
+
+    // Remove up to numFrames from the front, returns frames removed
+    unsigned int receiveSamples(unsigned int numFrames) {
+        unsigned int removed = std::min(numFrames, count);
+        readIndex = (readIndex + removed) & mask;
+        count -= removed;
+        return removed;
+    }
+
+    unsigned int receiveSamples(float* output, unsigned int numFrames) {
+        unsigned int removed = std::min(numFrames, count);
+        std::memcpy(output, ptrBegin(), removed * channels * sizeof(float));
+        return receiveSamples(removed);
+    }
+
+    // Drop frames from the end (used by flush to trim padding)
+    void truncate(unsigned int numFrames) {
+        count = std::min(count, numFrames);
+    }
+
+    void clear() {
+        readIndex = 0;
+        count = 0;
+    }
+
+private:
+    unsigned int writeIndex() const { return (readIndex + count) & mask; }
+
+    // Last-resort growth for blocks larger than the configured capacity
+    void ensureSpace(unsigned int numFrames) {
+        if (count + numFrames > capacity) {
+            reserve(std::max(count + numFrames, capacity * 2));
+        }
+    }
+
+    // Copy frames [first, first + numFrames) of the doubled storage to their twin half
+    void mirror(unsigned int first, unsigned int numFrames) {
+        size_t half = static_cast<size_t>(capacity) * channels;
+        float* base = storage.data();
+
+        unsigned int lowFrames = std::min(numFrames, capacity - first);
+        std::memcpy(base + half + first * channels, base + first * channels,
+                    lowFrames * channels * sizeof(float));
+
+        if (numFrames > lowFrames) {
+            unsigned int highFrames = numFrames - lowFrames;
+            std::memcpy(base, base + half, highFrames * channels * sizeof(float));
+        }
+    }
+
+    unsigned int channels = 2;
+    unsigned int capacity = 0;
+    unsigned int mask = 0;
+    unsigned int readIndex = 0;
+    unsigned int count = 0;
+    std::vector<float> storage;
+};
+
+// =============================================================================
+// WSOLA TIME STRETCH
+// =============================================================================
+
+class TDStretch {
+public:
+    void setParameters(unsigned int sampleRate, unsigned int ch, int sequenceMs,
+                       int seekWindowMs, int overlapMs, bool quickSeek) {
+        channels = ch;
+        this->quickSeek = quickSeek;
+
+        seekWindowLength = std::max(1, static_cast<int>(sequenceMs * sampleRate / 1000));
+        seekLength = std::max(1, static_cast<int>(seekWindowMs * sampleRate / 1000));
+        overlapLength = std::max(8, static_cast<int>(overlapMs * sampleRate / 1000));
+        overlapLength = std::min(overlapLength, seekWindowLength / 2);
+
+        midBuffer.assign(overlapLength * channels, 0.0f);
+        refMidBuffer.assign(overlapLength * channels, 0.0f);
+        energy.assign(seekLength, 0.0);
+
+        // Emphasise the middle of the overlap region when matching (as SoundTouch does)
+        overlapWeight.assign(overlapLength, 0.0f);
+        for (int i = 0; i < overlapLength; i++) {
+            overlapWeight[i] = static_cast<float>(i * (overlapLength - i)) /
+                               (0.25f * overlapLength * overlapLength);
+        }
+
+        setTempo(tempo);
+        clear();
+    }
+
+    void setTempo(float newTempo) {
+        tempo = newTempo;
+        nominalSkip = tempo * (seekWindowLength - overlapLength);
+        sampleReq = inputFramesFor(tempo);
+    }
+
+    // Input frames needed to run one WSOLA iteration at the given tempo
+    int inputFramesFor(float t) const {
+        int intSkip = static_cast<int>(t * (seekWindowLength - overlapLength) + 0.5f);
+        return std::max(intSkip + overlapLength, seekWindowLength) + seekLength;
+    }
+
+    int getSequenceLength() const { return seekWindowLength; }
+
+    // Input frames held back before the first output frame
+    int getLatency() const { return sampleReq; }
+
+    int getInputSequence() const { return static_cast<int>(nominalSkip + 0.5f); }
+    int getOutputSequence() const { return seekWindowLength - overlapLength; }
+
+    void clear() {
+        std::fill(midBuffer.begin(), midBuffer.end(), 0.0f);
+        skipFract = 0.0f;
+        isBeginning = true;
+    }
+
+    // Run one WSOLA iteration (one sequence of output) if enough input is
+    // queued. Returns false when it needs more input.
+    bool processSequence(FIFOSampleBuffer& input, FIFOSampleBuffer& output) {
+        if (static_cast<int>(input.numSamples()) < sampleReq) return false;
+
+        int offset = 0;
+
+        if (!isBeginning) {
+            // Find the best place to splice and cross-fade into it
+            offset = seekBestOverlapPosition(input.ptrBegin());
+            overlap(output.ptrEnd(overlapLength), input.ptrBegin(), offset);
+            output.putSamples(overlapLength);
+            offset += overlapLength;
+        } else {
+            // First sequence: no previous tail to match. Trim the initial skip so
+            // the output stays aligned with the input timeline.
+            isBeginning = false;
+            int skip = static_cast<int>(tempo * overlapLength + 0.5f * seekLength + 0.5f);
+            skipFract -= skip;
+            if (skipFract <= -nominalSkip) {
+                skipFract = -nominalSkip;
+            }
+        }
+
+        // Copy the sequence body straight through
+        int bodyLength = seekWindowLength - 2 * overlapLength;
+        const float* source = input.ptrBegin() + offset * channels;
+        output.putSamples(source, bodyLength);
+
+        // Keep the sequence tail for the next cross-fade
+        std::memcpy(midBuffer.data(), source + bodyLength * channels,
+                    overlapLength * channels * sizeof(float));
+
+        // Advance input by the nominal skip, carrying the fractional part
+        skipFract += nominalSkip;
+        int ovlSkip = static_cast<int>(skipFract);
+        skipFract -= ovlSkip;
+        input.receiveSamples(ovlSkip);
+
+        return true;
+    }
+
+private:
+    // Linear cross-fade from the stored tail into the new sequence
+    void overlap(float* output, const float* input, int offset) const {
+        const float* in = input + offset * channels;
+        float step = 1.0f / overlapLength;
+        for (int i = 0; i < overlapLength; i++) {
+            float fadeIn = i * step;
+            float fadeOut = 1.0f - fadeIn;
+            for (unsigned int ch = 0; ch < channels; ch++) {
+                int idx = i * channels + ch;
+                output[idx] = midBuffer[idx] * fadeOut + in[idx] * fadeIn;
+            }
+        }
+    }
+
+    // Normalized cross-correlation search over [0, seekLength)
+    int seekBestOverlapPosition(const float* input) {
+        int length = overlapLength * channels;
+
+        // Weighted reference tail
+        for (int i = 0; i < overlapLength; i++) {
+            for (unsigned int ch = 0; ch < channels; ch++) {
+                refMidBuffer[i * channels + ch] = midBuffer[i * channels + ch] * overlapWeight[i];
+            }
+        }
+
+        // Sliding-window energy of each candidate, updated incrementally
+        double norm = frameEnergy(input, 0, overlapLength, channels);
+        for (int offset = 0; offset < seekLength; offset++) {
+            energy[offset] = norm;
+            norm -= frameEnergy(input, offset, 1, channels);
+            norm += frameEnergy(input, offset + overlapLength, 1, channels);
+        }
+
+        auto correlation = [&](int offset) {
+            float corr = dotProduct(refMidBuffer.data(), input + offset * channels, length);
+            return corr / static_cast<float>(std::sqrt(std::max(energy[offset], 1e-9)));
+        };
+
+        int bestOffset = 0;
+        float bestCorr = -1e30f;
+
+        if (quickSeek) {
+            // Coarse scan, then refine around the winner
+            constexpr int kCoarseStep = 4;
+            for (int offset = 0; offset < seekLength; offset += kCoarseStep) {
+                float corr = correlation(offset);
+                if (corr > bestCorr) {
+                    bestCorr = corr;
+                    bestOffset = offset;
+                }
+            }
+            int center = bestOffset;
+            int first = std::max(0, center - kCoarseStep + 1);
+            int last = std::min(seekLength - 1, center + kCoarseStep - 1);
+            for (int offset = first; offset <= last; offset++) {
+                if (offset == center) continue;
+                float corr = correlation(offset);
+                if (corr > bestCorr) {
+                    bestCorr = corr;
+                    bestOffset = offset;
+                }
+            }
+        } else {
+            for (int offset = 0; offset < seekLength; offset++) {
+                float corr = correlation(offset);
+                if (corr > bestCorr) {
+                    bestCorr = corr;
+                    bestOffset = offset;
+                }
+            }
+        }
+
+        return bestOffset;
+    }
+
+    unsigned int channels = 2;
+    bool quickSeek = false;
+
+    float tempo = 1.0f;
+    float nominalSkip = 0.0f;
+    float skipFract = 0.0f;
+    bool isBeginning = true;
+
+    int seekWindowLength = 1764;
+    int seekLength = 661;
+    int overlapLength = 352;
+    int sampleReq = 0;
+
+    std::vector<float> midBuffer;
+    std::vector<float> refMidBuffer;
+    std::vector<float> overlapWeight;
+    std::vector<double> energy;
+};
+
+// =============================================================================
+// RATE TRANSPOSER - Linear interpolation with windowed-sinc anti-alias filters
+// =============================================================================
+
+class RateTransposer {
+public:
+    void setChannels(unsigned int ch) {
+        channels = ch;
+        lastFrame.assign(channels, 0.0f);
+        configureFilter();
+        clear();
+    }
+
+    // Called every sub-block while a pitch glide ramps: re-tunes both FIRs in place,
+    // keeping their history and the interpolation phase, so the stream stays continuous
+    void setRate(float newRate) {
+        if (newRate == rate) return;
+        rate = newRate;
+        if (useFilter) updateCoefficients();
+    }
+
+    void setFilter(bool enabled, int length) {
+        int newLength = std::max(8, length & ~7);
+        if (enabled == useFilter && newLength == filterLength && !window.empty()) return;
+        useFilter = enabled;
+        filterLength = newLength;
+        configureFilter();
+    }
+
+    // Only an unfiltered transposer can skip unity: with the filters on, rate 1 still
+    // runs them (cutoff near Nyquist), so a glide through unity keeps the same latency
+    bool isBypassed() const { return !useFilter && std::abs(rate - 1.0f) < 1e-6f; }
+
+    // Pre-size the FIR work buffers for blocks of up to numFrames
+    void reserve(unsigned int numFrames) {
+        size_t frames = numFrames + filterLength;
+        if (work.size() < frames * channels) work.resize(frames * channels);
+        if (plane.size() < frames) plane.resize(frames);
+        if (filtered.size() < frames * channels) filtered.resize(frames * channels);
+    }
+
+    // Output frames: half a filter on each side of the interpolator
+    int getLatency() const {
+        return useFilter ? static_cast<int>(filterLength / 2 * (1.0f + 1.0f / rate)) : 0;
+    }
+
+    void clear() {
+        fract = 0.0f;
+        std::fill(lastFrame.begin(), lastFrame.end(), 0.0f);
+        std::fill(antiAlias.history.begin(), antiAlias.history.end(), 0.0f);
+        std::fill(antiImage.history.begin(), antiImage.history.end(), 0.0f);
+        haveLastFrame = false;
+    }
+
+    void process(FIFOSampleBuffer& input, FIFOSampleBuffer& output) {
+        unsigned int numFrames = input.numSamples();
+        if (numFrames == 0) return;
+
+        if (isBypassed()) {
+            output.putSamples(input.ptrBegin(), numFrames);
+            input.receiveSamples(numFrames);
+            return;
+        }
+
+        const float* source = input.ptrBegin();
+
+        // Band-limit before interpolating (only bites when downsampling)
+        if (useFilter) {
+            filterBlock(antiAlias, source, numFrames, filtered);
+            source = filtered.data();
+        }
+
+        // Upper bound on produced frames for this block
+        unsigned int maxOut = static_cast<unsigned int>(numFrames / rate) + 2;
+        float* out = output.ptrEnd(maxOut);
+        unsigned int produced = interpolate(source, numFrames, out);
+
+        // Remove interpolation images afterwards (only bites when upsampling)
+        if (useFilter && produced > 0) {
+            filterBlock(antiImage, out, produced, filtered);
+            std::memcpy(out, filtered.data(), produced * channels * sizeof(float));
+        }
+
+        output.putSamples(produced);
+        input.receiveSamples(numFrames);
+    }
+
+private:
+    // One streaming FIR; history keeps the last (filterLength - 1) frames
+    struct FirStage {
+        std::vector<float> coefficients;
+        std::vector<float> history;
+    };
+
+    unsigned int interpolate(const float* src, unsigned int numFrames, float* out) {
+        unsigned int produced = 0;
+        unsigned int i = 0;
+
+        if (!haveLastFrame) {
+            for (unsigned int ch = 0; ch < channels; ch++) lastFrame[ch] = src[ch];
+            haveLastFrame = true;
+            i = 1;
+        }
+
+        for (; i < numFrames; i++) {
+            const float* current = src + i * channels;
+            while (fract < 1.0f) {
+                for (unsigned int ch = 0; ch < channels; ch++) {
+                    out[produced * channels + ch] =
+                        lastFrame[ch] + fract * (current[ch] - lastFrame[ch]);
+                }
+                produced++;
+                fract += rate;
+            }
+            fract -= 1.0f;
+            for (unsigned int ch = 0; ch < channels; ch++) lastFrame[ch] = current[ch];
+        }
+
+        return produced;
+    }
+
+    void filterBlock(FirStage& stage, const float* input, unsigned int numFrames,
+                     std::vector<float>& result) {
+        int historyFrames = filterLength - 1;
+        size_t total = (historyFrames + numFrames) * channels;
+        if (work.size() < total) work.resize(total);
+        if (result.size() < numFrames * channels) result.resize(numFrames * channels);
+
+        std::memcpy(work.data(), stage.history.data(), historyFrames * channels * sizeof(float));
+        std::memcpy(work.data() + historyFrames * channels, input, numFrames * channels * sizeof(float));
+
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            // Planar copy so the dot product runs on contiguous memory
+            if (plane.size() < historyFrames + numFrames) plane.resize(historyFrames + numFrames);
+            for (unsigned int i = 0; i < historyFrames + numFrames; i++) {
+                plane[i] = work[i * channels + ch];
+            }
+            for (unsigned int i = 0; i < numFrames; i++) {
+                result[i * channels + ch] = dotProduct(stage.coefficients.data(), plane.data() + i, filterLength);
+            }
+        }
+
+        std::memcpy(stage.history.data(), work.data() + numFrames * channels,
+                    historyFrames * channels * sizeof(float));
+    }
+
+    // Length or channel count changed: new window, histories sized and cleared
+    void configureFilter() {
+        for (FirStage* stage : {&antiAlias, &antiImage}) {
+            stage->history.assign((filterLength - 1) * channels, 0.0f);
+            stage->coefficients.assign(filterLength, 0.0f);
+        }
+        window.resize(filterLength);
+        for (int i = 0; i < filterLength; i++) {
+            window[i] = 0.54f - 0.46f * std::cos(2.0f * kPi * i / (filterLength - 1));
+        }
+        if (useFilter) updateCoefficients();
+    }
+
+    // Both stages always run while the filter is on. On the side of unity where a
+    // stage isn't needed its cutoff rests at 0.45 (transparent), so a glide through
+    // rate 1 slides the cutoffs instead of moving the filter across the interpolator.
+    // Written over the existing coefficients - this runs on the audio thread.
+    void updateCoefficients() {
+        designLowPass(antiAlias.coefficients, 0.5f * 0.9f / std::max(rate, 1.0f));
+        designLowPass(antiImage.coefficients, 0.5f * 0.9f * std::min(rate, 1.0f));
+    }
+
+    // Windowed sinc, cutoff in cycles per sample, unity gain at DC
+    void designLowPass(std::vector<float>& coefficients, float cutoff) const {
+        float center = (filterLength - 1) * 0.5f;
+        float sum = 0.0f;
+        for (int i = 0; i < filterLength; i++) {
+            float x = i - center;
+            float sinc = (std::abs(x) < 1e-6f) ? 2.0f * cutoff
+                                                : std::sin(2.0f * kPi * cutoff * x) / (kPi * x);
+            // Coefficients are stored reversed for the forward dot product
+            coefficients[filterLength - 1 - i] = sinc * window[i];
+            sum += sinc * window[i];
+        }
+        for (float& c : coefficients) c /= sum;
+    }
+
+    unsigned int channels = 2;
+    float rate = 1.0f;
+    float fract = 0.0f;
+    bool haveLastFrame = false;
+    std::vector<float> lastFrame;
+
+    bool useFilter = true;
+    int filterLength = 64;
+    std::vector<float> window;
+    FirStage antiAlias;  // Input side, for rate > 1
+    FirStage antiImage;  // Output side, for rate < 1
+    std::vector<float> work;
+    std::vector<float> plane;
+    std::vector<float> filtered;
+};
+
+// =============================================================================
+// SOUNDTOUCH IMPLEMENTATION
+// =============================================================================
+
 class SoundTouch::Impl {
 public:
     Impl() {
-        clear();
+        setChannels(channels);
+        updateParameters();
     }
-    
+
     void setSampleRate(unsigned int rate) {
         sampleRate = rate;
         updateParameters();
     }
-    
+
     void setChannels(unsigned int ch) {
-        channels = ch;
+        channels = std::max(1u, ch);
+        inputBuffer.setChannels(channels);
+        midBuffer.setChannels(channels);
+        outputBuffer.setChannels(channels);
+        transposer.setChannels(channels);
+        updateParameters();
     }
-    
+
     void setTempo(float t) {
-        tempo = std::clamp(t, 0.05f, 10.0f);
+        tempo = std::clamp(t, 0.05f, kMaxTempo);
+        updateRatios();
     }
-    
+
     void setPitch(float p) {
-        pitch = std::clamp(p, 0.25f, 4.0f);
+        pitch = std::clamp(p, kMinPitch, 4.0f);
+        updateRatios();
     }
-    
+
     void setPitchSemiTones(float semi) {
         // Convert semitones to ratio: 2^(semitones/12)
         pitch = std::pow(2.0f, semi / 12.0f);
-        pitch = std::clamp(pitch, 0.25f, 4.0f);
+        pitch = std::clamp(pitch, kMinPitch, 4.0f);
+        updateRatios();
     }
-    
+
     void setRate(float r) {
         rate = std::clamp(r, 0.05f, 10.0f);
+        updateRatios();
     }
-    
+
     bool setSetting(int id, int value) {
         switch (id) {
             case SETTING_USE_AA_FILTER:
                 useAAFilter = value != 0;
+                transposer.setFilter(useAAFilter, aaFilterLength);
+                reserveBuffers();
+                break;
+            case SETTING_AA_FILTER_LENGTH:
+                aaFilterLength = std::clamp(value, 8, 256);
+                transposer.setFilter(useAAFilter, aaFilterLength);
+                reserveBuffers();
+                break;
+            case SETTING_USE_QUICKSEEK:
+                useQuickSeek = value != 0;
+                updateParameters();
                 break;
             case SETTING_SEQUENCE_MS:
-                sequenceMs = value;
+                sequenceMs = std::max(1, value);
                 updateParameters();
                 break;
             case SETTING_SEEKWINDOW_MS:
-                seekWindowMs = value;
+                seekWindowMs = std::max(1, value);
                 updateParameters();
                 break;
             case SETTING_OVERLAP_MS:
-                overlapMs = value;
+                overlapMs = std::max(1, value);
                 updateParameters();
                 break;
             default:
@@ -74,180 +692,179 @@ public:
         }
         return true;
     }
-    
+
     int getSetting(int id) const {
         switch (id) {
             case SETTING_USE_AA_FILTER: return useAAFilter ? 1 : 0;
+            case SETTING_AA_FILTER_LENGTH: return aaFilterLength;
+            case SETTING_USE_QUICKSEEK: return useQuickSeek ? 1 : 0;
             case SETTING_SEQUENCE_MS: return sequenceMs;
             case SETTING_SEEKWINDOW_MS: return seekWindowMs;
             case SETTING_OVERLAP_MS: return overlapMs;
+            case SETTING_NOMINAL_INPUT_SEQUENCE: return stretch.getInputSequence();
+            case SETTING_NOMINAL_OUTPUT_SEQUENCE:
+                return static_cast<int>(stretch.getOutputSequence() / transposeRate + 0.5f);
+            case SETTING_INITIAL_LATENCY:
+                // Input frames buffered before the first output frame
+                return stretch.getLatency() + static_cast<int>(transposer.getLatency() * transposeRate);
             default: return 0;
         }
     }
-    
+
     void putSamples(const short* samples, unsigned int numFrames) {
         size_t numSamples = numFrames * channels;
-        size_t oldSize = inputBuffer.size();
-        inputBuffer.resize(oldSize + numSamples);
-        std::memcpy(inputBuffer.data() + oldSize, samples, numSamples * sizeof(short));
-        
-        // Process when we have enough samples
+        float* dest = inputBuffer.ptrEnd(numFrames);
+        for (size_t i = 0; i < numSamples; i++) {
+            dest[i] = samples[i] / 32768.0f;
+        }
+        inputBuffer.putSamples(numFrames);
+
+        expectedOutput += numFrames / (tempo * rate);
         processInternal();
     }
-    
+
     void putSamples(const float* samples, unsigned int numFrames) {
-        // Convert float to short
-        std::vector<short> shortSamples(numFrames * channels);
-        for (size_t i = 0; i < shortSamples.size(); i++) {
-            float s = samples[i] * 32767.0f;
-            shortSamples[i] = static_cast<short>(std::clamp(s, -32768.0f, 32767.0f));
-        }
-        putSamples(shortSamples.data(), numFrames);
+        // Float is the native sample type - no conversion
+        inputBuffer.putSamples(samples, numFrames);
+
+        expectedOutput += numFrames / (tempo * rate);
+        processInternal();
     }
-    
+
     unsigned int receiveSamples(short* output, unsigned int maxFrames) {
-        size_t maxSamples = maxFrames * channels;
-        size_t available = std::min(outputBuffer.size(), maxSamples);
-        
-        if (available > 0) {
-            std::memcpy(output, outputBuffer.data(), available * sizeof(short));
-            outputBuffer.erase(outputBuffer.begin(), outputBuffer.begin() + available);
+        unsigned int available = std::min(maxFrames, outputBuffer.numSamples());
+        const float* source = outputBuffer.ptrBegin();
+
+        for (size_t i = 0; i < available * channels; i++) {
+            float s = source[i] * 32767.0f;
+            output[i] = static_cast<short>(std::clamp(s, -32768.0f, 32767.0f));
         }
-        
-        return available / channels;
+        outputBuffer.receiveSamples(available);
+
+        samplesOutput += available;
+        return available;
     }
-    
+
     unsigned int receiveSamples(float* output, unsigned int maxFrames) {
-        std::vector<short> shortOutput(maxFrames * channels);
-        unsigned int received = receiveSamples(shortOutput.data(), maxFrames);
-        
-        for (size_t i = 0; i < received * channels; i++) {
-            output[i] = shortOutput[i] / 32768.0f;
-        }
-        
+        unsigned int received = outputBuffer.receiveSamples(output, maxFrames);
+        samplesOutput += received;
         return received;
     }
-    
+
     unsigned int numSamples() const {
-        return outputBuffer.size() / channels;
+        return outputBuffer.numSamples();
     }
-    
+
     unsigned int numUnprocessedSamples() const {
-        return inputBuffer.size() / channels;
+        return inputBuffer.numSamples() + midBuffer.numSamples();
     }
-    
+
     int isEmpty() const {
-        return outputBuffer.empty() ? 1 : 0;
+        return outputBuffer.isEmpty() ? 1 : 0;
     }
-    
+
     void flush() {
-        // Process any remaining samples
-        if (!inputBuffer.empty()) {
+        // Push the tail out with silence, then trim to the expected length
+        long stillExpected = static_cast<long>(expectedOutput + 0.5) - static_cast<long>(samplesOutput);
+        if (stillExpected <= 0) return;
+
+        constexpr unsigned int kSilenceFrames = 128;
+        float silence[kSilenceFrames * 8] = {};
+        unsigned int silenceFrames = kSilenceFrames * 8 / channels;
+
+        for (int i = 0; i < 200 && static_cast<long>(outputBuffer.numSamples()) < stillExpected; i++) {
+            inputBuffer.putSamples(silence, silenceFrames);
             processInternal();
         }
+        outputBuffer.truncate(static_cast<unsigned int>(stillExpected));
+
+        // Silence padding is not real input
+        inputBuffer.clear();
+        midBuffer.clear();
+        stretch.clear();
+        transposer.clear();
+        expectedOutput = static_cast<double>(samplesOutput + outputBuffer.numSamples());
     }
-    
+
     void clear() {
         inputBuffer.clear();
+        midBuffer.clear();
         outputBuffer.clear();
-        position = 0;
+        stretch.clear();
+        transposer.clear();
+        expectedOutput = 0.0;
+        samplesOutput = 0;
     }
-    
+
 private:
     void updateParameters() {
-        sequenceSamples = (sequenceMs * sampleRate) / 1000;
-        seekWindowSamples = (seekWindowMs * sampleRate) / 1000;
-        overlapSamples = (overlapMs * sampleRate) / 1000;
+        stretch.setParameters(sampleRate, channels, sequenceMs, seekWindowMs, overlapMs, useQuickSeek);
+        transposer.setFilter(useAAFilter, aaFilterLength);
+        updateRatios();
+        reserveBuffers();
+    }
+
+    // Size every FIFO up front, so steady-state streaming never allocates at any
+    // tempo. Rings only ever grow.
+    void reserveBuffers() {
+        unsigned int inputFrames = stretch.inputFramesFor(kMaxStretchTempo) + kMaxBlockFrames;
+        inputBuffer.reserve(inputFrames);
+
+        // midBuffer is resampled after every sequence (processInternal), so it
+        // only ever holds about one sequence, whatever the tempo
+        unsigned int sequenceFrames = static_cast<unsigned int>(stretch.getSequenceLength());
+        unsigned int stageFrames = std::max(sampleRate, kMaxBlockFrames * 2) + sequenceFrames;
+        midBuffer.reserve(stageFrames);
+        transposer.reserve(stageFrames);
+
+        // Output: a block's worth, plus the sequence that may overshoot it at the
+        // lowest pitch, plus a block left undrained by a short caller buffer
+        unsigned int sequenceOut = static_cast<unsigned int>(sequenceFrames / kMinTransposeRate) + 2;
+        outputBuffer.reserve(std::max(stageFrames, kMaxOutputBlockFrames * 2 + sequenceOut));
+    }
+
+    void updateRatios() {
+        // Stretch handles tempo/pitch, transposer handles pitch*rate (same split as SoundTouch)
+        stretchTempo = tempo / pitch;
+        transposeRate = pitch * rate;
+        stretch.setTempo(stretchTempo);
+        transposer.setRate(transposeRate);
     }
-    
+
     void processInternal() {
-        // Simplified WSOLA algorithm
-        // For full quality, use the real SoundTouch library
-        
-        float effectiveTempo = tempo * rate;
-        if (effectiveTempo < 0.05f) effectiveTempo = 0.05f;
-        if (effectiveTempo > 10.0f) effectiveTempo = 10.0f;
-        
-        size_t inputFrames = inputBuffer.size() / channels;
-        if (inputFrames < sequenceSamples) return;
-        
-        // Calculate output size
-        size_t outputFrames = static_cast<size_t>(inputFrames / effectiveTempo);
-        if (outputFrames == 0) return;
-        
-        std::vector<short> processed(outputFrames * channels);
-        
-        // Simple linear interpolation for time-stretching
-        for (size_t outFrame = 0; outFrame < outputFrames; outFrame++) {
-            float inPos = outFrame * effectiveTempo;
-            size_t inFrame = static_cast<size_t>(inPos);
-            float frac = inPos - inFrame;
-            
-            if (inFrame >= inputFrames - 1) {
-                inFrame = inputFrames - 2;
-                frac = 1.0f;
-            }
-            
-            for (unsigned int ch = 0; ch < channels; ch++) {
-                float s1 = inputBuffer[inFrame * channels + ch];
-                float s2 = inputBuffer[(inFrame + 1) * channels + ch];
-                processed[outFrame * channels + ch] = 
-                    static_cast<short>(s1 + frac * (s2 - s1));
-            }
+        // WSOLA first, then resample the stretched audio to its final pitch -
+        // a sequence at a time, so slow tempos never pile up stretched audio
+        while (stretch.processSequence(inputBuffer, midBuffer)) {
+            transposer.process(midBuffer, outputBuffer);
         }
-        
-        // Apply pitch shift using simple resampling
-        if (std::abs(pitch - 1.0f) > 0.01f) {
-            size_t pitchedFrames = static_cast<size_t>(outputFrames / pitch);
-            std::vector<short> pitched(pitchedFrames * channels);
-            
-            for (size_t outFrame = 0; outFrame < pitchedFrames; outFrame++) {
-                float inPos = outFrame * pitch;
-                size_t inFrame = static_cast<size_t>(inPos);
-                float frac = inPos - inFrame;
-                
-                if (inFrame >= outputFrames - 1) {
-                    inFrame = outputFrames - 2;
-                    frac = 1.0f;
-                }
-                
-                for (unsigned int ch = 0; ch < channels; ch++) {
-                    float s1 = processed[inFrame * channels + ch];
-                    float s2 = processed[(inFrame + 1) * channels + ch];
-                    pitched[outFrame * channels + ch] = 
-                        static_cast<short>(s1 + frac * (s2 - s1));
-                }
-            }
-            
-            processed = std::move(pitched);
-        }
-        
-        // Append to output buffer
-        outputBuffer.insert(outputBuffer.end(), processed.begin(), processed.end());
-        
-        // Clear processed input
-        inputBuffer.clear();
     }
-    
+
     unsigned int sampleRate = 44100;
     unsigned int channels = 2;
-    
+
     float tempo = 1.0f;
     float pitch = 1.0f;
     float rate = 1.0f;
-    
+    float stretchTempo = 1.0f;
+    float transposeRate = 1.0f;
+
     bool useAAFilter = true;
+    int aaFilterLength = 64;
+    bool useQuickSeek = false;
     int sequenceMs = 40;
     int seekWindowMs = 15;
     int overlapMs = 8;
-    
-    int sequenceSamples = 1764;
-    int seekWindowSamples = 661;
-    int overlapSamples = 352;
-    
-    std::vector<short> inputBuffer;
-    std::vector<short> outputBuffer;
-    size_t position = 0;
+
+    // Float samples internally (SOUNDTOUCH_FLOAT_SAMPLES), int16 only at the API edge
+    FIFOSampleBuffer inputBuffer;
+    FIFOSampleBuffer midBuffer;
+    FIFOSampleBuffer outputBuffer;
+    TDStretch stretch;
+    RateTransposer transposer;
+
+    // Flush bookkeeping (frames)
+    double expectedOutput = 0.0;
+    unsigned long samplesOutput = 0;
 };
 
 // SoundTouch class implementation
@@ -257,7 +874,7 @@ SoundTouch::SoundTouch() : pImpl(new Impl()) {}
 SoundTouch::~SoundTouch() { delete pImpl; }
 
 const char* SoundTouch::getVersionString() {
-    return "UltraMusic SoundTouch Stub 1.0";
+    return "UltraMusic SoundTouch WSOLA 2.0";
 }
 
 unsigned int SoundTouch::getVersionId() {
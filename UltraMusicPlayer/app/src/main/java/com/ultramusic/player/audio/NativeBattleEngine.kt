@@ -27,6 +27,37 @@ enum class AudioEngineType(val value: Int, val displayName: String, val quality:
     }
 }
 
+/**
+ * Output dither used by audiophile mode on the 16-bit output
+ *
+ * - NONE:         Round to nearest only
+ * - TPDF:         Flat triangular dither (+-1 LSB)
+ * - NOISE_SHAPED: Triangular dither with error feedback, noise pushed toward the highs (default)
+ */
+enum class DitherMode(val value: Int, val displayName: String) {
+    NONE(0, "Off"),
+    TPDF(1, "TPDF"),
+    NOISE_SHAPED(2, "Noise Shaped");
+
+    companion object {
+        fun fromValue(value: Int): DitherMode = entries.find { it.value == value } ?: NOISE_SHAPED
+    }
+}
+
+/**
+ * One track for [NativeBattleEngine.renderBatch]
+ *
+ * [settings] supplies the chain settings (several jobs may share one engine);
+ * speed and pitch are the job's own.
+ */
+data class RenderJob(
+    val settings: NativeBattleEngine,
+    val inputPath: String,
+    val outputPath: String,
+    val speed: Float = 1.0f,
+    val pitchSemitones: Float = 0.0f
+)
+
 /**
  * NATIVE BATTLE ENGINE v2.0
  *
@@ -81,6 +112,87 @@ class NativeBattleEngine @Inject constructor() {
         }
 
         fun isAvailable(): Boolean = isNativeLoaded
+
+        /**
+         * Mix several engines (decks, samplers) into one float output in a single
+         * native call instead of one round trip per engine.
+         *
+         * Each deck consumes inputSamples[i] samples of inputs[i] and is summed
+         * with gains[i]. All decks must share the first deck's channel count.
+         * Up to 8 decks per call.
+         *
+         * Returns: Number of output samples written
+         */
+        fun mix(
+            decks: Array<NativeBattleEngine>,
+            inputs: Array<FloatArray>,
+            inputSamples: IntArray,
+            gains: FloatArray,
+            output: FloatArray
+        ): Int {
+            if (!isNativeLoaded || decks.isEmpty()) return 0
+            val handles = LongArray(decks.size) { decks[it].nativeHandle }
+            if (handles.any { it == 0L }) return 0
+
+            return nativeMix(handles, inputs, inputSamples, gains, output)
+        }
+
+        /**
+         * Pre-render a whole playlist: every job is rendered file to file like
+         * [renderFile], with the jobs spread over a work-stealing pool (one worker
+         * per big core unless [threads] > 0).
+         *
+         * Each job uses the chain settings of its [RenderJob.settings] engine
+         * (battle mode, EQ, bass, dynamics, protection, dither) at the job's own
+         * speed and pitch. Blocks until every job is done - call it from a
+         * background dispatcher.
+         *
+         * Returns: Frames written per job (-1 for a job that failed)
+         */
+        fun renderBatch(
+            jobs: List<RenderJob>,
+            floatOutput: Boolean = false,
+            threads: Int = 0
+        ): LongArray {
+            val framesWritten = LongArray(jobs.size) { -1L }
+            if (!isNativeLoaded || jobs.isEmpty()) return framesWritten
+            val handles = LongArray(jobs.size) { jobs[it].settings.nativeHandle }
+            if (handles.any { it == 0L }) return framesWritten
+
+            val succeeded = nativeRenderBatch(
+                handles,
+                Array(jobs.size) { jobs[it].inputPath },
+                Array(jobs.size) { jobs[it].outputPath },
+                FloatArray(jobs.size) { jobs[it].speed },
+                FloatArray(jobs.size) { jobs[it].pitchSemitones },
+                floatOutput,
+                threads,
+                framesWritten
+            )
+            Log.i(TAG, "Batch render: $succeeded/${jobs.size} tracks")
+            return framesWritten
+        }
+
+        @JvmStatic
+        private external fun nativeRenderBatch(
+            settings: LongArray,
+            inputPaths: Array<String>,
+            outputPaths: Array<String>,
+            speeds: FloatArray,
+            pitches: FloatArray,
+            floatOutput: Boolean,
+            threads: Int,
+            framesWritten: LongArray
+        ): Int
+
+        @JvmStatic
+        private external fun nativeMix(
+            handles: LongArray,
+            inputs: Array<FloatArray>,
+            inputSamples: IntArray,
+            gains: FloatArray,
+            output: FloatArray
+        ): Int
     }
     
     // Native handle
@@ -102,6 +214,12 @@ class NativeBattleEngine @Inject constructor() {
     // Buffers
     private var inputBuffer = ShortArray(0)
     private var outputBuffer = ShortArray(0)
+    private var floatOutputBuffer = FloatArray(0)
+
+    // Zero-copy direct buffers (registered with the native engine once per configure)
+    private var directInputBuffer: ByteBuffer? = null
+    private var directOutputBuffer: ByteBuffer? = null
+    private var directFloatSamples = false
     
     /**
      * Initialize the engine
@@ -137,6 +255,10 @@ class NativeBattleEngine @Inject constructor() {
             val bufferSize = sampleRate * channels * 2  // Extra space for slow speeds
             inputBuffer = ShortArray(bufferSize)
             outputBuffer = ShortArray(bufferSize * 4)  // 4x for extreme slow speeds
+            floatOutputBuffer = FloatArray(bufferSize * 4)
+            
+            // Register direct buffers once - process calls then share memory with native
+            attachDirectBuffers(directFloatSamples)
             
             isInitialized = true
             Log.i(TAG, "Initialized: ${sampleRate}Hz, ${channels}ch")
@@ -249,6 +371,70 @@ class NativeBattleEngine @Inject constructor() {
         Log.d(TAG, "Exciter: $amount")
     }
 
+    /**
+     * Set mega bass intensity (0.0-1.0)
+     * Sub-harmonics and exciter together on every channel (battle mode)
+     * Runs ahead of the compressor and limiter, so they still catch it
+     */
+    fun setMegaBassIntensity(intensity: Float) {
+        if (nativeHandle != 0L) {
+            nativeSetMegaBass(nativeHandle, intensity.coerceIn(0f, 1f))
+        }
+        Log.d(TAG, "Mega bass: $intensity")
+    }
+
+    /**
+     * Set parallel (New York) compression mix (0.0-1.0)
+     * Blends a heavily compressed copy under the dry signal for punch (battle mode)
+     * Off in audiophile mode, like the main compressor
+     */
+    fun setParallelCompressionMix(mix: Float) {
+        if (nativeHandle != 0L) {
+            nativeSetParallelCompression(nativeHandle, mix.coerceIn(0f, 1f))
+        }
+        Log.d(TAG, "Parallel compression: $mix")
+    }
+
+    // ==================== 10-BAND EQ (BATTLE MODE) ====================
+
+    private var eqEnabled: Boolean = true
+    private val eqBandGainsDb = FloatArray(10)
+
+    /**
+     * Enable/disable the 10-band EQ (battle mode only)
+     * A flat EQ costs nothing, so it can stay enabled
+     */
+    fun setEqEnabled(enabled: Boolean) {
+        eqEnabled = enabled
+
+        if (nativeHandle != 0L) {
+            nativeSetEqEnabled(nativeHandle, enabled)
+        }
+
+        Log.i(TAG, "EQ: ${if (enabled) "ON" else "OFF"}")
+    }
+
+    fun isEqEnabled(): Boolean = eqEnabled
+
+    /**
+     * Set one EQ band's gain (-12 to +12 dB)
+     *
+     * Bands: 31, 62, 125, 250, 500, 1k, 2k, 4k, 8k, 16k Hz
+     * (31 Hz and 16 kHz are shelves, the rest one-octave peaks)
+     */
+    fun setEqBandGain(band: Int, gainDb: Float) {
+        if (band !in eqBandGainsDb.indices) return
+        eqBandGainsDb[band] = gainDb.coerceIn(-12f, 12f)
+
+        if (nativeHandle != 0L) {
+            nativeSetEqBand(nativeHandle, band, eqBandGainsDb[band])
+        }
+
+        Log.d(TAG, "EQ band $band: ${eqBandGainsDb[band]} dB")
+    }
+
+    fun getEqBandGain(band: Int): Float = eqBandGainsDb.getOrElse(band) { 0f }
+
     /**
      * Process audio samples
      * Input: PCM 16-bit samples
@@ -267,6 +453,72 @@ class NativeBattleEngine @Inject constructor() {
         return Pair(outputBuffer.copyOf(outputSamples), outputSamples)
     }
     
+    /**
+     * Process float audio samples (-1.0 to 1.0, interleaved)
+     * Stays float end-to-end: no int16 round trip or quantization inside the engine.
+     *
+     * Returns: Number of output samples
+     */
+    fun processFloat(input: FloatArray, numSamples: Int): Pair<FloatArray, Int> {
+        if (!isInitialized || nativeHandle == 0L) {
+            return Pair(input, numSamples)
+        }
+
+        val outputSamples = nativeProcessFloat(nativeHandle, input, numSamples, floatOutputBuffer)
+
+        return Pair(floatOutputBuffer.copyOf(outputSamples), outputSamples)
+    }
+
+    /**
+     * Allocate and register the zero-copy direct buffers.
+     * Sized like the array buffers: 1 second in, 4x that out (extreme slow speeds).
+     */
+    fun attachDirectBuffers(floatSamples: Boolean): Boolean {
+        if (nativeHandle == 0L) return false
+
+        val bytesPerSample = if (floatSamples) 4 else 2
+        val bufferSamples = sampleRate * channels * 2
+        val input = ByteBuffer.allocateDirect(bufferSamples * bytesPerSample).order(ByteOrder.nativeOrder())
+        val output = ByteBuffer.allocateDirect(bufferSamples * 4 * bytesPerSample).order(ByteOrder.nativeOrder())
+
+        if (!nativeSetDirectBuffers(nativeHandle, input, output, floatSamples)) {
+            Log.e(TAG, "Failed to register direct buffers")
+            directInputBuffer = null
+            directOutputBuffer = null
+            return false
+        }
+
+        directInputBuffer = input
+        directOutputBuffer = output
+        directFloatSamples = floatSamples
+        return true
+    }
+
+    /**
+     * Direct input buffer: write samples at position 0, then call processDirect()
+     */
+    fun getDirectInputBuffer(): ByteBuffer? = directInputBuffer
+
+    /**
+     * Direct output buffer: holds processDirect() results from position 0
+     */
+    fun getDirectOutputBuffer(): ByteBuffer? = directOutputBuffer
+
+    fun isDirectFloat(): Boolean = directFloatSamples
+
+    /**
+     * Zero-copy processing: numSamples from the direct input buffer into the direct
+     * output buffer. No array pinning, copies or garbage per block.
+     *
+     * Returns: Number of output samples
+     */
+    fun processDirect(numSamples: Int): Int {
+        if (!isInitialized || nativeHandle == 0L || directInputBuffer == null) {
+            return 0
+        }
+        return nativeProcessDirect(nativeHandle, numSamples)
+    }
+
     /**
      * Process using SoundTouch only (simpler, for just speed/pitch)
      */
@@ -321,6 +573,8 @@ class NativeBattleEngine @Inject constructor() {
             nativeDestroy(nativeHandle)
             nativeHandle = 0
         }
+        directInputBuffer = null
+        directOutputBuffer = null
         if (soundTouchHandle != 0L) {
             soundTouchDestroy(soundTouchHandle)
             soundTouchHandle = 0
@@ -432,6 +686,26 @@ class NativeBattleEngine @Inject constructor() {
 
     fun isAudiophileModeEnabled(): Boolean = audiophileModeEnabled
 
+    private var ditherMode: DitherMode = DitherMode.NOISE_SHAPED
+
+    /**
+     * Select the dither applied to the 16-bit output while audiophile mode is on
+     *
+     * Noise-shaped dither keeps the same +-1 LSB level as TPDF but moves
+     * the noise toward the highs, where it is least audible.
+     */
+    fun setDitherMode(mode: DitherMode) {
+        ditherMode = mode
+
+        if (nativeHandle != 0L) {
+            nativeSetDitherMode(nativeHandle, mode.value)
+        }
+
+        Log.i(TAG, "Dither: ${mode.displayName}")
+    }
+
+    fun getDitherMode(): DitherMode = ditherMode
+
     // ==================== AUDIO ENGINE SELECTION ====================
 
     private var currentEngine: AudioEngineType = AudioEngineType.SOUNDTOUCH
@@ -453,6 +727,109 @@ class NativeBattleEngine @Inject constructor() {
         Log.i(TAG, "Audio Engine set to: ${engine.displayName} (${engine.quality})")
     }
 
+    private var engineCrossfadeMs: Float = 50f
+
+    /**
+     * Set how engine switches are handled
+     *
+     * > 0: The new engine is pre-rolled on recent audio and crossfaded in over
+     *      this many milliseconds - no gap, safe to A/B engines live
+     * 0:   Hard cut - all buffers are cleared on switch (brief dropout)
+     */
+    fun setEngineCrossfadeMs(milliseconds: Float) {
+        engineCrossfadeMs = milliseconds.coerceIn(0f, 1000f)
+
+        if (nativeHandle != 0L) {
+            nativeSetEngineCrossfade(nativeHandle, engineCrossfadeMs)
+        }
+
+        Log.i(TAG, "Engine crossfade: ${engineCrossfadeMs}ms")
+    }
+
+    fun getEngineCrossfadeMs(): Float = engineCrossfadeMs
+
+    private val truePeakBuffer = FloatArray(8)
+
+    /**
+     * Read the output true-peak meter
+     *
+     * Per-channel peak in dBTP (4x oversampled, catches inter-sample overs)
+     * since the previous call - poll it from the UI to drive a peak meter.
+     */
+    fun readTruePeaksDb(): FloatArray {
+        if (nativeHandle == 0L) return FloatArray(0)
+        val channels = nativeReadTruePeaks(nativeHandle, truePeakBuffer)
+        return truePeakBuffer.copyOf(channels)
+    }
+
+    // ==================== LATENCY ====================
+
+    /**
+     * How far the engine's output trails its input, in output frames
+     *
+     * The running engine's delay (SoundTouch, Rubberband start delay,
+     * Superpowered backlog) plus the battle chain's (limiter lookahead).
+     * Follows speed and engine changes - poll it to line up visuals and decks.
+     */
+    fun getLatencyFrames(): Int {
+        if (nativeHandle == 0L) return 0
+        return nativeGetLatencyFrames(nativeHandle)
+    }
+
+    fun getLatencyMs(): Float = getLatencyFrames() * 1000f / sampleRate
+
+    private var latencyCompensation: Boolean = false
+
+    /**
+     * Trim the start delay so output is sample-aligned with input
+     *
+     * ON:  At every start (initialize, clear, hard engine cut) the frames that
+     *      are only delay are dropped - output frame n is track frame n at the
+     *      current speed, so frames played can be used as the track position
+     * OFF: Output starts with the engines' delay in front of it (default)
+     *
+     * Takes effect from the next start. The delay itself does not go away.
+     */
+    fun setLatencyCompensation(enabled: Boolean) {
+        latencyCompensation = enabled
+
+        if (nativeHandle != 0L) {
+            nativeSetLatencyCompensation(nativeHandle, enabled)
+        }
+
+        Log.i(TAG, "Latency compensation: ${if (enabled) "ON" else "OFF"}")
+    }
+
+    fun isLatencyCompensationEnabled(): Boolean = latencyCompensation
+
+    // ==================== OFFLINE EXPORT ====================
+
+    /**
+     * Render a whole WAV file with the current settings, faster than real time
+     *
+     * Speed, pitch/rate, the battle chain and speaker protection are applied
+     * exactly as in playback. Rubberband (when built in) runs in its offline,
+     * two-pass mode for the best stretch quality; the chain is spread across
+     * worker threads. Live playback is not affected.
+     *
+     * Blocks until the file is written - call it from a background dispatcher.
+     *
+     * @param inputPath PCM 16/24-bit or float WAV
+     * @param outputPath WAV to write (16-bit, dithered if enabled; or float)
+     * @return Frames written, or -1 on error
+     */
+    fun renderFile(inputPath: String, outputPath: String, floatOutput: Boolean = false): Long {
+        if (nativeHandle == 0L) return -1L
+
+        val frames = nativeRenderFile(nativeHandle, inputPath, outputPath, floatOutput)
+        if (frames < 0) {
+            Log.e(TAG, "Render failed: $inputPath -> $outputPath")
+        } else {
+            Log.i(TAG, "Rendered $frames frames to $outputPath")
+        }
+        return frames
+    }
+
     /**
      * Get current audio engine
      */
@@ -482,14 +859,27 @@ class NativeBattleEngine @Inject constructor() {
     private external fun nativeSetRate(handle: Long, rate: Float)
     private external fun nativeSetBattleMode(handle: Long, enabled: Boolean)
     private external fun nativeSetBassBoost(handle: Long, amount: Float)
+    private external fun nativeSetEqEnabled(handle: Long, enabled: Boolean)
+    private external fun nativeSetEqBand(handle: Long, band: Int, gainDb: Float)
     private external fun nativeSetSubHarmonic(handle: Long, amount: Float)
     private external fun nativeSetExciter(handle: Long, amount: Float)
+    private external fun nativeSetMegaBass(handle: Long, intensity: Float)
+    private external fun nativeSetParallelCompression(handle: Long, mix: Float)
     private external fun nativeSetLimiterEnabled(handle: Long, enabled: Boolean)
     private external fun nativeSetHardwareProtection(handle: Long, enabled: Boolean)
     private external fun nativeSetAudiophileMode(handle: Long, enabled: Boolean)
+    private external fun nativeSetDitherMode(handle: Long, mode: Int)
     private external fun nativeSetAudioEngine(handle: Long, engineType: Int)
     private external fun nativeGetAudioEngine(handle: Long): Int
+    private external fun nativeSetEngineCrossfade(handle: Long, milliseconds: Float)
+    private external fun nativeReadTruePeaks(handle: Long, peaksDb: FloatArray): Int
+    private external fun nativeGetLatencyFrames(handle: Long): Int
+    private external fun nativeSetLatencyCompensation(handle: Long, enabled: Boolean)
     private external fun nativeProcess(handle: Long, input: ShortArray, numSamples: Int, output: ShortArray): Int
+    private external fun nativeProcessFloat(handle: Long, input: FloatArray, numSamples: Int, output: FloatArray): Int
+    private external fun nativeRenderFile(handle: Long, inputPath: String, outputPath: String, floatOutput: Boolean): Long
+    private external fun nativeSetDirectBuffers(handle: Long, input: ByteBuffer, output: ByteBuffer, floatSamples: Boolean): Boolean
+    private external fun nativeProcessDirect(handle: Long, numSamples: Int): Int
     private external fun nativeFlush(handle: Long)
     private external fun nativeClear(handle: Long)
     
@@ -526,8 +916,10 @@ class BattleAudioProcessor(
     private var inputEnded = false
     
     private var isActive = false
+    private var isFloatInput = false
     private var tempInputShorts = ShortArray(0)
     private var tempOutputShorts = ShortArray(0)
+    private var tempInputFloats = FloatArray(0)
     
     fun setSpeed(speed: Float) {
         engine.setSpeed(speed)
@@ -544,14 +936,19 @@ class BattleAudioProcessor(
     }
     
     override fun configure(inputAudioFormat: AudioFormat): AudioFormat {
-        if (inputAudioFormat.encoding != C.ENCODING_PCM_16BIT) {
+        if (inputAudioFormat.encoding != C.ENCODING_PCM_16BIT &&
+            inputAudioFormat.encoding != C.ENCODING_PCM_FLOAT) {
             return AudioFormat.NOT_SET
         }
         
         inputFormat = inputAudioFormat
+        isFloatInput = inputAudioFormat.encoding == C.ENCODING_PCM_FLOAT
         
         // Initialize engine with format
         engine.initialize(inputAudioFormat.sampleRate, inputAudioFormat.channelCount)
+        if (engine.isDirectFloat() != isFloatInput) {
+            engine.attachDirectBuffers(isFloatInput)
+        }
         
         outputFormat = inputAudioFormat
         return outputFormat
@@ -565,6 +962,15 @@ class BattleAudioProcessor(
             return
         }
         
+        if (queueDirectInput(buffer)) {
+            return
+        }
+
+        if (isFloatInput) {
+            queueFloatInput(buffer)
+            return
+        }
+
         // Convert bytes to shorts
         val shortBuffer = buffer.order(ByteOrder.LITTLE_ENDIAN).asShortBuffer()
         val numShorts = shortBuffer.remaining()
@@ -592,6 +998,59 @@ class BattleAudioProcessor(
         buffer.position(buffer.limit())
     }
     
+    /**
+     * Zero-copy path: one bulk copy into the engine's direct buffer, output is read
+     * in place from the engine's direct output buffer. Returns false if the block
+     * does not fit, so the caller falls back to the array path.
+     */
+    private fun queueDirectInput(buffer: ByteBuffer): Boolean {
+        val directIn = engine.getDirectInputBuffer() ?: return false
+        val directOut = engine.getDirectOutputBuffer() ?: return false
+        val bytesPerSample = if (isFloatInput) 4 else 2
+        val numBytes = buffer.remaining()
+        if (numBytes > directIn.capacity()) return false
+
+        directIn.clear()
+        directIn.put(buffer.order(ByteOrder.nativeOrder()))
+
+        val outputCount = engine.processDirect(numBytes / bytesPerSample)
+
+        outputBuffer = if (outputCount > 0) {
+            directOut.clear()
+            directOut.limit(outputCount * bytesPerSample)
+            directOut.slice().order(ByteOrder.nativeOrder())
+        } else {
+            EMPTY_BUFFER
+        }
+
+        return true
+    }
+
+    /**
+     * Float PCM path: decoder float goes through the engine without int16 quantization
+     */
+    private fun queueFloatInput(buffer: ByteBuffer) {
+        val floatBuffer = buffer.order(ByteOrder.nativeOrder()).asFloatBuffer()
+        val numFloats = floatBuffer.remaining()
+
+        if (tempInputFloats.size < numFloats) {
+            tempInputFloats = FloatArray(numFloats)
+        }
+        floatBuffer.get(tempInputFloats, 0, numFloats)
+
+        val (processed, outputCount) = engine.processFloat(tempInputFloats, numFloats)
+
+        outputBuffer = if (outputCount > 0) {
+            val out = ByteBuffer.allocateDirect(outputCount * 4).order(ByteOrder.nativeOrder())
+            out.asFloatBuffer().put(processed, 0, outputCount)
+            out
+        } else {
+            EMPTY_BUFFER
+        }
+
+        buffer.position(buffer.limit())
+    }
+
     override fun queueEndOfStream() {
         inputEnded = true
         engine.flush()